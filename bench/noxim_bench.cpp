@@ -0,0 +1,698 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * Simulator-performance benchmark suite.
+ *
+ * Usage: noxim_bench [-micro] [-e2e] [-link] [-elab] [-noxim PATH]
+ *                    [-configs DIR] [-power FILE] [-sim N] [-iters N]
+ *                    [-ports N]
+ *
+ *  -micro / -e2e / -link / -elab
+ *                  run only the selected groups: microbenchmarks,
+ *                  end-to-end runs, link throughput vs buffer_depth,
+ *                  link_latency and link width, elaboration of a
+ *                  1-16-1024-102400 tree
+ *                  (default: all)
+ *  -noxim PATH     simulator binary for the end-to-end runs
+ *                  (default: "noxim" next to this binary)
+ *  -configs DIR    directory holding the example configurations
+ *                  (default: config_examples of the source tree)
+ *  -power FILE     power configuration passed to noxim (-power) and
+ *                  loaded by the elaboration benchmark
+ *  -sim N          override simulation_time of the end-to-end runs and
+ *                  the measured cycles of the link benchmark (default 10000)
+ *  -iters N        iterations of each microbenchmark (default 1000000)
+ *  -ports N        synthetic fanout of the Router::txProcess benchmark
+ *
+ * Every result is printed as one JSON object per line on stdout, so the
+ * output can be appended to a file and diffed between versions.
+ */
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <systemc.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../src/Buffer.h"
+#include "../src/ConfigurationManager.h"
+#include "../src/GlobalParams.h"
+#include "../src/GlobalRoutingTable.h"
+#include "../src/NoC.h"
+#include "../src/ReservationTable.h"
+#include "../src/Router.h"
+#include "../src/smartbuffer/BufferManager.h"
+#include "../src/taskmanager/ConfigParser.h"
+#include "../src/taskmanager/TaskManager.h"
+
+#ifndef NOXIM_SOURCE_DIR
+#define NOXIM_SOURCE_DIR "."
+#endif
+
+using namespace std;
+
+// Main.cpp is not linked in, the router still refers to it
+unsigned int drained_volume;
+
+//---------------------------------------------------------------------------
+
+static double wallSeconds() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static long peakRssKb(int who) {
+  struct rusage ru;
+  getrusage(who, &ru);
+  return ru.ru_maxrss;
+}
+
+static void reportMicro(const string &name, unsigned long ops, double seconds) {
+  printf("{\"bench\": \"%s\", \"ops\": %lu, \"seconds\": %.6f, "
+         "\"ns_per_op\": %.2f, \"ops_per_sec\": %.0f}\n",
+         name.c_str(), ops, seconds, seconds * 1e9 / ops, ops / seconds);
+  fflush(stdout);
+}
+
+//---------------------------------------------------------------------------
+// Microbenchmarks
+//---------------------------------------------------------------------------
+
+static void benchBuffer(unsigned long iters) {
+  Buffer b;
+  b.SetMaxBufferSize(GlobalParams::buffer_depth);
+  Flit f;
+  f.flit_type = FLIT_TYPE_BODY;
+
+  unsigned long ops = 0;
+  double t0 = wallSeconds();
+  while (ops < iters) {
+    for (int k = 0; k < GlobalParams::buffer_depth; k++)
+      b.Push(f);
+    for (int k = 0; k < GlobalParams::buffer_depth; k++)
+      f = b.Pop();
+    ops += 2 * GlobalParams::buffer_depth;
+  }
+  reportMicro("buffer_push_pop", ops, wallSeconds() - t0);
+}
+
+static void benchReservationTable(unsigned long iters, int n_ports) {
+  ReservationTable rt;
+  rt.setSize(n_ports);
+
+  // 一个输入多播到除自身外的所有端口
+  vector<int> outputs;
+  for (int o = 1; o < n_ports; o++)
+    outputs.push_back(o);
+  TReservation r = {0, 0};
+
+  double t0 = wallSeconds();
+  for (unsigned long i = 0; i < iters; i++) {
+    if (rt.checkReservation(r, outputs) == RT_AVAILABLE)
+      rt.reserve(r, outputs);
+    rt.release(r, outputs);
+  }
+  reportMicro("reservation_table_multicast", iters, wallSeconds() - t0);
+}
+
+static void benchBufferManager(unsigned long iters) {
+  std::map<DataType, size_t> caps;
+  caps[DataType::INPUT] = 1 << 20;
+  caps[DataType::WEIGHT] = 1 << 20;
+  caps[DataType::OUTPUT] = 1 << 20;
+  BufferManager bm(caps);
+  const std::vector<DataType> required = {DataType::INPUT, DataType::WEIGHT};
+
+  unsigned long ready = 0;
+  double t0 = wallSeconds();
+  for (unsigned long i = 0; i < iters; i++) {
+    DataType t = static_cast<DataType>(i % 3);
+    bm.OnDataReceived(t, 64);
+    ready += bm.AreDataTypesReady(required, 64);
+    bm.RemoveData(t, 64);
+  }
+  double dt = wallSeconds() - t0;
+  if (ready == ULONG_MAX) // keep the loop observable
+    printf("\n");
+  reportMicro("buffer_manager_recv_check_remove", iters, dt);
+}
+
+static void benchTaskManager(unsigned long iters, const string &workload) {
+  WorkloadConfig config = loadWorkloadConfigFromFile(workload);
+  TaskManager tm;
+  tm.Configure(config, "ROLE_GLB");
+  if (tm.get_total_timesteps() == 0) {
+    cerr << "Warning: " << workload << " has no ROLE_GLB schedule, skipping "
+         << "task_manager benchmark" << endl;
+    return;
+  }
+
+  size_t subtasks = 0;
+  double t0 = wallSeconds();
+  for (unsigned long i = 0; i < iters; i++)
+    subtasks +=
+        tm.get_task_for_timestep(i % tm.get_total_timesteps()).sub_tasks.size();
+  double dt = wallSeconds() - t0;
+  if (subtasks == 0)
+    cerr << "Warning: empty dispatch tasks in " << workload << endl;
+  reportMicro("task_manager_get_task_for_timestep", iters, dt);
+}
+
+// 一个根路由器 (LOCAL + N 个 DOWN 端口)，所有端口都挂在空闲链路上
+SC_MODULE(RouterBench) {
+  sc_in_clk clock;
+  sc_in<bool> reset;
+
+  Router *r;
+  vector<LinkChannel *> links;
+  GlobalRoutingTable grt;
+
+  template <typename P> void bindLink(P *port) {
+    links.push_back(new LinkChannel(("bench_link_" +
+                                     to_string(links.size())).c_str()));
+    links.back()->configure(false, 1, GlobalParams::buffer_depth,
+                            GlobalParams::n_virtual_channels);
+    port->bind(*links.back());
+  }
+
+  SC_CTOR(RouterBench) {
+    r = new Router("BenchRouter");
+    r->local_id = 0;
+    r->local_level = 0;
+    r->initPorts();
+    r->buildUnifiedInterface();
+    r->clock(clock);
+    r->reset(reset);
+
+    for (size_t i = 0; i < r->all_link_rx.size(); i++) {
+      bindLink(r->all_link_rx[i]);
+      bindLink(r->all_link_tx[i]);
+    }
+    r->configure(0, 0, 0, GlobalParams::buffer_depth, grt);
+  }
+};
+
+static void benchRouterTx(unsigned long iters, RouterBench *rb) {
+  Router *r = rb->r;
+  int n_ports = r->all_link_rx.size();
+
+  // 排列流量：输入 i 预留输出 (i+1) % n，每次调用每个输入都有一个 BODY flit
+  for (int i = 0; i < n_ports; i++) {
+    TReservation res = {i, 0};
+    r->reservation_table.reserve(res, (i + 1) % n_ports);
+  }
+  Flit f;
+  f.flit_type = FLIT_TYPE_BODY;
+  f.vc_id = 0;
+  f.command = 0;
+  f.target_role = r->role;
+
+  unsigned long flits = 0;
+  double busy = 0;
+  for (unsigned long it = 0; it < iters; it++) {
+    for (int i = 0; i < n_ports; i++) {
+      if ((*r->buffers[i])[0].IsEmpty())
+        (*r->buffers[i])[0].Push(f);
+      // 模拟下游已接收
+      (*r->all_link_tx[i])->reset();
+    }
+    double t0 = wallSeconds();
+    r->txProcess();
+    busy += wallSeconds() - t0;
+    for (int i = 0; i < n_ports; i++)
+      flits += (*r->buffers[i])[0].IsEmpty();
+  }
+  char name[64];
+  sprintf(name, "router_txprocess_%dports", n_ports);
+  reportMicro(name, iters, busy);
+  printf("{\"bench\": \"%s_flits\", \"flits_per_call\": %.2f}\n", name,
+         (double)flits / iters);
+}
+
+//---------------------------------------------------------------------------
+// Link throughput: flits per cycle across the DRAM->GLB and GLB->DISTRIBUTOR
+// links versus buffer_depth, link_latency and link width, for both
+// flow-control protocols
+//---------------------------------------------------------------------------
+
+// DRAM(0) -> GLB(1) -> DISTRIBUTOR(2) 三个 router 串成一条链。DRAM 的 LOCAL
+// 输入 buffer 一直保持满，DISTRIBUTOR 的 LOCAL 输出每周期被全部取走
+SC_MODULE(LinkBench) {
+  sc_in_clk clock;
+  sc_in<bool> reset;
+
+  Router *r[3];
+  vector<LinkChannel *> local_links;
+  LinkChannel *links[2][2]; // [link][0: 父 -> 子, 1: 子 -> 父]
+  LinkChannel *sink;
+  GlobalRoutingTable grt;
+  Flit source_flit;
+
+  LinkChannel *newLink(const string &name, const LevelConfig &lc) {
+    LinkChannel *link = new LinkChannel(name.c_str());
+    link->configure(lc.credit_flow_control, lc.link_latency,
+                    GlobalParams::buffer_depth,
+                    GlobalParams::n_virtual_channels, lc.bandwidth);
+    return link;
+  }
+
+  void bindLocal(int l) {
+    const LevelConfig &lc = GlobalParams::hierarchical_config.levels[l];
+    string name = "bench_local_" + to_string(l);
+    local_links.push_back(newLink(name + "_rx", lc));
+    r[l]->h_link_rx_local[0]->bind(*local_links.back());
+    local_links.push_back(newLink(name + "_tx", lc));
+    r[l]->h_link_tx_local[0]->bind(*local_links.back());
+  }
+
+  void feedSource() {
+    Buffer &b = (*r[0]->buffers[r[0]->getLogicalPortIndex(Router::PORT_LOCAL,
+                                                          0)])[0];
+    while (!b.IsFull())
+      b.Push(source_flit);
+  }
+
+  void drainSink() {
+    while (sink->available())
+      sink->receive();
+  }
+
+  // 复位结束后调用：BODY flit 不做路由，直接预留 LOCAL->DOWN->...->LOCAL
+  void reservePath() {
+    TReservation res = {r[0]->getLogicalPortIndex(Router::PORT_LOCAL, 0), 0};
+    r[0]->reservation_table.reserve(
+        res, r[0]->getLogicalPortIndex(Router::PORT_DOWN, 0));
+    res.input = r[1]->getLogicalPortIndex(Router::PORT_UP);
+    r[1]->reservation_table.reserve(
+        res, r[1]->getLogicalPortIndex(Router::PORT_DOWN, 0));
+    res.input = r[2]->getLogicalPortIndex(Router::PORT_UP);
+    r[2]->reservation_table.reserve(
+        res, r[2]->getLogicalPortIndex(Router::PORT_LOCAL, 0));
+  }
+
+  SC_CTOR(LinkBench) {
+    for (int l = 0; l < 3; l++) {
+      r[l] = new Router(("LinkRouter_" + to_string(l)).c_str());
+      r[l]->local_id = l;
+      r[l]->local_level = l;
+      r[l]->initPorts();
+      r[l]->buildUnifiedInterface();
+      r[l]->clock(clock);
+      r[l]->reset(reset);
+      bindLocal(l);
+    }
+    sink = local_links.back();
+    for (int l = 0; l < 2; l++) {
+      const LevelConfig &lc = GlobalParams::hierarchical_config.levels[l];
+      for (int d = 0; d < 2; d++)
+        links[l][d] = newLink(
+            "bench_link_" + to_string(l) + "_" + to_string(d), lc);
+      r[l]->h_link_tx_down[0]->bind(*links[l][0]);
+      r[l + 1]->h_link_rx_up->bind(*links[l][0]);
+      r[l + 1]->h_link_tx_up->bind(*links[l][1]);
+      r[l]->h_link_rx_down[0]->bind(*links[l][1]);
+    }
+    for (int l = 0; l < 3; l++)
+      r[l]->configure(l, l, 0, GlobalParams::buffer_depth, grt);
+
+    source_flit.flit_type = FLIT_TYPE_BODY;
+    source_flit.vc_id = 0;
+    source_flit.command = -1; // 单输出转发分支
+    source_flit.target_role = ROLE_UNUSED;
+
+    SC_METHOD(feedSource);
+    sensitive << clock.neg();
+    SC_METHOD(drainSink);
+    sensitive << clock.neg();
+  }
+};
+
+// 在子进程中完成一次 elaboration + 仿真 (SystemC 每个进程只能 elaborate 一次)
+static void runLinkBench(bool credit, int depth, int latency, int bits,
+                         int cycles, int out_fd) {
+  GlobalParams::buffer_depth = depth;
+  GlobalParams::flit_size = 32;
+  GlobalParams::n_virtual_channels = 1;
+  GlobalParams::clock_period_ps = 1000;
+  GlobalParams::routing_algorithm = "XY";
+  GlobalParams::num_levels = 3;
+  GlobalParams::fanouts_per_level = new int[3]{1, 1, 0};
+  const PE_Role roles[3] = {ROLE_DRAM, ROLE_GLB, ROLE_DISTRIBUTOR};
+  GlobalParams::hierarchical_config.levels.clear();
+  for (int l = 0; l < 3; l++) {
+    LevelConfig lc;
+    lc.level = l;
+    lc.buffer_size[0] = lc.buffer_size[1] = lc.buffer_size[2] = 0;
+    lc.bandwidth = bits;
+    lc.aggregate = false;
+    lc.credit_flow_control = credit;
+    lc.link_latency = latency;
+    lc.roles = roles[l];
+    lc.has_routing_patterns = false;
+    GlobalParams::hierarchical_config.levels.push_back(lc);
+  }
+
+  sc_clock clock("clock", GlobalParams::clock_period_ps, SC_PS);
+  sc_signal<bool> reset;
+  LinkBench lb("LinkBench");
+  lb.clock(clock);
+  lb.reset(reset);
+
+  const int warm_up = 100;
+  reset.write(1);
+  sc_start(5 * GlobalParams::clock_period_ps, SC_PS);
+  reset.write(0);
+  sc_start(GlobalParams::clock_period_ps, SC_PS);
+  lb.reservePath();
+  sc_start(warm_up * GlobalParams::clock_period_ps, SC_PS);
+  unsigned long start[2] = {lb.links[0][0]->transferredFlits(),
+                           lb.links[1][0]->transferredFlits()};
+  sc_start((double)cycles * GlobalParams::clock_period_ps, SC_PS);
+
+  const char *links[2] = {"DRAM->GLB", "GLB->DISTRIBUTOR"};
+  for (int l = 0; l < 2; l++)
+    dprintf(out_fd,
+            "{\"bench\": \"link_throughput\", \"link\": \"%s\", "
+            "\"flow_control\": \"%s\", \"buffer_depth\": %d, "
+            "\"link_latency\": %d, \"link_bits\": %d, \"flit_size\": %d, "
+            "\"cycles\": %d, \"flits_per_cycle\": %.3f}\n",
+            links[l], credit ? "credit" : "abp", depth, latency, bits,
+            GlobalParams::flit_size, cycles,
+            (double)(lb.links[l][0]->transferredFlits() - start[l]) / cycles);
+}
+
+static void benchLinkThroughput(int cycles) {
+  const int depths[] = {1, 2, 3, 4, 8, 16};
+  const int latencies[] = {1, 2, 4};
+  const int widths[] = {16, 32, 128}; // flit_size = 32: 1/2、1、4 flit/周期
+  for (int bits : widths)
+    for (bool credit : {false, true})
+      for (int latency : latencies)
+        for (int depth : depths) {
+          fflush(stdout);
+          pid_t pid = fork();
+          if (pid == 0) {
+            // router 的构造信息打印到 stdout，结果写到原来的 stdout
+            int out_fd = dup(STDOUT_FILENO);
+            int devnull = open("/dev/null", O_WRONLY);
+            dup2(devnull, STDOUT_FILENO);
+            runLinkBench(credit, depth, latency, bits, cycles, out_fd);
+            _exit(0);
+          }
+          int status = 0;
+          waitpid(pid, &status, 0);
+          if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            printf("{\"bench\": \"link_throughput\", \"flow_control\": "
+                   "\"%s\", \"buffer_depth\": %d, \"link_latency\": %d, "
+                   "\"link_bits\": %d, \"exit\": %d}\n",
+                   credit ? "credit" : "abp", depth, latency, bits,
+                   WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        }
+  fflush(stdout);
+}
+
+//---------------------------------------------------------------------------
+// Elaboration: build the NoC of a 1-16-1024-102400 tree (103441 nodes) with
+// every Tile, Router, PE and link, and complete port binding
+//---------------------------------------------------------------------------
+
+// 在子进程中完成 (SystemC 每个进程只能 elaborate 一次)
+static void runElaborationBench(const string &workload, const string &power,
+                                int out_fd) {
+  GlobalParams::topology = TOPOLOGY_HIERARCHICAL;
+  GlobalParams::buffer_depth = 8;
+  GlobalParams::flit_size = 32;
+  GlobalParams::n_virtual_channels = 3;
+  GlobalParams::clock_period_ps = 1000;
+  GlobalParams::routing_algorithm = "XY";
+  GlobalParams::traffic_distribution = TRAFFIC_RANDOM;
+  GlobalParams::r2r_link_length = 1.0;
+  GlobalParams::r2h_link_length = 2.0;
+  GlobalParams::power_configuration =
+      YAML::LoadFile(power)["Energy"].as<PowerConfig>();
+  GlobalParams::workload = loadWorkloadConfigFromFile(workload);
+  GlobalParams::num_levels = 4;
+  GlobalParams::fanouts_per_level = new int[4]{16, 64, 100, 0};
+  const PE_Role roles[4] = {ROLE_DRAM, ROLE_GLB, ROLE_DISTRIBUTOR,
+                            ROLE_BUFFER};
+  const int bandwidths[4] = {128, 128, 64, 8};
+  GlobalParams::hierarchical_config.levels.clear();
+  for (int l = 0; l < 4; l++) {
+    LevelConfig lc;
+    lc.level = l;
+    lc.buffer_size[0] = lc.buffer_size[1] = lc.buffer_size[2] = 4096;
+    lc.bandwidth = bandwidths[l];
+    lc.aggregate = roles[l] == ROLE_GLB;
+    lc.roles = roles[l];
+    lc.has_routing_patterns = false;
+    GlobalParams::hierarchical_config.levels.push_back(lc);
+  }
+
+  sc_clock clock("clock", GlobalParams::clock_period_ps, SC_PS);
+  sc_signal<bool> reset;
+
+  double t0 = wallSeconds();
+  NoC *noc = new NoC("NoC");
+  double t1 = wallSeconds();
+  noc->clock(clock);
+  noc->reset(reset);
+  sc_start(SC_ZERO_TIME); // 完成端口绑定 (end_of_elaboration)
+  double t2 = wallSeconds();
+
+  dprintf(out_fd,
+          "{\"bench\": \"elaboration\", \"nodes\": %d, "
+          "\"construct_seconds\": %.3f, \"bind_seconds\": %.3f, "
+          "\"elaboration_seconds\": %.3f, \"nodes_per_sec\": %.0f, "
+          "\"peak_rss_kb\": %ld}\n",
+          GlobalParams::num_nodes, t1 - t0, t2 - t1, t2 - t0,
+          GlobalParams::num_nodes / (t2 - t0), peakRssKb(RUSAGE_SELF));
+}
+
+static void benchElaboration(const string &workload, const string &power) {
+  // 与 noxim 相同，未给出 -power 时使用当前目录下的 power.yaml
+  string power_file = power.empty() ? POWER_CONFIG_FILENAME : power;
+  if (access(power_file.c_str(), R_OK) != 0) {
+    cerr << "Error: power configuration " << power_file
+         << " not found, use -power FILE" << endl;
+    return;
+  }
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    // 拓扑构建信息打印到 stdout，结果写到原来的 stdout
+    int out_fd = dup(STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDOUT_FILENO);
+    runElaborationBench(workload, power_file, out_fd);
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    printf("{\"bench\": \"elaboration\", \"exit\": %d}\n",
+           WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+  fflush(stdout);
+}
+
+//---------------------------------------------------------------------------
+// End-to-end benchmarks: run noxim as a child process with -profile
+//---------------------------------------------------------------------------
+
+static double parseProfilerValue(const string &out, const string &key) {
+  size_t pos = out.find(key);
+  if (pos == string::npos)
+    return -1;
+  return atof(out.c_str() + pos + key.size());
+}
+
+static void benchEndToEnd(const string &name, const string &noxim,
+                          const string &configs, const string &config,
+                          const string &power, int sim) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    perror("pipe");
+    return;
+  }
+
+  double t0 = wallSeconds();
+  pid_t pid = fork();
+  if (pid == 0) {
+    // 配置里的 traffic table 等相对路径以配置目录为基准
+    if (chdir(configs.c_str()) != 0)
+      _exit(127);
+    dup2(fds[1], STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDERR_FILENO);
+    close(fds[0]);
+
+    vector<string> args = {noxim, "-config", config, "-profile"};
+    if (!power.empty()) {
+      args.push_back("-power");
+      args.push_back(power);
+    }
+    if (sim > 0) {
+      args.push_back("-sim");
+      args.push_back(to_string(sim));
+    }
+    vector<char *> argv;
+    for (auto &a : args)
+      argv.push_back(const_cast<char *>(a.c_str()));
+    argv.push_back(NULL);
+    execv(noxim.c_str(), argv.data());
+    _exit(127);
+  }
+  close(fds[1]);
+
+  string out;
+  char buf[4096];
+  ssize_t n;
+  while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+    out.append(buf, n);
+  close(fds[0]);
+
+  int status = 0;
+  struct rusage ru;
+  wait4(pid, &status, 0, &ru);
+  double wall = wallSeconds() - t0;
+
+  int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  printf("{\"bench\": \"e2e_%s\", \"config\": \"%s\", \"exit\": %d, "
+         "\"wall_seconds\": %.3f, \"configuration_seconds\": %.3f, "
+         "\"elaboration_seconds\": %.3f, \"simulation_seconds\": %.3f, "
+         "\"cycles\": %.0f, \"cycles_per_sec\": %.1f, \"peak_rss_kb\": %ld}\n",
+         name.c_str(), config.c_str(), exit_code, wall,
+         parseProfilerValue(out, "configuration time (s): "),
+         parseProfilerValue(out, "elaboration time (s): "),
+         parseProfilerValue(out, "simulation time (s): "),
+         parseProfilerValue(out, "Simulated cycles: "),
+         parseProfilerValue(out, "Cycles per wall-second: "), ru.ru_maxrss);
+  fflush(stdout);
+}
+
+//---------------------------------------------------------------------------
+
+static string absolutePath(const string &p) {
+  char resolved[PATH_MAX];
+  if (realpath(p.c_str(), resolved) == NULL)
+    return p;
+  return resolved;
+}
+
+int sc_main(int argc, char *argv[]) {
+  bool run_micro = false, run_e2e = false, run_link = false, run_elab = false;
+  string configs = string(NOXIM_SOURCE_DIR) + "/config_examples";
+  string noxim;
+  string power;
+  int sim = 0;
+  unsigned long iters = 1000000;
+  int fanout = 16;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-micro"))
+      run_micro = true;
+    else if (!strcmp(argv[i], "-e2e"))
+      run_e2e = true;
+    else if (!strcmp(argv[i], "-link"))
+      run_link = true;
+    else if (!strcmp(argv[i], "-elab"))
+      run_elab = true;
+    else if (!strcmp(argv[i], "-noxim") && i + 1 < argc)
+      noxim = argv[++i];
+    else if (!strcmp(argv[i], "-configs") && i + 1 < argc)
+      configs = argv[++i];
+    else if (!strcmp(argv[i], "-power") && i + 1 < argc)
+      power = argv[++i];
+    else if (!strcmp(argv[i], "-sim") && i + 1 < argc)
+      sim = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-iters") && i + 1 < argc)
+      iters = strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(argv[i], "-ports") && i + 1 < argc)
+      fanout = atoi(argv[++i]) - 1;
+    else {
+      cerr << "Unknown option " << argv[i] << endl;
+      return 1;
+    }
+  }
+  if (!run_micro && !run_e2e && !run_link && !run_elab)
+    run_micro = run_e2e = run_link = run_elab = true;
+
+  if (noxim.empty()) {
+    string self = absolutePath(argv[0]);
+    noxim = self.substr(0, self.find_last_of('/') + 1) + "noxim";
+  }
+  noxim = absolutePath(noxim);
+  configs = absolutePath(configs);
+  if (!power.empty())
+    power = absolutePath(power);
+
+  // 每个配置 fork 一个子进程，必须在本进程 elaborate 之前运行
+  if (run_link)
+    benchLinkThroughput(sim > 0 ? sim : 10000);
+  if (run_elab)
+    benchElaboration(configs + "/multicast_workload.yaml", power);
+
+  if (run_micro) {
+    // 微基准只需要最小的全局参数：两层树，根节点扇出 fanout
+    GlobalParams::buffer_depth = 8;
+    GlobalParams::n_virtual_channels = 1;
+    GlobalParams::flit_size = 64; // 与 bandwidth 相同：每条链路每周期一个 flit
+    GlobalParams::clock_period_ps = 1000;
+    GlobalParams::routing_algorithm = "XY";
+    GlobalParams::num_levels = 2;
+    GlobalParams::fanouts_per_level = new int[2];
+    GlobalParams::fanouts_per_level[0] = fanout;
+    GlobalParams::fanouts_per_level[1] = 0;
+    LevelConfig lc;
+    lc.level = 0;
+    lc.buffer_size[0] = lc.buffer_size[1] = lc.buffer_size[2] = 0;
+    lc.bandwidth = 64;
+    lc.aggregate = false;
+    lc.roles = ROLE_GLB;
+    lc.has_routing_patterns = false;
+    GlobalParams::hierarchical_config.levels.assign(2, lc);
+    GlobalParams::hierarchical_config.levels[1].level = 1;
+    GlobalParams::hierarchical_config.levels[1].roles = ROLE_BUFFER;
+
+    sc_clock clock("clock", GlobalParams::clock_period_ps, SC_PS);
+    sc_signal<bool> reset;
+    RouterBench rb("RouterBench");
+    rb.clock(clock);
+    rb.reset(reset);
+    reset.write(0);
+    sc_start(SC_ZERO_TIME); // 完成端口绑定
+
+    benchBuffer(iters);
+    benchReservationTable(iters, fanout + 1);
+    benchBufferManager(iters);
+    benchTaskManager(iters / 10, configs + "/multicast_workload.yaml");
+    benchRouterTx(iters / 10, &rb);
+
+    printf("{\"bench\": \"micro_peak_rss\", \"peak_rss_kb\": %ld}\n",
+           peakRssKb(RUSAGE_SELF));
+    fflush(stdout);
+  }
+
+  if (run_e2e) {
+    if (access(noxim.c_str(), X_OK) != 0) {
+      cerr << "Error: simulator binary " << noxim
+           << " not found, use -noxim PATH" << endl;
+      return 1;
+    }
+    benchEndToEnd("hierarchy", noxim, configs, "hirearchy.yaml", power, sim);
+    benchEndToEnd("multicast", noxim, configs, "multicast_workload.yaml",
+                  power, sim);
+    benchEndToEnd("alexnet_layer7", noxim, configs, "alexnet/7_0.yaml", power,
+                  sim);
+  }
+
+  return 0;
+}
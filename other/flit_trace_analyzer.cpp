@@ -0,0 +1,282 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * Offline analyzer for the binary flit trace written by noxim when
+ * trace_mode is enabled (see src/FlitTrace.h for the record layout).
+ *
+ * Usage: flit_trace_analyzer TRACE_FILE [-top N]
+ *
+ * Reports
+ *  - per-packet end-to-end latency, split into head latency (first HEAD
+ *    inject -> first HEAD eject), serialization (HEAD inject -> TAIL inject)
+ *    and the remaining drain time, grouped by data type
+ *  - per-hop queuing time (HEAD enters a router input buffer -> HEAD leaves
+ *    on its first output port), per router
+ *  - link utilization (flits/cycle) of every router output port and PE
+ *    injection port
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../src/FlitTrace.h"
+
+using namespace std;
+
+//---------------------------------------------------------------------------
+
+#define FLIT_TYPE_HEAD 0 // From noxim/src/DataStructs.h
+#define FLIT_TYPE_TAIL 2
+
+static const char *data_type_names[] = {"INPUT", "WEIGHT", "OUTPUT",
+                                        "UNKNOWN"};
+
+struct PacketInfo {
+  int src;
+  int data_type;
+  uint64_t head_inject;
+  uint64_t tail_inject;
+  uint64_t first_head_eject;
+  uint64_t last_tail_eject;
+  int destinations; // 收到 TAIL 的 PE 数量 (多播 > 1)
+  bool injected;
+
+  PacketInfo()
+      : src(-1), data_type(3), head_inject(0), tail_inject(0),
+        first_head_eject(UINT64_MAX), last_tail_eject(0), destinations(0),
+        injected(false) {}
+};
+
+struct Accumulator {
+  double sum;
+  uint64_t max;
+  unsigned long count;
+
+  Accumulator() : sum(0), max(0), count(0) {}
+  void add(uint64_t v) {
+    sum += v;
+    max = std::max(max, v);
+    count++;
+  }
+  double avg() const { return count ? sum / count : 0.0; }
+};
+
+// 一个包在同一个 router 只会进入一次，(packet_id, node) 即可唯一确定一跳
+static uint64_t hopKey(uint32_t packet_id, int node) {
+  return ((uint64_t)packet_id << 32) | (uint32_t)node;
+}
+
+//---------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    cerr << "Usage: " << argv[0] << " TRACE_FILE [-top N]" << endl;
+    return 1;
+  }
+
+  unsigned int top_n = 10;
+  for (int i = 2; i < argc; i++)
+    if (!strcmp(argv[i], "-top") && i + 1 < argc)
+      top_n = atoi(argv[++i]);
+
+  ifstream in(argv[1], ios::binary);
+  if (!in) {
+    cerr << "Error: cannot open " << argv[1] << endl;
+    return 1;
+  }
+
+  FlitTraceHeader header;
+  in.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!in || memcmp(header.magic, FLIT_TRACE_MAGIC, 4) != 0) {
+    cerr << "Error: " << argv[1] << " is not a noxim flit trace" << endl;
+    return 1;
+  }
+  if (header.version != FLIT_TRACE_VERSION ||
+      header.record_size != sizeof(FlitTraceRecord)) {
+    cerr << "Error: unsupported trace version " << header.version
+         << " (record size " << header.record_size << ")" << endl;
+    return 1;
+  }
+
+  unordered_map<uint32_t, PacketInfo> packets;
+  unordered_map<uint64_t, uint64_t> head_arrival; // hop -> ROUTER_RX cycle
+  map<int, Accumulator> queuing_per_node;
+  map<pair<int, int>, unsigned long> tx_per_link; // (node, port) -> flits
+  map<int, unsigned long> inject_per_node;
+
+  uint64_t first_cycle = UINT64_MAX, last_cycle = 0;
+  unsigned long n_records = 0;
+
+  const size_t CHUNK = 1 << 16;
+  vector<FlitTraceRecord> chunk(CHUNK);
+  while (in) {
+    in.read(reinterpret_cast<char *>(chunk.data()),
+            CHUNK * sizeof(FlitTraceRecord));
+    size_t n = in.gcount() / sizeof(FlitTraceRecord);
+
+    for (size_t k = 0; k < n; k++) {
+      const FlitTraceRecord &r = chunk[k];
+      n_records++;
+      first_cycle = min(first_cycle, r.cycle);
+      last_cycle = max(last_cycle, r.cycle);
+
+      switch (r.event) {
+      case FT_INJECT: {
+        inject_per_node[r.node]++;
+        PacketInfo &p = packets[r.packet_id];
+        if (r.flit_type == FLIT_TYPE_HEAD) {
+          p.src = r.node;
+          p.data_type = r.data_type;
+          p.head_inject = r.cycle;
+          p.injected = true;
+        } else if (r.flit_type == FLIT_TYPE_TAIL) {
+          p.tail_inject = r.cycle;
+        }
+        break;
+      }
+      case FT_ROUTER_RX:
+        if (r.flit_type == FLIT_TYPE_HEAD)
+          head_arrival[hopKey(r.packet_id, r.node)] = r.cycle;
+        break;
+      case FT_ROUTER_TX:
+        tx_per_link[make_pair((int)r.node, (int)r.port)]++;
+        if (r.flit_type == FLIT_TYPE_HEAD) {
+          // HEAD 只在第一次离开该 router 时统计排队时间 (多播/分批转发)
+          auto it = head_arrival.find(hopKey(r.packet_id, r.node));
+          if (it != head_arrival.end()) {
+            queuing_per_node[r.node].add(r.cycle - it->second);
+            head_arrival.erase(it);
+          }
+        }
+        break;
+      case FT_EJECT: {
+        PacketInfo &p = packets[r.packet_id];
+        if (r.flit_type == FLIT_TYPE_HEAD)
+          p.first_head_eject = min(p.first_head_eject, r.cycle);
+        else if (r.flit_type == FLIT_TYPE_TAIL) {
+          p.last_tail_eject = max(p.last_tail_eject, r.cycle);
+          p.destinations++;
+        }
+        break;
+      }
+      default:
+        break;
+      }
+    }
+  }
+
+  uint64_t span = n_records ? last_cycle - first_cycle + 1 : 0;
+
+  cout << "% Trace: " << argv[1] << endl;
+  cout << "% Flit events: " << n_records << endl;
+  cout << "% Cycles covered: " << span << " (" << first_cycle << " - "
+       << last_cycle << ")" << endl;
+  cout << "% Clock period (ps): " << header.clock_period_ps << endl;
+  cout << endl;
+
+  //-------------------------------------------------------------------------
+  // Latency breakdown
+  //-------------------------------------------------------------------------
+  Accumulator total[4], head[4], serial[4], drain[4];
+  unsigned long incomplete = 0;
+  for (const auto &kv : packets) {
+    const PacketInfo &p = kv.second;
+    if (!p.injected || p.destinations == 0 ||
+        p.first_head_eject == UINT64_MAX) {
+      incomplete++;
+      continue;
+    }
+    int dt = p.data_type < 4 ? p.data_type : 3;
+    uint64_t t_total = p.last_tail_eject - p.head_inject;
+    uint64_t t_head = p.first_head_eject - p.head_inject;
+    uint64_t t_serial = p.tail_inject - p.head_inject;
+    total[dt].add(t_total);
+    head[dt].add(t_head);
+    serial[dt].add(t_serial);
+    drain[dt].add(t_total - min(t_total, t_head + t_serial));
+  }
+
+  cout << "% Packet latency breakdown (cycles, avg / max)" << endl;
+  cout << setw(10) << left << "type" << setw(10) << "packets" << setw(20)
+       << "end-to-end" << setw(20) << "head" << setw(20) << "serialization"
+       << setw(20) << "drain" << endl;
+  for (int dt = 0; dt < 4; dt++) {
+    if (total[dt].count == 0)
+      continue;
+    cout << setw(10) << left << data_type_names[dt] << setw(10)
+         << total[dt].count;
+    Accumulator *cols[] = {&total[dt], &head[dt], &serial[dt], &drain[dt]};
+    for (Accumulator *a : cols) {
+      ostringstream cell;
+      cell << fixed << setprecision(1) << a->avg() << " / " << a->max;
+      cout << setw(20) << cell.str();
+    }
+    cout << endl;
+  }
+  if (incomplete)
+    cout << "% " << incomplete << " packets still in flight at end of trace"
+         << endl;
+  cout << endl;
+
+  //-------------------------------------------------------------------------
+  // Per-hop queuing
+  //-------------------------------------------------------------------------
+  vector<pair<double, int>> by_queuing;
+  Accumulator all_hops;
+  for (const auto &kv : queuing_per_node) {
+    by_queuing.push_back(make_pair(kv.second.avg(), kv.first));
+    all_hops.sum += kv.second.sum;
+    all_hops.count += kv.second.count;
+    all_hops.max = max(all_hops.max, kv.second.max);
+  }
+  sort(by_queuing.rbegin(), by_queuing.rend());
+
+  cout << "% Per-hop queuing (HEAD buffer residency, cycles)" << endl;
+  cout << "% All routers: avg " << fixed << setprecision(2) << all_hops.avg()
+       << ", max " << all_hops.max << ", hops " << all_hops.count << endl;
+  cout << setw(10) << left << "node" << setw(10) << "hops" << setw(12)
+       << "avg" << setw(10) << "max" << endl;
+  for (size_t i = 0; i < by_queuing.size() && i < top_n; i++) {
+    const Accumulator &a = queuing_per_node[by_queuing[i].second];
+    cout << setw(10) << left << by_queuing[i].second << setw(10) << a.count
+         << setw(12) << a.avg() << setw(10) << a.max << endl;
+  }
+  cout << endl;
+
+  //-------------------------------------------------------------------------
+  // Link utilization
+  //-------------------------------------------------------------------------
+  vector<pair<double, pair<int, int>>> by_util;
+  for (const auto &kv : tx_per_link)
+    by_util.push_back(
+        make_pair(span ? (double)kv.second / span : 0.0, kv.first));
+  sort(by_util.rbegin(), by_util.rend());
+
+  cout << "% Router output link utilization (flits/cycle)" << endl;
+  cout << setw(10) << left << "node" << setw(10) << "port" << setw(12)
+       << "flits" << setw(12) << "util" << endl;
+  for (size_t i = 0; i < by_util.size() && i < top_n; i++) {
+    cout << setw(10) << left << by_util[i].second.first << setw(10)
+         << by_util[i].second.second << setw(12)
+         << tx_per_link[by_util[i].second] << setw(12) << setprecision(4)
+         << by_util[i].first << endl;
+  }
+  cout << endl;
+
+  cout << "% PE injection utilization (flits/cycle)" << endl;
+  for (const auto &kv : inject_per_node)
+    cout << setw(10) << left << kv.first << setw(12) << kv.second << setw(12)
+         << setprecision(4) << (span ? (double)kv.second / span : 0.0)
+         << endl;
+
+  return 0;
+}
@@ -0,0 +1,276 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the switch allocators
+ */
+
+#include "Allocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+Allocator *Allocator::create(const string &name) {
+  if (name == ALLOCATOR_ROUND_ROBIN)
+    return new RoundRobinAllocator();
+  if (name == ALLOCATOR_ISLIP)
+    return new ISlipAllocator();
+  if (name == ALLOCATOR_AGE)
+    return new AgeAllocator();
+  return 0;
+}
+
+bool Allocator::isValid(const string &name) {
+  return name == ALLOCATOR_ROUND_ROBIN || name == ALLOCATOR_ISLIP ||
+         name == ALLOCATOR_AGE;
+}
+
+void Allocator::configure(int _n_inputs, int _n_outputs, int _n_vcs) {
+  n_inputs = _n_inputs;
+  n_outputs = _n_outputs;
+  n_vcs = _n_vcs;
+  input_used.assign(n_inputs + 1, false);
+  output_used.assign(n_outputs, false);
+}
+
+void Allocator::greedy(const vector<AllocRequest> &requests,
+                       const vector<int> &order, vector<int> &grants) {
+  std::fill(input_used.begin(), input_used.end(), false);
+  std::fill(output_used.begin(), output_used.end(), false);
+
+  for (int idx : order) {
+    const AllocRequest &r = requests[idx];
+    if (input_used[r.input])
+      continue;
+
+    bool conflict = false;
+    for (int o : *r.outputs) {
+      if (output_used[o]) {
+        conflict = true;
+        break;
+      }
+    }
+    if (conflict)
+      continue;
+
+    input_used[r.input] = true;
+    for (int o : *r.outputs)
+      output_used[o] = true;
+    grants.push_back(idx);
+  }
+}
+
+//---------------------------------------------------------------------------
+// Wait ages
+//---------------------------------------------------------------------------
+
+void WaitAges::configure(int n_inputs, int _n_vcs) {
+  n_vcs = _n_vcs;
+  cycles.assign((n_inputs + 1) * n_vcs, 0);
+  requested.assign(cycles.size(), false);
+  slots.clear();
+}
+
+void WaitAges::update(const vector<AllocRequest> &requests) {
+  for (const AllocRequest &r : requests) {
+    int slot = r.input * n_vcs + r.vc;
+    cycles[slot]++;
+    requested[slot] = true;
+  }
+  for (int slot : slots)
+    if (!requested[slot])
+      cycles[slot] = 0;
+  slots.clear();
+  for (const AllocRequest &r : requests) {
+    int slot = r.input * n_vcs + r.vc;
+    requested[slot] = false;
+    slots.push_back(slot);
+  }
+}
+
+//---------------------------------------------------------------------------
+// Round robin
+//---------------------------------------------------------------------------
+
+void RoundRobinAllocator::configure(int _n_inputs, int _n_outputs,
+                                    int _n_vcs) {
+  Allocator::configure(_n_inputs, _n_outputs, _n_vcs);
+  pointer = 0;
+}
+
+void RoundRobinAllocator::rotatedOrder(const vector<AllocRequest> &requests) {
+  int slots = numSlots();
+  order.resize(requests.size());
+  for (size_t k = 0; k < requests.size(); k++)
+    order[k] = k;
+
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    int da = (slotOf(requests[a]) - pointer + slots) % slots;
+    int db = (slotOf(requests[b]) - pointer + slots) % slots;
+    return da < db;
+  });
+}
+
+void RoundRobinAllocator::advance(const vector<AllocRequest> &requests,
+                                  const vector<int> &grants) {
+  if (!grants.empty())
+    pointer = (slotOf(requests[grants[0]]) + 1) % numSlots();
+}
+
+void RoundRobinAllocator::allocate(const vector<AllocRequest> &requests,
+                                   vector<int> &grants) {
+  grants.clear();
+  rotatedOrder(requests);
+  greedy(requests, order, grants);
+  advance(requests, grants);
+}
+
+//---------------------------------------------------------------------------
+// Age based
+//---------------------------------------------------------------------------
+
+void AgeAllocator::allocate(const vector<AllocRequest> &requests,
+                            vector<int> &grants) {
+  grants.clear();
+  rotatedOrder(requests);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return requests[a].age > requests[b].age;
+  });
+  greedy(requests, order, grants);
+  advance(requests, grants);
+}
+
+//---------------------------------------------------------------------------
+// iSLIP
+//---------------------------------------------------------------------------
+
+void ISlipAllocator::configure(int _n_inputs, int _n_outputs, int _n_vcs) {
+  Allocator::configure(_n_inputs, _n_outputs, _n_vcs);
+  grant_pointer.assign(n_outputs, 0);
+  accept_pointer.assign(n_inputs + 1, 0);
+  granted_to.assign(n_outputs, -1);
+  fill_pointer = 0;
+}
+
+void ISlipAllocator::allocate(const vector<AllocRequest> &requests,
+                              vector<int> &grants) {
+  grants.clear();
+  matched.assign(requests.size(), false);
+
+  int in_slots = n_inputs + 1;
+  vector<bool> in_busy(in_slots, false);
+  vector<bool> out_busy(n_outputs, false);
+
+  for (int iter = 0; iter < ITERATIONS; iter++) {
+    // Grant: 每个空闲 output 选择离 grant 指针最近的 input
+    std::fill(granted_to.begin(), granted_to.end(), -1);
+    for (size_t k = 0; k < requests.size(); k++) {
+      const AllocRequest &r = requests[k];
+      if (in_busy[r.input])
+        continue;
+      bool blocked = false;
+      for (int o : *r.outputs)
+        blocked = blocked || out_busy[o];
+      if (blocked)
+        continue;
+
+      for (int o : *r.outputs) {
+        int cur = granted_to[o];
+        if (cur == -1) {
+          granted_to[o] = k;
+          continue;
+        }
+        const AllocRequest &c = requests[cur];
+        int dr = (r.input - grant_pointer[o] + in_slots) % in_slots;
+        int dc = (c.input - grant_pointer[o] + in_slots) % in_slots;
+        if (dr == dc) {
+          // 同一 input 的多个 VC，按 accept 指针决定
+          dr = (r.vc - accept_pointer[r.input] + n_vcs) % n_vcs;
+          dc = (c.vc - accept_pointer[c.input] + n_vcs) % n_vcs;
+        }
+        if (dr < dc)
+          granted_to[o] = k;
+      }
+    }
+
+    // Accept: 每个 input 在所有目标 output 都授予它的请求中按 VC 指针选择
+    bool progress = false;
+    for (int in = 0; in < in_slots; in++) {
+      if (in_busy[in])
+        continue;
+
+      int best = -1;
+      int best_d = n_vcs;
+      for (size_t k = 0; k < requests.size(); k++) {
+        const AllocRequest &r = requests[k];
+        if (r.input != in || matched[k])
+          continue;
+        bool all_granted = true;
+        for (int o : *r.outputs)
+          all_granted = all_granted && granted_to[o] == (int)k;
+        if (!all_granted)
+          continue;
+        int d = (r.vc - accept_pointer[in] + n_vcs) % n_vcs;
+        if (d < best_d) {
+          best = k;
+          best_d = d;
+        }
+      }
+      if (best == -1)
+        continue;
+
+      const AllocRequest &w = requests[best];
+      matched[best] = true;
+      in_busy[in] = true;
+      for (int o : *w.outputs)
+        out_busy[o] = true;
+      grants.push_back(best);
+      progress = true;
+
+      // 只在第一轮迭代更新指针 (iSLIP 的去同步化条件)
+      if (iter == 0) {
+        for (int o : *w.outputs)
+          grant_pointer[o] = (in + 1) % in_slots;
+        accept_pointer[in] = (w.vc + 1) % n_vcs;
+      }
+    }
+
+    if (!progress)
+      break;
+  }
+
+  // 多播请求可能被不同 output 的指针分裂而永远无法被接受；剩余资源按
+  // 轮转的 input 顺序贪心补齐，保证前进和公平
+  vector<int> rest;
+  for (size_t k = 0; k < requests.size(); k++)
+    if (!matched[k] && !in_busy[requests[k].input])
+      rest.push_back(k);
+  std::sort(rest.begin(), rest.end(), [&](int a, int b) {
+    int da = (requests[a].input - fill_pointer + in_slots) % in_slots;
+    int db = (requests[b].input - fill_pointer + in_slots) % in_slots;
+    return da != db ? da < db : requests[a].vc < requests[b].vc;
+  });
+
+  bool filled = false;
+  for (int k : rest) {
+    const AllocRequest &r = requests[k];
+    if (in_busy[r.input])
+      continue;
+    bool blocked = false;
+    for (int o : *r.outputs)
+      blocked = blocked || out_busy[o];
+    if (blocked)
+      continue;
+
+    in_busy[r.input] = true;
+    for (int o : *r.outputs)
+      out_busy[o] = true;
+    grants.push_back(k);
+    if (!filled)
+      fill_pointer = (r.input + 1) % in_slots;
+    filled = true;
+  }
+}
@@ -0,0 +1,123 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the switch allocators used in the
+ * forwarding phase of Router::txProcess. Each request asks atomically for a
+ * set of output ports (multicast); a grant set never shares an input or an
+ * output. All state is per router, so the result does not depend on the
+ * order in which SystemC evaluates the routers.
+ */
+
+#ifndef __NOXIMALLOCATOR_H__
+#define __NOXIMALLOCATOR_H__
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define ALLOCATOR_ROUND_ROBIN "ROUND_ROBIN"
+#define ALLOCATOR_ISLIP "ISLIP"
+#define ALLOCATOR_AGE "AGE"
+
+struct AllocRequest {
+  int input; // 0..n_inputs-1，n_inputs 表示聚合队列 (Router 中的 input == -1)
+  int vc;
+  const vector<int> *outputs;
+  unsigned long age; // 连续落选的周期数
+};
+
+class Allocator {
+public:
+  virtual ~Allocator() {}
+
+  virtual void configure(int n_inputs, int n_outputs, int n_vcs);
+
+  // grants 返回被授予的请求下标，按转发顺序排列
+  virtual void allocate(const vector<AllocRequest> &requests,
+                        vector<int> &grants) = 0;
+
+  static Allocator *create(const string &name);
+  static bool isValid(const string &name);
+
+protected:
+  int n_inputs;
+  int n_outputs;
+  int n_vcs;
+
+  // 请求在 (input, vc) 空间中的线性位置
+  int slotOf(const AllocRequest &r) const { return r.input * n_vcs + r.vc; }
+  int numSlots() const { return (n_inputs + 1) * n_vcs; }
+
+  // 按 order 依次贪心授予不冲突的请求
+  void greedy(const vector<AllocRequest> &requests, const vector<int> &order,
+              vector<int> &grants);
+
+private:
+  vector<bool> input_used;
+  vector<bool> output_used;
+};
+
+// 每个 (input, vc) 连续落选的周期数，作为 AGE 分配器的 AllocRequest::age。
+// 每周期用本周期的全部请求调用一次 update：请求者加一，上周期请求、本周期
+// 不再请求 (VC 已清空、预约已释放或输出未就绪) 的清零；被授予时清零
+class WaitAges {
+public:
+  void configure(int n_inputs, int n_vcs);
+  void update(const vector<AllocRequest> &requests);
+  void granted(const AllocRequest &r) { cycles[r.input * n_vcs + r.vc] = 0; }
+  unsigned long ageOf(int input, int vc) const {
+    return cycles[input * n_vcs + vc];
+  }
+
+private:
+  int n_vcs;
+  vector<unsigned long> cycles; // [input * n_vcs + vc]，input 含聚合队列
+  vector<int> slots;            // 上周期提交了请求的位置
+  vector<bool> requested;       // 本周期是否提交了请求 (update 内临时使用)
+};
+
+// 单个轮询指针：从上次第一个胜者之后的 (input, vc) 开始贪心匹配
+class RoundRobinAllocator : public Allocator {
+public:
+  void configure(int n_inputs, int n_outputs, int n_vcs);
+  void allocate(const vector<AllocRequest> &requests, vector<int> &grants);
+
+protected:
+  vector<int> order;
+
+  // 按与指针的距离排序请求；授予后把指针移到第一个胜者之后
+  void rotatedOrder(const vector<AllocRequest> &requests);
+  void advance(const vector<AllocRequest> &requests, const vector<int> &grants);
+
+private:
+  int pointer;
+};
+
+// iSLIP 式迭代匹配：每个 output 一个 grant 指针，每个 input 一个 accept
+// 指针。多播请求只有在所有目标 output 都授予时才能被接受
+class ISlipAllocator : public Allocator {
+public:
+  void configure(int n_inputs, int n_outputs, int n_vcs);
+  void allocate(const vector<AllocRequest> &requests, vector<int> &grants);
+
+private:
+  static const int ITERATIONS = 3;
+  vector<int> grant_pointer;  // [output] -> input
+  vector<int> accept_pointer; // [input] -> vc
+  vector<int> granted_to;     // [output] -> request index
+  vector<bool> matched;       // [request]
+  int fill_pointer;           // 迭代结束后的贪心补齐起点 (input)
+};
+
+// 等待最久的请求优先，相同等待时间按轮询顺序
+class AgeAllocator : public RoundRobinAllocator {
+public:
+  void allocate(const vector<AllocRequest> &requests, vector<int> &grants);
+};
+
+#endif
@@ -9,8 +9,12 @@
  */
 
 #include "ConfigurationManager.h"
+#include "Allocator.h"
 #include "DataStructs.h"
 #include "GlobalParams.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "smartbuffer/BufferManager.h"
 #include <dbg.h>
 #include <systemc.h> //Included for the function time()
 
@@ -164,6 +168,7 @@ void loadConfiguration()
   // Initialize global configuration parameters (can be overridden with
   // command-line arguments)
   GlobalParams::verbose_mode = readParam<string>(config, "verbose_mode");
+  GlobalParams::log_sync = readParam<bool>(config, "log_sync", false);
   GlobalParams::trace_mode = readParam<bool>(config, "trace_mode");
   GlobalParams::trace_filename = readParam<string>(config, "trace_filename");
 
@@ -225,10 +230,34 @@ void loadConfiguration()
     YAML::Node level_configs = hierarchical_config["level_configs"];
     GlobalParams::fanouts_per_level = new int[GlobalParams::num_levels];
 
+    // fanouts 为整数时本层每个节点的子节点数相同；为列表时按节点给出
+    // (节点按 ID 顺序)，fanouts_per_level 记录本层的最大值
+    vector<vector<int>> node_fanouts(GlobalParams::num_levels);
     for (int i = 0; i < GlobalParams::num_levels; i++)
     {
-      GlobalParams::fanouts_per_level[i] =
-          level_configs[i]["fanouts"].as<int>();
+      YAML::Node fanouts = level_configs[i]["fanouts"];
+      if (fanouts.IsSequence())
+      {
+        node_fanouts[i] = fanouts.as<vector<int>>();
+        if (node_fanouts[i].empty())
+        {
+          cerr << "Error: empty fanouts list at level " << i << endl;
+          exit(1);
+        }
+        int max_fanout = 0;
+        for (int f : node_fanouts[i])
+        {
+          if (f < 0)
+          {
+            cerr << "Error: negative fanout at level " << i << endl;
+            exit(1);
+          }
+          max_fanout = max(max_fanout, f);
+        }
+        GlobalParams::fanouts_per_level[i] = max_fanout;
+      }
+      else
+        GlobalParams::fanouts_per_level[i] = fanouts.as<int>();
     }
 
     if (level_configs && level_configs.IsSequence())
@@ -274,6 +303,140 @@ void loadConfiguration()
             node["bank_count"].as<int>(1); // 新增: 解析 bank_count，默认为1
         current_level_data.aggregate =
             node["aggregate"] ? node["aggregate"].as<bool>() : false;
+        current_level_data.double_buffer =
+            node["double_buffer"] ? node["double_buffer"].as<bool>() : false;
+        current_level_data.prefetch_depth =
+            node["prefetch_depth"] ? node["prefetch_depth"].as<int>() : 0;
+        if (current_level_data.prefetch_depth < 0)
+        {
+          cerr << "Error: prefetch_depth of level " << current_level_data.level
+               << " must not be negative" << endl;
+          exit(1);
+        }
+
+        // 数据类型 -> LOCAL 端口，例如 local_ports: { Outputs: 1 }
+        if (node["local_ports"])
+        {
+          for (YAML::const_iterator it = node["local_ports"].begin();
+               it != node["local_ports"].end(); ++it)
+          {
+            string data_type_str = it->first.as<string>();
+            DataType data_type = stringToDataType(data_type_str);
+            int port = it->second.as<int>();
+            if (data_type == DataType::UNKNOWN || port < 0 ||
+                port >= NUM_LOCAL_PORTS)
+            {
+              cerr << "Error: invalid local_ports entry '" << data_type_str
+                   << ": " << port << "' for level "
+                   << current_level_data.level << " (expected a data type and "
+                   << "a port in [0, " << NUM_LOCAL_PORTS - 1 << "])" << endl;
+              exit(1);
+            }
+            current_level_data.local_port[static_cast<int>(data_type)] = port;
+            current_level_data.num_local_ports =
+                std::max(current_level_data.num_local_ports, port + 1);
+          }
+        }
+
+        // 数据类型 -> VC，例如 vc_map: { Weights: 0, Inputs: 1, Outputs: 2 }
+        if (node["vc_map"])
+        {
+          current_level_data.has_vc_map = true;
+          for (YAML::const_iterator it = node["vc_map"].begin();
+               it != node["vc_map"].end(); ++it)
+          {
+            string data_type_str = it->first.as<string>();
+            DataType data_type = stringToDataType(data_type_str);
+            int vc = it->second.as<int>();
+            if (data_type == DataType::UNKNOWN || vc < 0 ||
+                vc >= MAX_VIRTUAL_CHANNELS)
+            {
+              cerr << "Error: invalid vc_map entry '" << data_type_str << ": "
+                   << vc << "' for level " << current_level_data.level << endl;
+              exit(1);
+            }
+            current_level_data.vc_of_type[static_cast<int>(data_type)] = vc;
+          }
+        }
+
+        // VC 仲裁：round_robin (默认) | weighted | priority
+        std::string vc_arbitration =
+            node["vc_arbitration"] ? node["vc_arbitration"].as<std::string>()
+                                   : "round_robin";
+        if (vc_arbitration == "round_robin")
+          current_level_data.vc_arbitration = VC_ARB_ROUND_ROBIN;
+        else if (vc_arbitration == "weighted")
+          current_level_data.vc_arbitration = VC_ARB_WEIGHTED;
+        else if (vc_arbitration == "priority")
+          current_level_data.vc_arbitration = VC_ARB_PRIORITY;
+        else
+        {
+          cerr << "Error: invalid vc_arbitration '" << vc_arbitration
+               << "' for level " << current_level_data.level
+               << " (expected round_robin, weighted or priority)" << endl;
+          exit(1);
+        }
+        if (node["vc_weights"])
+          current_level_data.vc_weights =
+              node["vc_weights"].as<std::vector<int>>();
+        if (current_level_data.vc_weights.size() > MAX_VIRTUAL_CHANNELS)
+        {
+          cerr << "Error: vc_weights of level " << current_level_data.level
+               << " has more than " << MAX_VIRTUAL_CHANNELS << " entries"
+               << endl;
+          exit(1);
+        }
+        for (int w : current_level_data.vc_weights)
+        {
+          if (current_level_data.vc_arbitration == VC_ARB_WEIGHTED && w < 1)
+          {
+            cerr << "Error: vc_weights of level " << current_level_data.level
+                 << " must be at least 1 for weighted arbitration" << endl;
+            exit(1);
+          }
+        }
+
+        // 层间链路流控：abp (默认) | credit
+        std::string flow_control =
+            node["flow_control"] ? node["flow_control"].as<std::string>()
+                                 : "abp";
+        if (flow_control == "credit")
+          current_level_data.credit_flow_control = true;
+        else if (flow_control == "abp")
+          current_level_data.credit_flow_control = false;
+        else
+        {
+          cerr << "Error: invalid flow_control '" << flow_control
+               << "' for level " << current_level_data.level
+               << " (expected abp or credit)" << endl;
+          exit(1);
+        }
+        current_level_data.link_latency =
+            node["link_latency"] ? node["link_latency"].as<int>() : 1;
+        if (current_level_data.link_latency < 1)
+        {
+          cerr << "Error: link_latency of level " << current_level_data.level
+               << " must be at least 1 cycle" << endl;
+          exit(1);
+        }
+
+        // 本层时钟域：缺省使用全局 clock_period_ps
+        current_level_data.clock_period_ps =
+            node["clock_period_ps"] ? node["clock_period_ps"].as<int>() : 0;
+        if (node["clock_period_ps"] && current_level_data.clock_period_ps <= 0)
+        {
+          cerr << "Error: clock_period_ps of level " << current_level_data.level
+               << " must be positive" << endl;
+          exit(1);
+        }
+        current_level_data.cdc_sync_stages =
+            node["cdc_sync_stages"] ? node["cdc_sync_stages"].as<int>() : 2;
+        if (current_level_data.cdc_sync_stages < 1)
+        {
+          cerr << "Error: cdc_sync_stages of level " << current_level_data.level
+               << " must be at least 1" << endl;
+          exit(1);
+        }
 
         // 解析 'roles' 数组
         YAML::Node roles_node = node["roles"];
@@ -324,6 +487,10 @@ void loadConfiguration()
           }
         }
 
+        size_t level_index = GlobalParams::hierarchical_config.levels.size();
+        if (level_index < node_fanouts.size())
+          current_level_data.node_fanouts = node_fanouts[level_index];
+
         // 6. 将填充好的当前层数据存入全局的 vector 中
         GlobalParams::hierarchical_config.levels.push_back(current_level_data);
       }
@@ -353,6 +520,14 @@ void loadConfiguration()
       readParam<string>(config, "routing_table_filename");
   GlobalParams::selection_strategy =
       readParam<string>(config, "selection_strategy");
+  GlobalParams::allocator =
+      readParam<string>(config, "allocator", ALLOCATOR_ROUND_ROBIN);
+  GlobalParams::aggregation_entries = readParam<int>(
+      config, "aggregation_entries", DEFAULT_AGGREGATION_ENTRIES);
+  GlobalParams::tile_replacement =
+      readParam<string>(config, "tile_replacement", "LRU");
+  GlobalParams::pack_subtasks =
+      readParam<bool>(config, "pack_subtasks", false);
   GlobalParams::packet_injection_rate =
       readParam<double>(config, "packet_injection_rate");
   GlobalParams::probability_of_retransmission =
@@ -376,11 +551,16 @@ void loadConfiguration()
   // GlobalParams::hotspots;
   GlobalParams::show_buffer_stats =
       readParam<bool>(config, "show_buffer_stats");
+  GlobalParams::profile = readParam<bool>(config, "profile", false);
   GlobalParams::use_winoc = readParam<bool>(config, "use_winoc");
   GlobalParams::winoc_dst_hops = readParam<int>(config, "winoc_dst_hops", 0);
   GlobalParams::use_powermanager = readParam<bool>(config, "use_wirxsleep");
   GlobalParams::ideal_transport =
       readParam<bool>(config, "ideal_transport", false);
+  GlobalParams::injection_trace_filename =
+      readParam<string>(config, "injection_trace_filename", "");
+  GlobalParams::replay_trace_filename =
+      readParam<string>(config, "replay_trace_filename", "");
 
   set<int> channelSet;
 
@@ -485,8 +665,20 @@ void showHelp(char selfname[])
       << "\t-help\t\t\tShow this help and exit" << endl
       << "\t-config\t\t\tLoad the specified configuration file" << endl
       << "\t-power\t\t\tLoad the specified power configurations file" << endl
-      << "\t-verbose N\t\tVerbosity level (1=low, 2=medium, 3=high)" << endl
-      << "\t-trace FILENAME\t\tTrace signals to a VCD file named 'FILENAME.vcd'"
+      << "\t-verbose N\t\tVerbosity level (1=low, 2=medium, 3=high), or "
+         "e.g. VERBOSE_LOW,Router=VERBOSE_HIGH for per-module levels"
+      << endl
+      << "\t-log_sync\t\tWrite log lines synchronously (keeps them in order "
+         "with other output)"
+      << endl
+      << "\t-trace FILENAME\t\tWrite a binary flit event trace to FILENAME "
+         "(see other/flit_trace_analyzer)"
+      << endl
+      << "\t-record_injections FILENAME\tRecord PE packet injections to "
+         "FILENAME"
+      << endl
+      << "\t-replay FILENAME\tNetwork-only replay of an injection trace "
+         "(no TaskManager/BufferManager)"
       << endl
       << "\t-dimx N\t\t\tSet the mesh X dimension" << endl
       << "\t-dimy N\t\t\tSet the mesh Y dimension" << endl
@@ -528,6 +720,26 @@ void showHelp(char selfname[])
       << "\t\tRANDOM\t\tRandom selection strategy" << endl
       << "\t\tBUFFER_LEVEL\tBuffer-Level Based selection strategy" << endl
       << "\t\tNOP\t\tNeighbors-on-Path selection strategy" << endl
+      << "\t-allocator TYPE\tSet the router switch allocator to one of the "
+         "following:"
+      << endl
+      << "\t\tROUND_ROBIN\tRotating-priority greedy matching (default)"
+      << endl
+      << "\t\tISLIP\t\tiSLIP-style iterative matching" << endl
+      << "\t\tAGE\t\tLongest-waiting request first" << endl
+      << "\t-aggregation_entries N\tSet the number of return aggregations "
+         "in flight per aggregating router (default "
+      << DEFAULT_AGGREGATION_ENTRIES << ")" << endl
+      << "\t-tile_replacement POLICY\tSet the resident tile replacement "
+         "policy of the storage levels to one of the following:"
+      << endl
+      << "\t\tLRU\t\tLeast recently used tile (default)" << endl
+      << "\t\tBELADY\t\tTile with the farthest next use in the schedule"
+      << endl
+      << "\t\tLIVENESS\tDead tiles first, then least recently used" << endl
+      << "\t-pack_subtasks\t\tCombine the sub-tasks of a timestep that share "
+         "target and route into one multi-payload packet"
+      << endl
       << "\t-pir R TYPE\t\tSet the packet injection rate R [0..1] and the time "
          "distribution TYPE where TYPE is one of the following:"
       << endl
@@ -565,6 +777,9 @@ void showHelp(char selfname[])
       << endl
       << "\t-detailed\t\tShow detailed statistics" << endl
       << "\t-show_buf_stats\t\tShow buffers statistics" << endl
+      << "\t-profile\t\tReport simulator wall time and cycles/sec per "
+         "phase and per module/level"
+      << endl
       << "\t-volume N\t\tStop the simulation when either the maximum number of "
          "cycles has been reached or N flits have"
       << endl
@@ -605,6 +820,11 @@ void showConfig()
        // << "- routing_table_filename = " <<
        // GlobalParams::routing_table_filename << endl
        << "- selection_strategy = " << GlobalParams::selection_strategy << endl
+       << "- allocator = " << GlobalParams::allocator << endl
+       << "- aggregation_entries = " << GlobalParams::aggregation_entries
+       << endl
+       << "- tile_replacement = " << GlobalParams::tile_replacement << endl
+       << "- pack_subtasks = " << GlobalParams::pack_subtasks << endl
        << "- packet_injection_rate = " << GlobalParams::packet_injection_rate
        << endl
        << "- probability_of_retransmission = "
@@ -683,6 +903,22 @@ void checkConfiguration()
     }
   }
 
+  if (!GlobalParams::replay_trace_filename.empty())
+  {
+    if (!GlobalParams::injection_trace_filename.empty())
+    {
+      cerr << "Error: -record_injections and -replay are mutually exclusive"
+           << endl;
+      exit(1);
+    }
+    if (GlobalParams::ideal_transport)
+    {
+      cerr << "Error: replay mode requires the NoC, disable ideal_transport"
+           << endl;
+      exit(1);
+    }
+  }
+
   if (GlobalParams::buffer_depth < 1)
   {
     cerr << "Error: buffer must be >= 1" << endl;
@@ -712,6 +948,26 @@ void checkConfiguration()
     exit(1);
   }
 
+  if (!Allocator::isValid(GlobalParams::allocator))
+  {
+    cerr << "Error: invalid allocator " << GlobalParams::allocator << endl;
+    exit(1);
+  }
+
+  if (GlobalParams::aggregation_entries < 1)
+  {
+    cerr << "Error: aggregation_entries must be at least 1" << endl;
+    exit(1);
+  }
+
+  TileReplacementPolicy tile_policy;
+  if (!ParseTileReplacementPolicy(GlobalParams::tile_replacement, tile_policy))
+  {
+    cerr << "Error: invalid tile replacement policy "
+         << GlobalParams::tile_replacement << endl;
+    exit(1);
+  }
+
   if (GlobalParams::packet_injection_rate <= 0.0 ||
       GlobalParams::packet_injection_rate > 1.0)
   {
@@ -807,6 +1063,35 @@ void checkConfiguration()
          << "GlobalParams.h and compile again " << endl;
     exit(1);
   }
+  if (GlobalParams::topology == TOPOLOGY_HIERARCHICAL)
+  {
+    const std::vector<LevelConfig> &levels =
+        GlobalParams::hierarchical_config.levels;
+    int output = static_cast<int>(DataType::OUTPUT);
+    for (const LevelConfig &level_config : levels)
+    {
+      for (int t = 0; t < NUM_DATA_TYPES && level_config.has_vc_map; t++)
+      {
+        if (level_config.vc_of_type[t] >= GlobalParams::n_virtual_channels)
+        {
+          cerr << "Error: vc_map of level " << level_config.level
+               << " uses VC " << level_config.vc_of_type[t] << " but only "
+               << GlobalParams::n_virtual_channels
+               << " virtual channels are configured" << endl;
+          exit(1);
+        }
+      }
+      // 回送包逐层聚合且不换 VC
+      if (level_config.vc_of_type[output] != levels[0].vc_of_type[output])
+      {
+        cerr << "Error: vc_map Outputs of level " << level_config.level
+             << " differs from level " << levels[0].level
+             << " (return packets are aggregated on one VC)" << endl;
+        exit(1);
+      }
+    }
+  }
+
   if (GlobalParams::n_virtual_channels > 1 && GlobalParams::use_powermanager)
   {
     cerr << "Error: Power manager (-wirxsleep) option only supports a single "
@@ -836,12 +1121,18 @@ void parseCmdLine(int arg_num, char *arg_vet[])
     for (int i = 1; i < arg_num; i++)
     {
       if (!strcmp(arg_vet[i], "-verbose"))
-        GlobalParams::verbose_mode = atoi(arg_vet[++i]);
+        GlobalParams::verbose_mode = arg_vet[++i];
+      else if (!strcmp(arg_vet[i], "-log_sync"))
+        GlobalParams::log_sync = true;
       else if (!strcmp(arg_vet[i], "-trace"))
       {
         GlobalParams::trace_mode = true;
         GlobalParams::trace_filename = arg_vet[++i];
       }
+      else if (!strcmp(arg_vet[i], "-record_injections"))
+        GlobalParams::injection_trace_filename = arg_vet[++i];
+      else if (!strcmp(arg_vet[i], "-replay"))
+        GlobalParams::replay_trace_filename = arg_vet[++i];
       else if (!strcmp(arg_vet[i], "-dimx"))
         GlobalParams::mesh_dim_x = atoi(arg_vet[++i]);
       else if (!strcmp(arg_vet[i], "-dimy"))
@@ -897,6 +1188,20 @@ void parseCmdLine(int arg_num, char *arg_vet[])
       {
         GlobalParams::selection_strategy = arg_vet[++i];
       }
+      else if (!strcmp(arg_vet[i], "-allocator"))
+      {
+        GlobalParams::allocator = arg_vet[++i];
+      }
+      else if (!strcmp(arg_vet[i], "-aggregation_entries"))
+      {
+        GlobalParams::aggregation_entries = atoi(arg_vet[++i]);
+      }
+      else if (!strcmp(arg_vet[i], "-tile_replacement"))
+      {
+        GlobalParams::tile_replacement = arg_vet[++i];
+      }
+      else if (!strcmp(arg_vet[i], "-pack_subtasks"))
+        GlobalParams::pack_subtasks = true;
       else if (!strcmp(arg_vet[i], "-pir"))
       {
 
@@ -971,6 +1276,8 @@ void parseCmdLine(int arg_num, char *arg_vet[])
         GlobalParams::detailed = true;
       else if (!strcmp(arg_vet[i], "-show_buf_stats"))
         GlobalParams::show_buffer_stats = true;
+      else if (!strcmp(arg_vet[i], "-profile"))
+        GlobalParams::profile = true;
       else if (!strcmp(arg_vet[i], "-volume"))
         GlobalParams::max_volume_to_be_drained = atoi(arg_vet[++i]);
       else if (!strcmp(arg_vet[i], "-sim"))
@@ -1060,9 +1367,13 @@ void configure(int arg_num, char *arg_vet[])
   parseCmdLine(arg_num, arg_vet);
 
   checkConfiguration();
+  noxim_log::configure(GlobalParams::verbose_mode);
+  noxim_log::setSynchronous(GlobalParams::log_sync);
+  if (GlobalParams::profile)
+    Profiler::enable(GlobalParams::num_levels);
 
   // Show configuration
-  if (GlobalParams::verbose_mode > VERBOSE_OFF)
+  if (noxim_log::max_enabled_level > noxim_log::LVL_OFF)
     showConfig();
 }
 
@@ -54,16 +54,17 @@ struct Packet
   int src_id;
   int dst_id;
   int vc_id;
-  int logical_timestamp; // SC timestamp at packet generation
+  int logical_timestamp = 0; // SC timestamp at packet generation
   int size;
   int flit_left; // Number of remaining flits inside the packet
   bool use_low_voltage_path;
 
   int payload_data_size; // 用来表示整个Packet的真实数据大小（以字节为单位）
-  int payload_sizes[3];  // 索引0: INPUT, 1: WEIGHT, 2: OUTPUT
+  int payload_sizes[3] = {0, 0, 0}; // 索引0: INPUT, 1: WEIGHT, 2: OUTPUT
   DataType data_type;    // Packet的数据类型（FILL或DELTA）
   int command;           // 用于存储来自txprocess的命令 (timestamp,command)
   PE_Role target_role;
+  unsigned int packet_id = 0; // 全局唯一的包编号，HEAD flit 生成时分配
 
   Packet(const Packet &other) = default;
   Packet &operator=(const Packet &other) = default;
@@ -211,6 +212,7 @@ struct Flit
   // **********************************
 
   int hub_relay_node = -1;
+  unsigned int packet_id = 0; // 所属 Packet 的编号 (flit trace 使用)
 
   // 比较运算符保持不变
   inline bool operator==(const Flit &flit) const
@@ -11,6 +11,7 @@ enum class DataType
   OUTPUT,
   UNKNOWN
 };
+const int NUM_DATA_TYPES = static_cast<int>(DataType::UNKNOWN) + 1;
 
 inline const char *DataType_to_str(DataType type)
 {
@@ -91,6 +92,14 @@ struct RoutingPattern
   int forward_count = 1;
 };
 
+// VC 之间的仲裁 (LevelConfig::vc_arbitration)，见 VcArbiter.h
+enum VcArbitration
+{
+  VC_ARB_ROUND_ROBIN,
+  VC_ARB_WEIGHTED,
+  VC_ARB_PRIORITY
+};
+
 struct LevelConfig
 {
   int level;
@@ -98,6 +107,37 @@ struct LevelConfig
   int bandwidth;
   int bank_count = 1; // 新增: DRAM 层的 bank 数量，用于并行度计算
   bool aggregate;
+  // 本层 DOWN 链路 (本层 <-> 下一层) 的流控方式：false 为 ABP +
+  // TBufferFullStatus，true 为按 VC 计数的信用流控 (flow_control: credit)
+  bool credit_flow_control = false;
+  int link_latency = 1; // 本层 DOWN 链路的单向延迟 (周期)
+  // 本层的时钟周期 (clock_period_ps)，0 表示使用全局时钟。与相邻层周期不同
+  // 时，层间链路为跨时钟域 FIFO，接收侧经过 cdc_sync_stages 级同步器
+  // (cdc_sync_stages 作用于本层的 DOWN 链路)
+  int clock_period_ps = 0;
+  int cdc_sync_stages = 2;
+  // 本层缓冲区双缓冲 (ping-pong)：buffer_size 为一个 bank 的容量，另有一个
+  // 同样大小的 bank 在计算/分发当前时间步时接收下一时间步的数据
+  bool double_buffer = false;
+  // 存储层 (DRAM/GLB) 在当前时间步完成之前最多向前分发的时间步数，
+  // 受目标层缓冲区容量和同步点限制；0 为逐时间步分发
+  int prefetch_depth = 0;
+  // 每种数据类型收发使用的 LOCAL 端口 (0: PRIMARY, 1: SECONDARY)，由
+  // local_ports 配置。只有用到 SECONDARY 的层才创建第二对 LOCAL 链路
+  int local_port[NUM_DATA_TYPES] = {};
+  int num_local_ports = 1;
+  // 本层 PE 发出的包按数据类型使用的 VC (vc_map)，默认 INPUT 1 / WEIGHT 0 /
+  // OUTPUT 2。回送包逐层聚合且不换 VC，OUTPUT 的 VC 在各层必须一致
+  int vc_of_type[NUM_DATA_TYPES] = {1, 0, 2, 0};
+  bool has_vc_map = false;
+  // 本层 PE 发送和 router 转发时 VC 之间的仲裁 (vc_arbitration)。
+  // vc_weights[vc] 为 WEIGHTED 下每轮可连续发送的 flit 数，或 PRIORITY 下的
+  // 优先级 (大者优先)；缺省为 1
+  VcArbitration vc_arbitration = VC_ARB_ROUND_ROBIN;
+  std::vector<int> vc_weights;
+  // fanouts 为列表时本层每个节点各自的子节点数 (按节点 ID 顺序)，
+  // 为空表示本层所有节点都使用 fanouts_per_level[level]
+  std::vector<int> node_fanouts;
   PE_Role roles;
 
   // 新增:该层的路由模式配置(可选)
@@ -0,0 +1,57 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the binary flit trace recorder
+ */
+
+#include "FlitTrace.h"
+
+#include <cstring>
+#include <iostream>
+
+FILE *FlitTrace::file_ = nullptr;
+std::vector<FlitTraceRecord> FlitTrace::buffer_;
+unsigned long FlitTrace::records_written_ = 0;
+
+bool FlitTrace::open(const std::string &filename, int clock_period_ps) {
+  close();
+
+  file_ = fopen(filename.c_str(), "wb");
+  if (file_ == nullptr) {
+    std::cerr << "Error: cannot open flit trace file '" << filename << "'"
+              << std::endl;
+    return false;
+  }
+
+  FlitTraceHeader header;
+  memcpy(header.magic, FLIT_TRACE_MAGIC, 4);
+  header.version = FLIT_TRACE_VERSION;
+  header.clock_period_ps = clock_period_ps;
+  header.record_size = sizeof(FlitTraceRecord);
+  fwrite(&header, sizeof(header), 1, file_);
+
+  buffer_.clear();
+  buffer_.reserve(BUFFER_RECORDS);
+  records_written_ = 0;
+  return true;
+}
+
+void FlitTrace::flush() {
+  if (file_ == nullptr || buffer_.empty())
+    return;
+  fwrite(buffer_.data(), sizeof(FlitTraceRecord), buffer_.size(), file_);
+  records_written_ += buffer_.size();
+  buffer_.clear();
+}
+
+void FlitTrace::close() {
+  if (file_ == nullptr)
+    return;
+  flush();
+  fclose(file_);
+  file_ = nullptr;
+}
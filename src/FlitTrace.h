@@ -0,0 +1,90 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the binary flit trace recorder.
+ * The record layout is shared with other/flit_trace_analyzer.cpp, so this
+ * header must not depend on SystemC.
+ */
+
+#ifndef __NOXIMFLITTRACE_H__
+#define __NOXIMFLITTRACE_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define FLIT_TRACE_MAGIC "NXFT"
+#define FLIT_TRACE_VERSION 1
+
+enum FlitTraceEvent {
+  FT_INJECT = 0,    // PE 把 flit 写到本地端口
+  FT_ROUTER_RX = 1, // Router 把 flit 推入输入缓冲区
+  FT_ROUTER_TX = 2, // Router 把 flit 写到输出端口 (多播时每个端口一条)
+  FT_EJECT = 3      // PE 从本地端口收到 flit
+};
+
+#pragma pack(push, 1)
+struct FlitTraceHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t clock_period_ps;
+  uint32_t record_size;
+};
+
+struct FlitTraceRecord {
+  uint64_t cycle;
+  int32_t node;
+  int16_t port; // 逻辑端口索引 (UP, LOCAL, DOWN_0...)，PE 事件为 0
+  uint8_t vc;
+  uint8_t flit_type;
+  uint32_t packet_id;
+  uint8_t event;     // FlitTraceEvent
+  uint8_t data_type; // DataType
+  int16_t command;
+};
+#pragma pack(pop)
+
+class FlitTrace {
+public:
+  static bool open(const std::string &filename, int clock_period_ps);
+  static void close();
+
+  // 热路径上唯一的开销：未开启 trace 时只是一次指针判空
+  static bool enabled() { return file_ != nullptr; }
+
+  static void record(uint64_t cycle, int node, int port, int vc, int flit_type,
+                     uint32_t packet_id, int data_type, int command,
+                     FlitTraceEvent event) {
+    FlitTraceRecord r;
+    r.cycle = cycle;
+    r.node = node;
+    r.port = static_cast<int16_t>(port);
+    r.vc = static_cast<uint8_t>(vc);
+    r.flit_type = static_cast<uint8_t>(flit_type);
+    r.packet_id = packet_id;
+    r.event = static_cast<uint8_t>(event);
+    r.data_type = static_cast<uint8_t>(data_type);
+    r.command = static_cast<int16_t>(command);
+    buffer_.push_back(r);
+    if (buffer_.size() >= BUFFER_RECORDS)
+      flush();
+  }
+
+  static void flush();
+
+  static unsigned long recordsWritten() { return records_written_; }
+
+private:
+  static const size_t BUFFER_RECORDS = 1 << 16;
+
+  static FILE *file_;
+  static std::vector<FlitTraceRecord> buffer_;
+  static unsigned long records_written_;
+};
+
+#endif
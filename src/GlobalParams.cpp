@@ -9,6 +9,7 @@
  */
 
 #include "GlobalParams.h"
+#include "Allocator.h"
 
 string GlobalParams::verbose_mode;
 int GlobalParams::trace_mode;
@@ -30,6 +31,10 @@ int GlobalParams::max_packet_size;
 string GlobalParams::routing_algorithm;
 string GlobalParams::routing_table_filename;
 string GlobalParams::selection_strategy;
+string GlobalParams::allocator = ALLOCATOR_ROUND_ROBIN;
+int GlobalParams::aggregation_entries = DEFAULT_AGGREGATION_ENTRIES;
+string GlobalParams::tile_replacement = "LRU";
+bool GlobalParams::pack_subtasks = false;
 double GlobalParams::packet_injection_rate;
 double GlobalParams::probability_of_retransmission;
 double GlobalParams::locality;
@@ -48,6 +53,8 @@ double GlobalParams::dyad_threshold;
 unsigned int GlobalParams::max_volume_to_be_drained;
 vector<pair<int, double>> GlobalParams::hotspots;
 bool GlobalParams::show_buffer_stats;
+bool GlobalParams::profile = false;
+bool GlobalParams::log_sync = false;
 bool GlobalParams::use_winoc;
 int GlobalParams::winoc_dst_hops;
 bool GlobalParams::use_powermanager;
@@ -67,7 +74,8 @@ int GlobalParams::word_bits;
 
 int *GlobalParams::node_level_map = nullptr;
 int *GlobalParams::parent_map = nullptr;
-int **GlobalParams::child_map = nullptr;
+int *GlobalParams::child_offsets = nullptr;
+int *GlobalParams::child_list = nullptr;
 int GlobalParams::total_hierarchical_nodes = 0;
 int GlobalParams::num_nodes = 0;
 
@@ -83,4 +91,6 @@ map<int, int> GlobalParams::compute_to_storage_map;
 string GlobalParams::transmission_mode =
     "optimized"; // Default to optimized mode
 bool GlobalParams::ideal_transport = false;
+string GlobalParams::injection_trace_filename;
+string GlobalParams::replay_trace_filename;
 vector<ProcessingElement *> GlobalParams::pe_registry;
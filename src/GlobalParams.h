@@ -38,8 +38,13 @@ class ProcessingElement;
 #define DIRECTION_WIRELESS 747
 
 #define MAX_VIRTUAL_CHANNELS 8
+// PE 与 router 之间 LOCAL 端口的上限 (0: PRIMARY, 1: SECONDARY)
+#define NUM_LOCAL_PORTS 2
 #define DEFAULT_VC 0
 
+// 聚合 router 同时收集的回送 flit 位置 (logical_timestamp, sequence_no) 数
+#define DEFAULT_AGGREGATION_ENTRIES 16
+
 #define RT_AVAILABLE 1
 #define RT_ALREADY_SAME -1
 #define RT_ALREADY_OTHER_OUT -2
@@ -160,6 +165,10 @@ struct GlobalParams {
   static string routing_algorithm;
   static string routing_table_filename;
   static string selection_strategy;
+  static string allocator; // router 阶段B 的交换分配器
+  static int aggregation_entries; // 每个聚合 router 同时进行的回送聚合条目上限
+  static string tile_replacement; // 存储层驻留 tile 的替换策略 (LRU/BELADY/LIVENESS)
+  static bool pack_subtasks; // 同一时间步、同一目标且路由相同的子任务打包成一个包
   static double packet_injection_rate;
   static double probability_of_retransmission;
   static double locality;
@@ -178,6 +187,8 @@ struct GlobalParams {
   static double dyad_threshold;
   static unsigned int max_volume_to_be_drained;
   static bool show_buffer_stats;
+  static bool profile; // 输出仿真器自身的耗时剖析
+  static bool log_sync; // 日志同步写出 (调试用)
   static bool use_winoc;
   static int winoc_dst_hops;
   static bool use_powermanager;
@@ -199,10 +210,39 @@ struct GlobalParams {
   // Hierarchical topology mapping
   static int *node_level_map;          // 节点->层级映射
   static int *parent_map;              // 节点->父节点映射
-  static int **child_map;              // 节点->子节点映射
-  static int *child_map_size;          // 记录每个节点的子节点数量
+  // 节点->子节点映射 (CSR)：节点 i 的子节点为
+  // child_list[child_offsets[i] .. child_offsets[i+1])，同一父节点的子节点 ID 连续
+  static int *child_offsets;
+  static int *child_list;
   static int total_hierarchical_nodes; // 总层次化节点数
 
+  // 位于 level 层的节点 node_id 的子节点数。拓扑未构建 (child_offsets 为空)
+  // 时按该层统一的 fanout 计算
+  static int numChildren(int node_id, int level)
+  {
+    if (child_offsets == nullptr)
+      return fanouts_per_level[level];
+    return child_offsets[node_id + 1] - child_offsets[node_id];
+  }
+  static const int *childrenOf(int node_id)
+  {
+    return child_list + child_offsets[node_id];
+  }
+  // 节点在父节点子节点中的序号 (父节点的 DOWN 端口序号)
+  static int childIndexOf(int node_id)
+  {
+    return node_id - child_list[child_offsets[parent_map[node_id]]];
+  }
+
+  // level 层的时钟周期 (ps)，未单独配置或不是层次化层级时为全局周期
+  static int levelClockPeriod(int level)
+  {
+    if (level >= 0 && level < (int)hierarchical_config.levels.size() &&
+        hierarchical_config.levels[level].clock_period_ps > 0)
+      return hierarchical_config.levels[level].clock_period_ps;
+    return clock_period_ps;
+  }
+
   static WorkloadConfig workload;
   static map<PE_Role, RoleChannelCapabilities> CapabilityMap;
 
@@ -217,6 +257,11 @@ struct GlobalParams {
   // Ideal transport mode: bypass NoC flit/link traversal and directly
   // transfer packet payloads to destination PE accounting.
   static bool ideal_transport;
+
+  // Injection trace: record PE packet injections of a full run, or replay
+  // them in network-only mode (ReplayPE replaces ProcessingElement).
+  static string injection_trace_filename;
+  static string replay_trace_filename;
   static vector<ProcessingElement *> pe_registry;
 };
 
@@ -9,6 +9,7 @@
  */
 
 #include "GlobalStats.h"
+#include "Profiler.h"
 #include <unordered_map>
 using namespace std;
 
@@ -375,7 +376,8 @@ void GlobalStats::showStats(std::ostream &out, bool detailed) {
 
   if (GlobalParams::topology == TOPOLOGY_HIERARCHICAL) {
     for (int i = 0; i < GlobalParams::num_nodes; i++)
-      out << "PE" << i << ": " << noc->t[i]->pe->getQueueSize() << ",";
+      if (noc->t[i]->pe)
+        out << "PE" << i << ": " << noc->t[i]->pe->getQueueSize() << ",";
   } else // other delta topologies
   {
   }
@@ -419,6 +421,9 @@ void GlobalStats::showStats(std::ostream &out, bool detailed) {
 
     // 收集每层的统计数据
     for (int i = 0; i < GlobalParams::num_nodes; i++) {
+      // 回放模式下没有 ProcessingElement，也就没有数据等待统计
+      if (noc->t[i]->pe == nullptr)
+        continue;
       int level = GlobalParams::node_level_map[i];
       const auto &wait_stats = noc->t[i]->pe->getDataWaitStats();
       size_t total_wait = noc->t[i]->pe->getTotalWaitCycles();
@@ -449,6 +454,163 @@ void GlobalStats::showStats(std::ostream &out, bool detailed) {
         }
       }
     }
+
+    showTileStats(out);
+    showBankStats(out);
+    showPrefetchStats(out);
+    showPackingStats(out);
+    showLocalPortStats(out);
+  }
+
+  // 构建 (elaboration) 时间随节点数增长，不依赖 -profile 始终输出
+  double elaboration_s = Profiler::phaseSeconds(PHASE_ELABORATION);
+  out << "% Elaboration time (s): " << elaboration_s << " ("
+      << GlobalParams::num_nodes << " nodes, "
+      << (elaboration_s > 0 ? GlobalParams::num_nodes / elaboration_s : 0.0)
+      << " nodes/s)" << endl;
+
+  // 仿真器自身性能 (-profile)，便于跨版本追踪性能回退
+  Profiler::report(out);
+}
+
+void GlobalStats::showTileStats(std::ostream &out) {
+  std::vector<TileStats> layer_tiles(GlobalParams::num_levels);
+  std::vector<int> layer_node_count(GlobalParams::num_levels, 0);
+
+  for (int i = 0; i < GlobalParams::num_nodes; i++) {
+    if (noc->t[i]->pe == nullptr)
+      continue;
+    const TileStats *tiles = noc->t[i]->pe->getTileStats();
+    if (tiles == nullptr)
+      continue;
+    int level = GlobalParams::node_level_map[i];
+    layer_tiles[level] += *tiles;
+    layer_node_count[level]++;
+  }
+
+  for (int level = 0; level < GlobalParams::num_levels; level++) {
+    const TileStats &s = layer_tiles[level];
+    if (layer_node_count[level] == 0 || s.hits + s.misses == 0)
+      continue;
+    out << "% Level " << level << " Tile residency ("
+        << GlobalParams::tile_replacement << "): " << s.hits << " hits, "
+        << s.misses << " misses, hit rate "
+        << (double)s.hits / (s.hits + s.misses) << endl;
+    out << "%   Refetched bytes: " << s.miss_bytes << " (hit bytes "
+        << s.hit_bytes << "), evictions: " << s.evictions << " ("
+        << s.evicted_bytes << " bytes), bypassed tiles: " << s.bypasses
+        << endl;
+  }
+}
+
+void GlobalStats::showBankStats(std::ostream &out) {
+  std::vector<BankStats> layer_banks(GlobalParams::num_levels);
+  std::vector<int> layer_node_count(GlobalParams::num_levels, 0);
+
+  for (int i = 0; i < GlobalParams::num_nodes; i++) {
+    if (noc->t[i]->pe == nullptr)
+      continue;
+    const BankStats *banks = noc->t[i]->pe->getBankStats();
+    if (banks == nullptr)
+      continue;
+    int level = GlobalParams::node_level_map[i];
+    layer_banks[level] += *banks;
+    layer_node_count[level]++;
+  }
+
+  // 重叠字节：计算/分发当前时间步期间提前收到的下一时间步数据
+  for (int level = 0; level < GlobalParams::num_levels; level++) {
+    const BankStats &s = layer_banks[level];
+    if (layer_node_count[level] == 0)
+      continue;
+    out << "% Level " << level << " Double buffering: " << s.overlapped_bytes
+        << " of " << s.received_bytes << " received bytes overlapped ("
+        << (s.received_bytes ? 100.0 * s.overlapped_bytes / s.received_bytes
+                             : 0.0)
+        << "%), " << (double)s.swaps / layer_node_count[level]
+        << " bank swaps per node" << endl;
+  }
+}
+
+void GlobalStats::showPrefetchStats(std::ostream &out) {
+  std::vector<size_t> layer_dispatched(GlobalParams::num_levels, 0);
+  std::vector<size_t> layer_prefetched(GlobalParams::num_levels, 0);
+
+  for (int i = 0; i < GlobalParams::num_nodes; i++) {
+    if (noc->t[i]->pe == nullptr)
+      continue;
+    int level = GlobalParams::node_level_map[i];
+    layer_dispatched[level] += noc->t[i]->pe->getDispatchedPackets();
+    layer_prefetched[level] += noc->t[i]->pe->getPrefetchedPackets();
+  }
+
+  // 预取的包：在前面的时间步完成之前就已入队
+  for (int level = 0; level < GlobalParams::num_levels; level++) {
+    const LevelConfig &level_config =
+        GlobalParams::hierarchical_config.get_level_config(level);
+    if (level_config.prefetch_depth == 0 || layer_dispatched[level] == 0)
+      continue;
+    out << "% Level " << level << " Prefetch (depth "
+        << level_config.prefetch_depth << "): " << layer_prefetched[level]
+        << " of " << layer_dispatched[level] << " dispatched packets ("
+        << 100.0 * layer_prefetched[level] / layer_dispatched[level]
+        << "%) issued ahead of their timestep" << endl;
+  }
+}
+
+void GlobalStats::showPackingStats(std::ostream &out) {
+  if (!GlobalParams::pack_subtasks)
+    return;
+
+  std::vector<size_t> layer_dispatched(GlobalParams::num_levels, 0);
+  std::vector<size_t> layer_packed(GlobalParams::num_levels, 0);
+
+  for (int i = 0; i < GlobalParams::num_nodes; i++) {
+    if (noc->t[i]->pe == nullptr)
+      continue;
+    int level = GlobalParams::node_level_map[i];
+    layer_dispatched[level] += noc->t[i]->pe->getDispatchedPackets();
+    layer_packed[level] += noc->t[i]->pe->getPackedSubtasks();
+  }
+
+  // 每个合入的子任务省去一对 HEAD/TAIL flit
+  for (int level = 0; level < GlobalParams::num_levels; level++) {
+    if (layer_dispatched[level] == 0)
+      continue;
+    out << "% Level " << level << " Sub-task packing: "
+        << layer_dispatched[level] + layer_packed[level] << " sub-tasks in "
+        << layer_dispatched[level] << " packets, "
+        << 2 * layer_packed[level] << " header/tail flits saved" << endl;
+  }
+}
+
+void GlobalStats::showLocalPortStats(std::ostream &out) {
+  // [level][port] PE 注入 (PE -> router) / 接收 (router -> PE) 的 flit 数
+  std::vector<std::vector<unsigned long>> injected(
+      GlobalParams::num_levels, std::vector<unsigned long>(NUM_LOCAL_PORTS, 0));
+  std::vector<std::vector<unsigned long>> ejected = injected;
+
+  for (int i = 0; i < GlobalParams::num_nodes; i++) {
+    int level = GlobalParams::node_level_map[i];
+    for (int p = 0; p < NUM_LOCAL_PORTS; p++) {
+      if (noc->t[i]->local_link_p2r[p] == nullptr)
+        continue;
+      injected[level][p] += noc->t[i]->local_link_p2r[p]->transferredFlits();
+      ejected[level][p] += noc->t[i]->local_link_r2p[p]->transferredFlits();
+    }
+  }
+
+  // 只列出使用了 SECONDARY 端口的层
+  for (int level = 0; level < GlobalParams::num_levels; level++) {
+    const LevelConfig &level_config =
+        GlobalParams::hierarchical_config.get_level_config(level);
+    if (level_config.num_local_ports < 2)
+      continue;
+    out << "% Level " << level << " LOCAL ports (injected/ejected flits):";
+    for (int p = 0; p < level_config.num_local_ports; p++)
+      out << (p == 0 ? " PRIMARY " : " SECONDARY ") << injected[level][p]
+          << "/" << ejected[level][p];
+    out << endl;
   }
 }
 
@@ -637,7 +799,11 @@ void GlobalStats::showLayerStats(std::ostream &out) {
     out << "%   Average delay: " << layer_avg_delay[level] << " cycles" << endl;
     out << "%   Average throughput: " << layer_avg_throughput[level]
         << " flits/cycle" << endl;
-    out << "%   Node count: " << GlobalParams::fanouts_per_level[level] << endl;
+    int node_count = 0;
+    for (int i = 0; i < GlobalParams::num_nodes; i++)
+      if (GlobalParams::node_level_map[i] == level)
+        node_count++;
+    out << "%   Node count: " << node_count << endl;
   }
 }
 
@@ -91,6 +91,12 @@ public:
 
   // 层级统计函数
   void showLayerStats(std::ostream &out);
+  // 存储层驻留 tile 的命中/缺失 (按层聚合)
+  void showTileStats(std::ostream &out);
+  void showBankStats(std::ostream &out);
+  void showPrefetchStats(std::ostream &out);
+  void showPackingStats(std::ostream &out);
+  void showLocalPortStats(std::ostream &out);
   std::vector<double> getLayerAverageDelay();
   std::vector<double> getLayerAverageThroughput();
 
@@ -669,11 +669,11 @@ int Hub::selectChannel(int src_hub, int dst_hub) const
 	    return NOT_VALID;
 
 	if (GlobalParams::channel_selection==CHSEL_RANDOM)
-		return intersection[rand()%intersection.size()];
+		return intersection[rng.below(intersection.size())];
 	else
 	if (GlobalParams::channel_selection==CHSEL_FIRST_FREE)
 	{
-		int start_channel = rand()%intersection.size();
+		int start_channel = rng.below(intersection.size());
 		int k;
 
 		for (vector<int>::size_type i=0;i<intersection.size();i++)
@@ -687,7 +687,7 @@ int Hub::selectChannel(int src_hub, int dst_hub) const
 			}
 		}
 		cout << "All channel busy, applying random selection " << endl;
-		return intersection[rand()%intersection.size()];
+		return intersection[rng.below(intersection.size())];
 	}
 
 	return NOT_VALID;
@@ -21,6 +21,7 @@
 #include "Target.h"
 #include "TokenRing.h"
 #include "Power.h"
+#include "Rng.h"
 
 using namespace std;
 
@@ -33,6 +34,7 @@ SC_MODULE(Hub)
     sc_in<bool> reset; // The reset signal for the tile
 
     int local_id; // Unique ID
+    mutable RngStream rng; // 信道选择使用的独立随机数流
     TokenRing *token_ring;
     int num_ports;
     vector<int> attachedNodes;
@@ -110,6 +112,7 @@ SC_MODULE(Hub)
         }
 
         local_id = id;
+        rng = RngService::stream(RNG_DOMAIN_HUB, id);
         token_ring = tr;
         num_ports = GlobalParams::hub_configuration[local_id].attachedNodes.size();
         attachedNodes = GlobalParams::hub_configuration[local_id].attachedNodes;
@@ -0,0 +1,137 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the PE injection trace
+ */
+
+#include "InjectionTrace.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FILE *InjectionTrace::out_ = nullptr;
+std::vector<InjectionTraceRecord> InjectionTrace::out_buffer_;
+
+void *InjectionTrace::map_base_ = nullptr;
+size_t InjectionTrace::map_length_ = 0;
+const InjectionTraceRecord *InjectionTrace::records_ = nullptr;
+size_t InjectionTrace::n_records_ = 0;
+std::vector<std::vector<uint32_t>> InjectionTrace::node_index_;
+
+bool InjectionTrace::openForRecord(const std::string &filename,
+                                   int num_nodes) {
+  closeRecord();
+
+  out_ = fopen(filename.c_str(), "wb");
+  if (out_ == nullptr) {
+    std::cerr << "Error: cannot open injection trace file '" << filename
+              << "' for writing" << std::endl;
+    return false;
+  }
+
+  InjectionTraceHeader header;
+  memcpy(header.magic, INJECTION_TRACE_MAGIC, 4);
+  header.version = INJECTION_TRACE_VERSION;
+  header.record_size = sizeof(InjectionTraceRecord);
+  header.num_nodes = num_nodes;
+  fwrite(&header, sizeof(header), 1, out_);
+
+  out_buffer_.clear();
+  out_buffer_.reserve(BUFFER_RECORDS);
+  return true;
+}
+
+void InjectionTrace::flushRecord() {
+  if (out_ == nullptr || out_buffer_.empty())
+    return;
+  fwrite(out_buffer_.data(), sizeof(InjectionTraceRecord), out_buffer_.size(),
+         out_);
+  out_buffer_.clear();
+}
+
+void InjectionTrace::closeRecord() {
+  if (out_ == nullptr)
+    return;
+  flushRecord();
+  fclose(out_);
+  out_ = nullptr;
+}
+
+bool InjectionTrace::openForReplay(const std::string &filename) {
+  closeReplay();
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Error: cannot open replay trace '" << filename << "'"
+              << std::endl;
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(InjectionTraceHeader)) {
+    std::cerr << "Error: replay trace '" << filename << "' is empty"
+              << std::endl;
+    close(fd);
+    return false;
+  }
+
+  map_length_ = st.st_size;
+  map_base_ = mmap(nullptr, map_length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map_base_ == MAP_FAILED) {
+    std::cerr << "Error: cannot mmap replay trace '" << filename << "'"
+              << std::endl;
+    map_base_ = nullptr;
+    return false;
+  }
+
+  const InjectionTraceHeader *header =
+      static_cast<const InjectionTraceHeader *>(map_base_);
+  if (memcmp(header->magic, INJECTION_TRACE_MAGIC, 4) != 0 ||
+      header->version != INJECTION_TRACE_VERSION ||
+      header->record_size != sizeof(InjectionTraceRecord)) {
+    std::cerr << "Error: '" << filename
+              << "' is not a compatible injection trace" << std::endl;
+    closeReplay();
+    return false;
+  }
+
+  records_ = reinterpret_cast<const InjectionTraceRecord *>(
+      static_cast<const char *>(map_base_) + sizeof(InjectionTraceHeader));
+  n_records_ =
+      (map_length_ - sizeof(InjectionTraceHeader)) / sizeof(InjectionTraceRecord);
+
+  // 记录本身按周期有序写入，这里只需按源节点分桶
+  node_index_.assign(header->num_nodes, std::vector<uint32_t>());
+  for (size_t i = 0; i < n_records_; i++) {
+    int src = records_[i].src_id;
+    if (src < 0 || src >= (int)header->num_nodes) {
+      std::cerr << "Error: replay record " << i << " has invalid src_id "
+                << src << std::endl;
+      closeReplay();
+      return false;
+    }
+    node_index_[src].push_back(i);
+  }
+
+  madvise(map_base_, map_length_, MADV_SEQUENTIAL);
+  return true;
+}
+
+void InjectionTrace::closeReplay() {
+  if (map_base_ != nullptr)
+    munmap(map_base_, map_length_);
+  map_base_ = nullptr;
+  map_length_ = 0;
+  records_ = nullptr;
+  n_records_ = 0;
+  node_index_.clear();
+}
@@ -0,0 +1,98 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the PE injection trace, used to
+ * record the packets generated by ProcessingElement in a full run and to
+ * replay them through ReplayPE in network-only mode.
+ */
+
+#ifndef __NOXIMINJECTIONTRACE_H__
+#define __NOXIMINJECTIONTRACE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define INJECTION_TRACE_MAGIC "NXIT"
+#define INJECTION_TRACE_VERSION 1
+
+#pragma pack(push, 1)
+struct InjectionTraceHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t num_nodes;
+};
+
+// 一条记录对应 PE 推入发送队列的一个 Packet
+struct InjectionTraceRecord {
+  uint64_t cycle;
+  int32_t src_id;
+  int32_t size;              // flit 数 (含 HEAD/TAIL)
+  int32_t payload_data_size; // 字节
+  int32_t command;
+  int32_t logical_timestamp;
+  int32_t payload_sizes[3];
+  int8_t target_role; // PE_Role
+  int8_t data_type;   // DataType
+  int8_t vc_id;
+  int8_t reserved;
+};
+#pragma pack(pop)
+
+class InjectionTrace {
+public:
+  //--------------------------------------------------------------------
+  // 记录 (全模型运行时)
+  //--------------------------------------------------------------------
+  static bool openForRecord(const std::string &filename, int num_nodes);
+  static bool recording() { return out_ != nullptr; }
+  static void record(const InjectionTraceRecord &r) {
+    out_buffer_.push_back(r);
+    if (out_buffer_.size() >= BUFFER_RECORDS)
+      flushRecord();
+  }
+  static void closeRecord();
+
+  //--------------------------------------------------------------------
+  // 回放：整个文件 mmap 到内存，按源节点建立索引
+  //--------------------------------------------------------------------
+  static bool openForReplay(const std::string &filename);
+  static void closeReplay();
+
+  // 节点 node_id 的第 k 条记录，越界时返回 nullptr
+  static const InjectionTraceRecord *recordOf(int node_id, size_t k) {
+    if (node_id < 0 || node_id >= (int)node_index_.size() ||
+        k >= node_index_[node_id].size())
+      return nullptr;
+    return &records_[node_index_[node_id][k]];
+  }
+  static size_t recordsOf(int node_id) {
+    return (node_id >= 0 && node_id < (int)node_index_.size())
+               ? node_index_[node_id].size()
+               : 0;
+  }
+  static size_t totalRecords() { return n_records_; }
+  static int numNodes() { return (int)node_index_.size(); }
+
+private:
+  static const size_t BUFFER_RECORDS = 1 << 14;
+  static void flushRecord();
+
+  static FILE *out_;
+  static std::vector<InjectionTraceRecord> out_buffer_;
+
+  static void *map_base_;
+  static size_t map_length_;
+  static const InjectionTraceRecord *records_;
+  static size_t n_records_;
+  static std::vector<std::vector<uint32_t>> node_index_;
+};
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the point-to-point link channel
+ */
+
+#include "LinkChannel.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "GlobalParams.h"
+
+static_assert(MAX_VIRTUAL_CHANNELS <= 32, "full mask is an unsigned int");
+
+LinkChannel::LinkChannel(const char *name)
+    : sc_prim_channel(name), credit_mode(false), depth(0), n_vcs(0),
+      latency(1), serial(1), cdc(false), link_bits(0), flit_bits(1),
+      budget(0), budget_cycle(0), burst(1),
+      full_mask(0), staged_full_mask(0), update_requested(false),
+      transferred(0) {}
+
+int LinkChannel::flitsPerCycle(int link_bits) {
+  if (link_bits <= 0 || GlobalParams::flit_size <= 0)
+    return 1;
+  return std::max(1, link_bits / GlobalParams::flit_size);
+}
+
+void LinkChannel::configure(bool credit, int _latency, int _depth, int _n_vcs,
+                            int _link_bits, int period_ps) {
+  assert(_latency >= 1 && "link latency must be at least one cycle");
+  credit_mode = credit;
+  latency = _latency;
+  depth = _depth;
+  n_vcs = _n_vcs;
+
+  flit_bits = GlobalParams::flit_size > 0 ? GlobalParams::flit_size : 1;
+  link_bits = _link_bits > 0 ? _link_bits : flit_bits;
+  burst = std::min(flitsPerCycle(link_bits), depth);
+
+  // 窄链路上一个 flit 需要 serial 个周期才能传完
+  serial = (flit_bits + link_bits - 1) / link_bits;
+
+  // 上升沿发送，latency == 1 时在同一周期的下降沿被接收 (与原 ABP 信号一致)
+  period = sc_time(period_ps > 0 ? period_ps : GlobalParams::clock_period_ps,
+                   SC_PS);
+  flit_delay = period * (latency + serial - 1) - period / 2;
+  credit_delay = period * latency;
+  cdc = false;
+  reset();
+}
+
+void LinkChannel::setClockCrossing(int rx_period_ps, int sync_stages) {
+  sc_time rx_period(rx_period_ps, SC_PS);
+  if (rx_period == period)
+    return;
+  assert(sync_stages >= 1 && "a clock crossing needs a synchronizer");
+
+  // 两端时钟沿没有固定关系，不再用半周期对齐，而是在线路延迟之后再加
+  // 同步器延迟；接收端在可见时间之后的第一个下降沿收到 flit
+  cdc = true;
+  credit_mode = true;
+  flit_delay = period * (latency + serial - 1) + rx_period * sync_stages;
+  credit_delay = rx_period * latency + period * sync_stages;
+  rx_spacing = rx_period / flitsPerCycle(link_bits);
+  reset();
+}
+
+void LinkChannel::reset() {
+  flits.clear();
+  staged_flits.clear();
+  pending_credits.clear();
+  staged_credits.clear();
+  credits.assign(n_vcs, depth);
+  full_mask = staged_full_mask = 0;
+  burst_count.assign(n_vcs, 0);
+  budget = std::max(link_bits, flit_bits);
+  budget_cycle = sc_time_stamp().value() / period.value();
+  rx_next = SC_ZERO_TIME;
+}
+
+void LinkChannel::requestUpdate() {
+  if (!update_requested) {
+    update_requested = true;
+    request_update();
+  }
+}
+
+// 按经过的周期补充带宽预算，上限为一个周期的宽度 (窄链路为一个 flit)
+bool LinkChannel::refillBudget() {
+  unsigned long long cycle = sc_time_stamp().value() / period.value();
+  if (cycle != budget_cycle) {
+    long cap = std::max(link_bits, flit_bits);
+    long gained = (long)std::min<unsigned long long>(cycle - budget_cycle, cap) *
+                  link_bits;
+    budget = std::min(cap, budget + gained);
+    budget_cycle = cycle;
+  }
+  return budget >= flit_bits;
+}
+
+bool LinkChannel::canSend(int vc) {
+  if (!refillBudget())
+    return false;
+
+  // ABP：上一批 flit 被接收后才能发送，同一周期每个 VC 最多 burst 个
+  if (!credit_mode)
+    return flits.empty() && burst_count[vc] < burst && !(full_mask >> vc & 1);
+
+  sc_time now = sc_time_stamp();
+  while (!pending_credits.empty() && pending_credits.front().ready <= now) {
+    credits[pending_credits.front().vc]++;
+    assert(credits[pending_credits.front().vc] <= depth && "credit overflow");
+    pending_credits.pop_front();
+  }
+  return credits[vc] > 0;
+}
+
+void LinkChannel::send(const Flit &flit) {
+  if (credit_mode) {
+    assert(credits[flit.vc_id] > 0 && "send without credit");
+    credits[flit.vc_id]--;
+  } else {
+    burst_count[flit.vc_id]++;
+  }
+  budget -= flit_bits;
+  sc_time ready = sc_time_stamp() + flit_delay;
+  if (cdc) {
+    // 快时钟域写入慢时钟域时受接收端读出速率限制
+    if (ready < rx_next)
+      ready = rx_next;
+    rx_next = ready + rx_spacing;
+  }
+  staged_flits.push_back({ready, flit});
+  transferred++;
+  requestUpdate();
+}
+
+bool LinkChannel::available() const {
+  return !flits.empty() && flits.front().ready <= sc_time_stamp();
+}
+
+Flit LinkChannel::receive() {
+  assert(available());
+  Flit flit = flits.front().flit;
+  flits.pop_front();
+  return flit;
+}
+
+void LinkChannel::setFullMask(unsigned int mask) {
+  if (mask != staged_full_mask) {
+    staged_full_mask = mask;
+    requestUpdate();
+  }
+}
+
+void LinkChannel::returnCredit(int vc) {
+  staged_credits.push_back({sc_time_stamp() + credit_delay, vc});
+  requestUpdate();
+}
+
+void LinkChannel::update() {
+  update_requested = false;
+  std::fill(burst_count.begin(), burst_count.end(), 0);
+  flits.insert(flits.end(), staged_flits.begin(), staged_flits.end());
+  staged_flits.clear();
+  pending_credits.insert(pending_credits.end(), staged_credits.begin(),
+                         staged_credits.end());
+  staged_credits.clear();
+  full_mask = staged_full_mask;
+}
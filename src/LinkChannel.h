@@ -0,0 +1,135 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the point-to-point link channel
+ * that connects two router ports (or a router and its PE). One channel
+ * carries one direction of a link and replaces the flit/req/ack/
+ * TBufferFullStatus signal quartet: flits and flow-control state are only
+ * committed in update(), and only when something was written.
+ * A link has a width in bits per cycle; flits are GlobalParams::flit_size
+ * bits, so a wide link moves several flits per cycle and a narrow one
+ * needs several cycles per flit.
+ * When the two ends run on different clocks (per-level clock_period_ps) the
+ * channel models a clock-domain-crossing FIFO: credit flow control, a
+ * synchronizer delay counted in receiver cycles and a read rate of one
+ * link width per receiver cycle.
+ */
+
+#ifndef __NOXIMLINKCHANNEL_H__
+#define __NOXIMLINKCHANNEL_H__
+
+#include <deque>
+#include <systemc.h>
+#include <vector>
+
+#include "DataStructs.h"
+
+// 发送端 (上游 router 的 txProcess，上升沿)
+class LinkTxIf : virtual public sc_interface {
+public:
+  virtual bool canSend(int vc) = 0;
+  virtual void send(const Flit &flit) = 0;
+  virtual void reset() = 0;
+};
+
+// 接收端 (下游 router：rxProcess 在下降沿收 flit，txProcess 弹出时归还信用)
+class LinkRxIf : virtual public sc_interface {
+public:
+  virtual bool available() const = 0;
+  virtual Flit receive() = 0;
+  virtual bool usesCredits() const = 0;
+  virtual int burstSize() const = 0; // ABP: 每个 VC 每周期最多到达的 flit 数
+  virtual void setFullMask(unsigned int mask) = 0; // ABP: 各 VC 的满状态
+  virtual void returnCredit(int vc) = 0;           // credit: 弹出一个 flit
+};
+
+class LinkChannel : public LinkTxIf, public LinkRxIf, public sc_prim_channel {
+public:
+  explicit LinkChannel(const char *name);
+
+  // credit:  true 为信用流控，false 为 ABP (一次只有一个 flit 在途 + 满掩码)
+  // latency: 发送到接收方可见的周期数，信用返回使用相同的延迟
+  // depth:   接收方每个 VC 的 buffer 深度 (初始信用)
+  // link_bits: 每周期传输的位数 (LevelConfig::bandwidth)，<= 0 表示每周期一个 flit
+  // period_ps: 发送端时钟周期，<= 0 表示全局 clock_period_ps
+  void configure(bool credit, int latency, int depth, int n_vcs,
+                 int link_bits = 0, int period_ps = 0);
+  // 接收端时钟周期与发送端不同时改为跨时钟域 FIFO (在 configure() 之后调用，
+  // 周期相同时不做任何改变)。FIFO 指针经同步器传递，相当于信用流控：
+  // flit 在发送端 latency 周期后再经 sync_stages 个接收端周期可见，信用在
+  // 接收端 latency 周期后再经 sync_stages 个发送端周期返回
+  void setClockCrossing(int rx_period_ps, int sync_stages);
+  bool crossesClockDomain() const { return cdc; }
+
+  // 宽度为 link_bits 的链路每周期最多传输的 flit 数 (至少 1)
+  static int flitsPerCycle(int link_bits);
+
+  bool canSend(int vc);
+  void send(const Flit &flit);
+  void reset();
+
+  bool available() const;
+  Flit receive();
+  bool usesCredits() const { return credit_mode; }
+  int burstSize() const { return burst; }
+  void setFullMask(unsigned int mask);
+  void returnCredit(int vc);
+
+  unsigned long transferredFlits() const { return transferred; }
+
+protected:
+  void update();
+
+private:
+  struct TimedFlit {
+    sc_time ready;
+    Flit flit;
+  };
+  struct TimedCredit {
+    sc_time ready;
+    int vc;
+  };
+
+  bool credit_mode;
+  int depth;
+  int n_vcs;
+  int latency;
+  int serial; // 窄链路上一个 flit 占用的周期数
+  sc_time period; // 发送端周期，带宽预算按它计
+  sc_time flit_delay;
+  sc_time credit_delay;
+
+  // 跨时钟域：接收端每个周期最多读出 link_bits，flit 的可见时间间隔至少
+  // rx_spacing，rx_next 为下一个 flit 最早的可见时间
+  bool cdc;
+  sc_time rx_spacing;
+  sc_time rx_next;
+
+  std::deque<TimedFlit> flits;
+  std::vector<TimedFlit> staged_flits;
+  std::deque<TimedCredit> pending_credits;
+  std::vector<TimedCredit> staged_credits;
+  std::vector<int> credits; // [vc] 发送方可用信用
+
+  // 带宽：每周期补充 link_bits，发送一个 flit 消耗 flit_bits
+  int link_bits;
+  int flit_bits;
+  long budget;
+  unsigned long long budget_cycle;
+  int burst;                    // ABP 下每个 VC 每周期的 flit 上限
+  std::vector<int> burst_count; // [vc] 本周期已发送 (update() 清零)
+
+  unsigned int full_mask;
+  unsigned int staged_full_mask;
+  bool update_requested;
+  unsigned long transferred;
+
+  void requestUpdate();
+  bool refillBudget();
+};
+
+#endif
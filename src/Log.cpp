@@ -0,0 +1,235 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the leveled logger
+ */
+
+#include "Log.h"
+
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace noxim_log {
+
+int max_enabled_level = LVL_OFF;
+
+namespace {
+
+int default_level = LVL_OFF;
+std::vector<std::pair<std::string, int>> module_levels; // 模块覆盖
+std::unordered_map<const char *, int> file_level_cache;  // __FILE__ -> 等级
+double (*time_source)() = nullptr;
+
+int parseLevel(const std::string &s) {
+  if (s == "VERBOSE_OFF" || s == "0")
+    return LVL_OFF;
+  if (s == "VERBOSE_LOW" || s == "1")
+    return LVL_LOW;
+  if (s == "VERBOSE_MEDIUM" || s == "2")
+    return LVL_MEDIUM;
+  if (s == "VERBOSE_HIGH" || s == "3")
+    return LVL_HIGH;
+  std::cerr << "Error: invalid verbose level '" << s << "'" << std::endl;
+  exit(1);
+}
+
+// "src/taskmanager/TaskManager.cpp" -> "TaskManager"
+std::string moduleName(const char *file) {
+  const char *base = strrchr(file, '/');
+  base = base ? base + 1 : file;
+  const char *dot = strrchr(base, '.');
+  return dot ? std::string(base, dot - base) : std::string(base);
+}
+
+//------------------------------------------------------------------------
+// 异步 sink：固定容量的环形缓冲区 + 后台写线程
+// 仿真线程只做一次字符串 move，格式化后的 I/O 全部在后台完成。
+// 缓冲区满时生产者阻塞等待，保证日志不丢失。
+//------------------------------------------------------------------------
+class AsyncSink {
+public:
+  static const size_t CAPACITY = 4096;
+
+  AsyncSink()
+      : ring_(CAPACITY), head_(0), count_(0), stop_(false), sync_(false) {}
+  ~AsyncSink() { shutdown(); }
+
+  void setSynchronous(bool sync) {
+    flush();
+    std::lock_guard<std::mutex> lock(mutex_);
+    sync_ = sync;
+  }
+
+  void push(std::string &&line) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stop_ || sync_) {
+      // 同步模式或已关闭 (例如析构阶段的日志)，直接输出
+      std::cout << line;
+      return;
+    }
+    if (!worker_.joinable()) {
+      worker_ = std::thread(&AsyncSink::run, this);
+      std::signal(SIGABRT, onAbort);
+    }
+    not_full_.wait(lock, [this] { return count_ < CAPACITY; });
+    ring_[(head_ + count_) % CAPACITY] = std::move(line);
+    count_++;
+    not_empty_.notify_one();
+  }
+
+  void flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] { return count_ == 0; });
+    std::cout.flush();
+  }
+
+  void shutdown() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_)
+        return;
+      stop_ = true;
+    }
+    not_empty_.notify_one();
+    if (worker_.joinable())
+      worker_.join();
+    std::cout.flush();
+  }
+
+  // 中止路径 (SIGABRT：assert 失败，以及默认 terminate 处理中的 abort)：
+  // 把队列中剩余的日志写出。持锁的只可能是短暂持有的后台线程，拿不到锁
+  // 时有限次重试后照样写出，避免在中止路径上死锁
+  void drainOnAbort() {
+    std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+    for (int i = 0; i < 1000 && !lock.try_lock(); i++)
+      std::this_thread::yield();
+    for (size_t i = 0; i < count_; i++)
+      std::cout << ring_[(head_ + i) % CAPACITY];
+    count_ = 0;
+    std::cout.flush();
+  }
+
+private:
+  static void onAbort(int sig);
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      not_empty_.wait(lock, [this] { return count_ > 0 || stop_; });
+      if (count_ == 0 && stop_)
+        break;
+      std::string line = std::move(ring_[head_]);
+      head_ = (head_ + 1) % CAPACITY;
+      count_--;
+      not_full_.notify_one();
+
+      lock.unlock();
+      std::cout << line;
+      lock.lock();
+
+      if (count_ == 0)
+        drained_.notify_all();
+    }
+    drained_.notify_all();
+  }
+
+  std::vector<std::string> ring_;
+  size_t head_;
+  size_t count_;
+  bool stop_;
+  bool sync_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::condition_variable drained_;
+  std::thread worker_;
+};
+
+AsyncSink &sink() {
+  static AsyncSink instance;
+  return instance;
+}
+
+void AsyncSink::onAbort(int sig) {
+  sink().drainOnAbort();
+  std::signal(sig, SIG_DFL);
+  std::raise(sig);
+}
+
+} // namespace
+
+bool moduleEnabled(int level, const char *file) {
+  auto it = file_level_cache.find(file);
+  if (it == file_level_cache.end()) {
+    int module_level = default_level;
+    std::string name = moduleName(file);
+    for (const auto &entry : module_levels)
+      if (entry.first == name)
+        module_level = entry.second;
+    it = file_level_cache.insert(std::make_pair(file, module_level)).first;
+  }
+  return level <= it->second;
+}
+
+void configure(const std::string &spec) {
+  default_level = LVL_OFF;
+  module_levels.clear();
+  file_level_cache.clear();
+
+  std::stringstream ss(spec);
+  std::string token;
+  bool first = true;
+  while (std::getline(ss, token, ',')) {
+    if (token.empty())
+      continue;
+    size_t eq = token.find('=');
+    if (eq == std::string::npos) {
+      if (!first) {
+        std::cerr << "Error: verbose_mode global level must come first, got '"
+                  << token << "'" << std::endl;
+        exit(1);
+      }
+      default_level = parseLevel(token);
+    } else {
+      module_levels.push_back(std::make_pair(token.substr(0, eq),
+                                             parseLevel(token.substr(eq + 1))));
+    }
+    first = false;
+  }
+
+  max_enabled_level = default_level;
+  for (const auto &entry : module_levels)
+    if (entry.second > max_enabled_level)
+      max_enabled_level = entry.second;
+}
+
+void setTimeSource(double (*source)()) { time_source = source; }
+
+void flush() { sink().flush(); }
+
+void shutdown() { sink().shutdown(); }
+
+void setSynchronous(bool sync) { sink().setSynchronous(sync); }
+
+LogLine::LogLine(const char *file, const char *func) {
+  if (time_source)
+    buf_ << std::setw(7) << std::left << time_source() << " ";
+  buf_ << moduleName(file) << "::" << func << "() --> ";
+}
+
+LogLine::~LogLine() { sink().push(buf_.str()); }
+
+} // namespace noxim_log
@@ -0,0 +1,95 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the leveled logger
+ */
+
+#ifndef __NOXIMLOG_H__
+#define __NOXIMLOG_H__
+
+#include <ostream>
+#include <sstream>
+#include <string>
+
+// 编译期上限：高于该等级的日志语句被编译器整体消除
+// (例如 -DNOXIM_LOG_MAX_LEVEL=0 可以彻底去掉所有日志)
+#ifndef NOXIM_LOG_MAX_LEVEL
+#define NOXIM_LOG_MAX_LEVEL 3
+#endif
+
+namespace noxim_log {
+
+// 与 verbose_mode 的取值一一对应
+enum Level { LVL_OFF = 0, LVL_LOW = 1, LVL_MEDIUM = 2, LVL_HIGH = 3 };
+
+// 所有模块中最高的使能等级，作为热路径上的第一道 (也是唯一一道) 过滤
+extern int max_enabled_level;
+
+// 慢路径：按模块 (源文件名，不含目录和后缀) 查询等级
+bool moduleEnabled(int level, const char *file);
+
+inline bool enabled(int level, const char *file) {
+  return level <= max_enabled_level && moduleEnabled(level, file);
+}
+
+// 解析 verbose_mode，格式:
+//   VERBOSE_MEDIUM                         全局等级
+//   VERBOSE_LOW,Router=VERBOSE_HIGH,...    全局等级 + 模块覆盖
+// 等级也接受数字 0..3 (对应命令行 -verbose N)
+void configure(const std::string &spec);
+
+// 日志前缀中使用的周期数来源 (由 sc_main 注入，避免本模块依赖 SystemC)
+void setTimeSource(double (*source)());
+
+// 等待异步 sink 写完所有已提交的日志
+void flush();
+void shutdown();
+
+// 同步模式下日志在提交时直接写到 stdout，与其余 cout 输出保持先后顺序
+// (调试用，-log_sync / log_sync: true)。异步模式下进程因 assert/terminate
+// 中止时，队列中尚未写出的日志会先被写出
+void setSynchronous(bool sync);
+
+// 一条日志语句对应一个 LogLine，析构时整行提交给异步 sink
+class LogLine {
+public:
+  LogLine(const char *file, const char *func);
+  ~LogLine();
+  std::ostream &stream() { return buf_; }
+
+private:
+  std::ostringstream buf_;
+};
+
+// operator& 的优先级低于 <<，用于把整条流表达式吞成 void
+struct Voidify {
+  void operator&(std::ostream &) {}
+};
+
+} // namespace noxim_log
+
+// 当前源文件的 lvl 级日志是否开启。一条消息需要循环拼接时先判断它，
+// 在局部 ostringstream 中拼好后用一条 LOG 语句输出
+#define LOG_ENABLED(lvl)                                                       \
+  ((lvl) <= NOXIM_LOG_MAX_LEVEL && noxim_log::enabled((lvl), __FILE__))
+
+// 一条 LOG 语句输出一行 (带周期和模块前缀)。
+// 被禁用的语句只剩一次整数比较，<< 右侧的参数不会被求值
+#define LOG_AT(lvl)                                                            \
+  !LOG_ENABLED(lvl)                                                            \
+      ? (void)0                                                                \
+      : noxim_log::Voidify() &                                                 \
+            noxim_log::LogLine(__FILE__, __func__).stream()
+
+#define LOG_LOW LOG_AT(noxim_log::LVL_LOW)
+#define LOG_MEDIUM LOG_AT(noxim_log::LVL_MEDIUM)
+#define LOG_HIGH LOG_AT(noxim_log::LVL_HIGH)
+
+// 原有的 LOG 语句都是逐 flit 的调试输出，归到最高等级
+#define LOG LOG_HIGH
+
+#endif
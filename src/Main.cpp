@@ -10,9 +10,14 @@
 
 #include "ConfigurationManager.h"
 #include "DataStructs.h"
+#include "FlitTrace.h"
 #include "GlobalParams.h"
 #include "GlobalStats.h"
+#include "InjectionTrace.h"
+#include "Log.h"
 #include "NoC.h"
+#include "Profiler.h"
+#include "ReplayPE.h"
 
 #include <csignal>
 
@@ -102,6 +107,11 @@ workload:
           evict_payload: { Weights: 6, Inputs: 3, Outputs: 2 } 
 )";
 
+// 日志前缀使用的当前仿真周期
+static double currentCycle() {
+  return sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+}
+
 void signalHandler(int signum) {
   cout << "\b\b  " << endl;
   cout << endl;
@@ -132,7 +142,10 @@ int sc_main(int arg_num, char *arg_vet[]) {
   cout << endl;
   cout << endl;
 
+  Profiler::beginPhase(PHASE_CONFIGURATION);
   configure(arg_num, arg_vet);
+  Profiler::endPhase(PHASE_CONFIGURATION);
+  noxim_log::setTimeSource(currentCycle);
   // GlobalParams::workload = loadWorkloadConfigFromString(test_yaml_content);
 
   // GlobalParams::CapabilityMap[ROLE_GLB].main_channel_caps = {0,18,96};
@@ -144,19 +157,53 @@ int sc_main(int arg_num, char *arg_vet[]) {
   sc_clock clock("clock", GlobalParams::clock_period_ps, SC_PS);
   sc_signal<bool> reset;
 
+  // Network-only replay: the trace must be indexed before the tiles are built
+  if (!GlobalParams::replay_trace_filename.empty()) {
+    if (!InjectionTrace::openForReplay(GlobalParams::replay_trace_filename))
+      exit(1);
+    if (InjectionTrace::numNodes() != GlobalParams::num_nodes) {
+      cerr << "Error: replay trace was recorded with "
+           << InjectionTrace::numNodes() << " nodes, configuration has "
+           << GlobalParams::num_nodes << endl;
+      exit(1);
+    }
+    cout << "Replaying " << InjectionTrace::totalRecords()
+         << " packet injections from " << GlobalParams::replay_trace_filename
+         << endl;
+  }
+
   // NoC instance
+  Profiler::beginPhase(PHASE_ELABORATION);
   n = new NoC("NoC");
+  Profiler::endPhase(PHASE_ELABORATION);
+
+  if (!GlobalParams::injection_trace_filename.empty()) {
+    if (!InjectionTrace::openForRecord(GlobalParams::injection_trace_filename,
+                                       GlobalParams::num_nodes))
+      exit(1);
+    cout << "Recording packet injections to "
+         << GlobalParams::injection_trace_filename << endl;
+  }
+
+  // Binary flit trace (see other/flit_trace_analyzer.cpp)
+  if (GlobalParams::trace_mode) {
+    if (!FlitTrace::open(GlobalParams::trace_filename,
+                         GlobalParams::clock_period_ps))
+      exit(1);
+    cout << "Tracing flit events to " << GlobalParams::trace_filename << endl;
+  }
 
   n->clock(clock);
   n->reset(reset);
 
   reset.write(1);
   cout << "Reset for " << (int)(GlobalParams::reset_time) << " cycles... ";
-  srand(GlobalParams::rnd_generator_seed);
 
   // fix clock periods different from 1ns
   // sc_start(GlobalParams::reset_time, SC_NS);
+  Profiler::beginPhase(PHASE_RESET);
   sc_start(GlobalParams::reset_time * GlobalParams::clock_period_ps, SC_PS);
+  Profiler::endPhase(PHASE_RESET);
 
   reset.write(0);
   cout << " done! " << endl;
@@ -164,16 +211,35 @@ int sc_main(int arg_num, char *arg_vet[]) {
        << endl;
   // fix clock periods different from 1ns
   // sc_start(GlobalParams::simulation_time, SC_NS);
+  Profiler::beginPhase(PHASE_SIMULATION);
   sc_start(GlobalParams::simulation_time * GlobalParams::clock_period_ps,
            SC_PS);
+  Profiler::endPhase(PHASE_SIMULATION);
+  Profiler::setSimulatedCycles(sc_time_stamp().to_double() /
+                                   GlobalParams::clock_period_ps -
+                               GlobalParams::reset_time);
 
   // Close the simulation
-  // if (GlobalParams::trace_mode) sc_close_vcd_trace_file(tf);
+  InjectionTrace::closeRecord();
+  if (!GlobalParams::replay_trace_filename.empty()) {
+    cout << "Replay finished at cycle "
+         << sc_time_stamp().to_double() / GlobalParams::clock_period_ps -
+                GlobalParams::reset_time
+         << ": " << ReplayPE::total_injected_flits_ << " flits injected, "
+         << ReplayPE::total_ejected_flits_ << " flits ejected" << endl;
+    InjectionTrace::closeReplay();
+  }
+  if (GlobalParams::trace_mode) {
+    FlitTrace::close();
+    cout << FlitTrace::recordsWritten() << " flit events written to "
+         << GlobalParams::trace_filename << endl;
+  }
   // cout << "Noxim simulation completed.";
   // cout << " (" << sc_time_stamp().to_double() / GlobalParams::clock_period_ps
   // << " cycles executed)" << endl; cout << endl;
   // assert(false);
   //  Show statistics
+  noxim_log::flush();
   cout << "=== Configuration Sources ===" << endl;
   cout << "Main config file: " << GlobalParams::config_filename << endl;
   cout << endl;
@@ -203,5 +269,6 @@ int sc_main(int arg_num, char *arg_vet[]) {
 #ifdef DEADLOCK_AVOIDANCE
   cout << "***** WARNING: DEADLOCK_AVOIDANCE ENABLED!" << endl;
 #endif
+  noxim_log::shutdown();
   return 0;
 }
@@ -7,6 +7,7 @@
 MockPE::MockPE(sc_module_name nm) : sc_module(nm){
     // 注意：这个构造函数缺少local_id初始化，应该使用带id参数的构造函数
     local_id = -1;  // 临时设置为无效值，应该避免使用这个构造函数
+    rng = RngService::stream(RNG_DOMAIN_MOCK_PE, local_id);
 
     cout << "[MockPE_" << local_id << "] 警告：使用了缺少id参数的构造函数！" << endl;
 
@@ -44,6 +45,7 @@ MockPE::MockPE(sc_module_name nm) : sc_module(nm){
 // 带ID参数的构造函数：推荐的构造函数
 // ================================================================
 MockPE::MockPE(sc_module_name nm, int id) : sc_module(nm), local_id(id) {
+    rng = RngService::stream(RNG_DOMAIN_MOCK_PE, local_id);
 
     cout << "[MockPE_" << local_id << "] 构造函数启动..." << endl;
 
@@ -280,7 +282,7 @@ void MockPE::injectTestPacket(int dst_id, int size, int src_id) {
     test_packet.dst_id = dst_id;     // 设置目标ID
     test_packet.size = size;         // 设置包大小（flit数量）
     test_packet.src_id = src_id;     // 设置源ID（用于日志）
-    test_packet.vc_id = std::rand() % GlobalParams::n_virtual_channels;
+    test_packet.vc_id = rng.below(GlobalParams::n_virtual_channels);
 
     // 将测试包加入发送队列
     packet_queue.push(test_packet);
@@ -306,7 +308,7 @@ void MockPE::injectTestPacket(vector<int> dst_ids, int size,int src_id) {
     TestPacket test_packet;
     test_packet.size = size;         // 设置包大小（flit数量）
     test_packet.src_id = src_id;     // 设置源ID（用于日志）
-    test_packet.vc_id = std::rand() % GlobalParams::n_virtual_channels;
+    test_packet.vc_id = rng.below(GlobalParams::n_virtual_channels);
     test_packet.is_multicast = true;
     test_packet.multicast_dst_ids = dst_ids;
     packet_queue.push(test_packet);
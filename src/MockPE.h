@@ -22,6 +22,7 @@
 
 // 引入Noxim的基本数据类型定义
 #include "DataStructs.h"
+#include "Rng.h"
 #include "Utils.h"
 
 using namespace std;
@@ -77,6 +78,7 @@ SC_MODULE(MockPE) {
     // ===== 核心状态变量 =====
 
     int local_id;                           // 当前MockPE的唯一标识符
+    RngStream rng;                          // 本MockPE独立的随机数流
     bool current_level_tx;                  // 发送方向的当前电平（ABP协议）
     bool current_level_rx;                  // 接收方向的当前电平（ABP协议）
     int flit_left_in_packet;               // 当前正在发送的包剩余的flit数量
@@ -9,7 +9,9 @@
  */
 
 #include "NoC.h"
+#include "Log.h"
 #include <dbg.h>
+#include <new>
 
 using namespace std;
 
@@ -147,102 +149,52 @@ void NoC::buildHierarchical() {
   buildCommon();
 
   //==================================================================
-  // 1. 初始化层次化拓扑参数
+  // 1. 初始化层次化拓扑参数 (每层节点数由各节点的 fanout 决定)
   //==================================================================
-  if (GlobalParams::num_levels <= 0 ||
-      GlobalParams::fanouts_per_level == nullptr) {
-    // 使用 cerr 输出错误信息，这是标准错误流
-    std::cerr << "错误: 全局配置 (GlobalParams) 无效或未初始化。" << std::endl;
-    std::cerr << "  - GlobalParams::num_levels: " << GlobalParams::num_levels
-              << std::endl;
-    std::cerr << "  - GlobalParams::nodes_per_level is "
-              << (GlobalParams::fanouts_per_level == nullptr ? "nullptr"
-                                                             : "not null")
-              << std::endl;
-
-    // 验证失败，终止当前函数的执行
-    return;
-  }
-
-  num_levels = GlobalParams::num_levels;
-  nodes_per_level = new int[num_levels];
-  for (int i = 0; i < num_levels; i++) {
-    if (i == 0)
-      nodes_per_level[i] = 1; // 根节点
-    else {
-      nodes_per_level[i] =
-          nodes_per_level[i - 1] * GlobalParams::fanouts_per_level[i - 1];
-      dbg(i, GlobalParams::fanouts_per_level[i - 1], nodes_per_level[i]);
-    }
-  }
-
-  // 计算总节点数
-  total_nodes = 0;
-  for (int i = 0; i < num_levels; i++) {
-    total_nodes += nodes_per_level[i];
+  if (!topology.initialize()) {
+    cerr << "Error: invalid hierarchical topology configuration" << endl;
+    exit(1);
   }
 
-  cout << "层次化结构: " << num_levels << "层" << endl;
-  cout << "节点分布: ";
-  for (int i = 0; i < num_levels; i++) {
-    cout << "L" << i << "(" << nodes_per_level[i] << ") ";
-  }
-  cout << "= 总计 " << total_nodes << " 个节点" << endl;
-
-  //==================================================================
-  // 2. 创建层次化映射关系
   //==================================================================
-  setupHierarchicalTopology();
-  buildRoleMappings();
-
-  //==================================================================
-  // 3. 分配层次化信号
-  //    使用1D数组，按节点ID索引
+  // 2. 创建层次化映射关系 (父子关系为 CSR) 和角色映射
   //==================================================================
-  // hierarchical_req = new sc_signal_Hierarchical<bool>*[total_nodes];
-  // hierarchical_ack = new sc_signal_Hierarchical<bool>*[total_nodes];
-  // hierarchical_buffer_full_status = new
-  // sc_signal_Hierarchical<TBufferFullStatus>*[total_nodes]; hierarchical_flit
-  // = new sc_signal_Hierarchical<Flit>*[total_nodes];
-
-  // for (int i = 0; i < total_nodes; i++) {
-  //     hierarchical_req[i] = new sc_signal_Hierarchical<bool>();
-  //     hierarchical_ack[i] = new sc_signal_Hierarchical<bool>();
-  //     hierarchical_buffer_full_status[i] = new
-  //     sc_signal_Hierarchical<TBufferFullStatus>(); hierarchical_flit[i] = new
-  //     sc_signal_Hierarchical<Flit>();
-  // }
+  topology.buildTopology();
+  num_levels = topology.getNumLevels();
+  total_nodes = topology.getTotalNodes();
+  node_level_map = GlobalParams::node_level_map;
+  parent_map = GlobalParams::parent_map;
 
   //==================================================================
-  // 4. 创建Tile数组 (1D结构，适合层次化拓扑)
+  // 3. 创建Tile数组 (1D结构，按节点ID索引)
+  //    所有 Tile 在一块连续内存中构造，t[i] 指向其中的元素
   //==================================================================
+  tile_storage = static_cast<Tile *>(::operator new(sizeof(Tile) * total_nodes));
   t = new Tile *[total_nodes];
 
   //==================================================================
-  // 5. 创建和配置所有节点
+  // 4. 创建和配置所有节点
   //==================================================================
   for (int node_id = 0; node_id < total_nodes; node_id++) {
-    char tile_name[64];
-    sprintf(tile_name, "HNode_%d", node_id);
+    int level = node_level_map[node_id];
+    char tile_name[32];
+    snprintf(tile_name, sizeof(tile_name), "HNode_%d", node_id);
 
     // 创建Tile
-    t[node_id] = new Tile(tile_name, node_id, node_level_map[node_id]);
+    t[node_id] = new (&tile_storage[node_id]) Tile(tile_name, node_id, level);
 
     // 配置Router
-    t[node_id]->r->configure(node_id, GlobalParams::node_level_map[node_id],
-                             GlobalParams::stats_warm_up_time,
+    t[node_id]->r->configure(node_id, level, GlobalParams::stats_warm_up_time,
                              GlobalParams::buffer_depth, grtable);
     // 获取当前层和下一层的带宽配置
     const LevelConfig &current_level_config =
-        GlobalParams::hierarchical_config.get_level_config(
-            node_level_map[node_id]);
+        GlobalParams::hierarchical_config.get_level_config(level);
 
     // 获取下一层带宽（用于链路传输）
     int next_level_bandwidth = current_level_config.bandwidth;
-    if (node_level_map[node_id] < GlobalParams::num_levels - 1) {
+    if (level < GlobalParams::num_levels - 1) {
       const LevelConfig &next_level_config =
-          GlobalParams::hierarchical_config.get_level_config(
-              node_level_map[node_id] + 1);
+          GlobalParams::hierarchical_config.get_level_config(level + 1);
       next_level_bandwidth = next_level_config.bandwidth;
     }
 
@@ -251,195 +203,41 @@ void NoC::buildHierarchical() {
         next_level_bandwidth, // 下一层链路带宽
         GlobalParams::buffer_depth,
         current_level_config.bandwidth, // 当前层处理带宽
-        string(GlobalParams::routing_algorithm), "default",
-        GlobalParams::node_level_map[node_id]); // 层级参数
+        GlobalParams::routing_algorithm, "default",
+        level); // 层级参数
 
     // 配置ProcessingElement
-    t[node_id]->pe->local_id = node_id;
-    t[node_id]->pe->traffic_table = &gttable;
-    t[node_id]->pe->never_transmit = true;
+    if (t[node_id]->pe) {
+      t[node_id]->pe->local_id = node_id;
+      t[node_id]->pe->traffic_table = &gttable;
+      t[node_id]->pe->never_transmit = true;
+    }
 
     // 连接时钟和复位
-    t[node_id]->clock(clock);
+    int period_ps = GlobalParams::levelClockPeriod(level);
+    if (period_ps != GlobalParams::clock_period_ps) {
+      sc_clock *&domain_clock = domain_clocks[period_ps];
+      if (domain_clock == nullptr) {
+        char clock_name[32];
+        snprintf(clock_name, sizeof(clock_name), "clock_%dps", period_ps);
+        domain_clock = new sc_clock(clock_name, period_ps, SC_PS);
+        cout << "时钟域 " << clock_name << " (Level " << level << ")" << endl;
+      }
+      t[node_id]->clock(*domain_clock);
+    } else {
+      t[node_id]->clock(clock);
+    }
     t[node_id]->reset(reset);
 
-    int level = getLevelOfNode(node_id);
-    cout << "创建节点 " << node_id << " (Level " << level << ")" << endl;
+    LOG_MEDIUM << "创建节点 " << node_id << " (Level " << level << ")" << endl;
   }
 
   //==================================================================
-  // 6. 建立层次化连接
+  // 5. 建立层次化连接
   //==================================================================
-  // 建立层次化连接关系
-  // 在 NoC.cpp 的构造函数 SC_CTOR(NoC) 中
-  // ...
-  // 为Tile分配内存后 ...
-
-  // 为层次化信号数组分配内存
-  hierarchical_flit = new sc_signal<Flit> *[GlobalParams::num_nodes];
-  hierarchical_req = new sc_signal<bool> *[GlobalParams::num_nodes];
-  hierarchical_ack = new sc_signal<bool> *[GlobalParams::num_nodes];
-  hierarchical_buffer_full_status =
-      new sc_signal<TBufferFullStatus> *[GlobalParams::num_nodes];
-  downstream_ready_signals = new sc_signal<int> *[GlobalParams::num_nodes];
-
-  // 为每个节点的连接分配两个方向的信号
-  for (int i = 0; i < GlobalParams::num_nodes; i++) {
-    // 0: C->P (UP), 1: P->C (DOWN)
-    hierarchical_flit[i] = new sc_signal<Flit>[2];
-    hierarchical_req[i] = new sc_signal<bool>[2];
-    hierarchical_ack[i] = new sc_signal<bool>[2];
-    hierarchical_buffer_full_status[i] = new sc_signal<TBufferFullStatus>[2];
-    downstream_ready_signals[i] = new sc_signal<int>[1];
-  }
-
-  for (int i = 0; i < GlobalParams::num_nodes; i++) {
-    // 0: C->P (UP), 1: P->C (DOWN)
-    hierarchical_flit[i] = new sc_signal<Flit>[2];
-    hierarchical_req[i] = new sc_signal<bool>[2];
-    hierarchical_ack[i] = new sc_signal<bool>[2];
-    hierarchical_buffer_full_status[i] = new sc_signal<TBufferFullStatus>[2];
-  }
   setupHierarchicalConnections();
 
-  cout << "=== 层次化NoC拓扑构建完成 ===" << endl;
-  cout << "注意: 需要修改Router类支持层次化路由" << endl;
-
-  // setupLocalConnections();
-}
-
-//======================================================================
-// 方法: setupHierarchicalTopology()
-// 描述: 根据num_levels和nodes_per_level建立层次化映射关系
-//======================================================================
-void NoC::setupHierarchicalTopology() {
-  cout << "建立层次化映射关系..." << endl;
-
-  // 分配映射数组
-  node_level_map = new int[total_nodes];
-  parent_map = new int[total_nodes];
-  child_map = new int *[total_nodes];
-
-  // 初始化
-  for (int i = 0; i < total_nodes; i++) {
-    node_level_map[i] = -1;
-    parent_map[i] = -1;
-    child_map[i] = NULL;
-  }
-
-  // 使用num_levels和nodes_per_level动态构建
-  int node_id = 0;
-
-  for (int level = 0; level < num_levels; level++) {
-    int level_start = node_id;
-    int level_end = node_id + nodes_per_level[level];
-
-    // 设置节点层级
-    for (int i = level_start; i < level_end; i++) {
-      node_level_map[i] = level;
-    }
-
-    // 非根节点设置父节点
-    if (level > 0) {
-      int parent_level_start = 0;
-      for (int p = 0; p < level - 1; p++) {
-        parent_level_start += nodes_per_level[p];
-      }
-
-      for (int i = 0; i < nodes_per_level[level]; i++) {
-        int current_node = level_start + i;
-        int node_num = nodes_per_level[level] / nodes_per_level[level - 1];
-        int parent_id = parent_level_start + (i / node_num);
-        parent_map[current_node] = parent_id;
-
-        // 为父节点分配子节点数组
-        if (child_map[parent_id] == NULL) {
-          child_map[parent_id] = new int[node_num];
-          for (int j = 0; j < node_num; j++) {
-            child_map[parent_id][j] = -1;
-          }
-        }
-
-        // 添加子节点
-        for (int j = 0; j < node_num; j++) {
-          if (child_map[parent_id][j] == -1) {
-            child_map[parent_id][j] = current_node;
-            break;
-          }
-        }
-      }
-    }
-
-    node_id += nodes_per_level[level];
-  }
-
-  // 根节点无父节点
-  parent_map[0] = -1;
-  writeToGlobalParams();
-
-  cout << "层次化映射建立完成" << endl;
-}
-
-void NoC::buildRoleMappings() {
-  HierarchicalConfig &config = GlobalParams::hierarchical_config;
-
-  // 找到 GLB 层和 COMPUTE 层的索引
-  int glb_level = -1, compute_level = -1;
-  for (int i = 0; i < config.levels.size(); i++) {
-    if (config.levels[i].roles == ROLE_GLB) {
-      glb_level = i;
-    }
-    if (config.levels[i].roles == ROLE_BUFFER) {
-      compute_level = i;
-    }
-  }
-
-  if (glb_level == -1 || compute_level == -1)
-    return;
-
-  // 计算每层的起始节点ID
-  int glb_start = 0, compute_start = 0;
-  for (int i = 0; i < glb_level; i++) {
-    glb_start += nodes_per_level[i];
-  }
-  for (int i = 0; i < compute_level; i++) {
-    compute_start += nodes_per_level[i];
-  }
-
-  // 遍历所有 GLB 节点,找到其对应的 COMPUTE 节点
-  for (int i = 0; i < nodes_per_level[glb_level]; i++) {
-    int glb_id = glb_start + i;
-    vector<int> compute_nodes;
-
-    // 通过递归遍历子节点找到所有 COMPUTE 节点
-    findComputeNodes(glb_id, compute_level, compute_nodes);
-
-    GlobalParams::storage_to_compute_map[glb_id] = compute_nodes;
-
-    // 反向映射
-    for (int compute_id : compute_nodes) {
-      GlobalParams::compute_to_storage_map[compute_id] = glb_id;
-    }
-  }
-}
-
-void NoC::findComputeNodes(int node_id, int target_level, vector<int> &result) {
-  int current_level = node_level_map[node_id];
-
-  if (current_level == target_level) {
-    result.push_back(node_id);
-    return;
-  }
-
-  // 递归遍历所有子节点
-  if (child_map[node_id] != NULL) {
-    int fanout = GlobalParams::fanouts_per_level[current_level];
-    for (int i = 0; i < fanout; i++) {
-      if (child_map[node_id][i] != -1) {
-        findComputeNodes(child_map[node_id][i], target_level, result);
-      }
-    }
-  }
+  cout << "=== 层次化NoC拓扑构建完成: " << total_nodes << " 个节点 ===" << endl;
 }
 
 void NoC::buildButterfly() { return; }
@@ -457,157 +255,85 @@ void NoC::buildOmega() { return; }
 // 在 NoC.cpp 中
 // 在 NoC.cpp 中
 void NoC::setupHierarchicalConnections() {
-  cout << "[连接] 正在建立 Tile 间的层次化连接..." << endl;
-
-  // t[0]->pe->downstream_ready_out.bind(dummy_signal); // make systemc
-  // satisfied
+  // 每个非根节点与父节点之间一对 LinkChannel (up: C->P, down: P->C)，
+  // 全部在一块连续内存中构造，按子节点 ID 索引
+  int num_links = total_nodes > 0 ? total_nodes - 1 : 0;
+  link_storage =
+      static_cast<LinkChannel *>(::operator new(sizeof(LinkChannel) * 2 * num_links));
+  hierarchical_link_up = new LinkChannel *[total_nodes]();
+  hierarchical_link_down = new LinkChannel *[total_nodes]();
 
   // 遍历所有非根节点（从1开始）
-  for (int i = 1; i < GlobalParams::num_nodes; i++) {
+  for (int i = 1; i < total_nodes; i++) {
     int parent_id = GlobalParams::parent_map[i];
     assert(parent_id != -1 && "每个非根节点都必须有一个父节点");
 
-    // 找到当前节点在其父节点的子节点列表中的索引
-    int child_index = -1;
-    int num_children = GlobalParams::fanouts_per_level
-        [GlobalParams::node_level_map[parent_id]];
-    for (int j = 0; j < num_children; j++) {
-      if (GlobalParams::child_map[parent_id][j] == i) {
-        child_index = j;
-        break;
-      }
-    }
-    assert(child_index != -1 && "无法在父节点的子节点列表中找到当前节点");
-
-    // --- [DEBUG] 打印当前正在处理的连接 ---
-    cout << "--- [DEBUG] 开始连接 Node " << i << " (UP) <--> Node " << parent_id
-         << " (DOWN " << child_index << ") ---" << endl;
-
-    // =================================================================
-    //                 方向 1: 子节点 -> 父节点
-    // =================================================================
-    {
-
-      cout << "  [NOC BIND DEBUG] Child " << i << " UP TX status port addr: "
-           << t[i]->hierarchical_buffer_full_status_up_tx << endl;
-      assert(t[i]->hierarchical_buffer_full_status_up_tx != nullptr &&
-             "Tile's own UP TX status port is NULL!");
-
-      cout << "  [DEBUG] 方向 C->P: 正在绑定..." << endl;
-
-      // --- [DEBUG] 打印关键指针地址 ---
-      cout << "    - Child  (UP) TX flit   port addr: "
-           << t[i]->hierarchical_flit_up_tx << endl;
-      cout << "    - Parent (DW) RX flit   port addr: "
-           << t[parent_id]->hierarchical_flit_down_rx[child_index] << endl;
-      cout << "    - Child  (UP) TX status port addr: "
-           << t[i]->hierarchical_buffer_full_status_up_tx << endl;
-      cout << "    - Parent (DW) RX status port addr: "
-           << t[parent_id]->hierarchical_buffer_full_status_down_rx[child_index]
-           << endl;
-
-      // --- [DEBUG] 添加断言进行运行时检查 ---
-      assert(t[i]->hierarchical_flit_up_tx != nullptr &&
-             "Child UP TX Flit Port is NULL!");
-      assert(t[parent_id]->hierarchical_flit_down_rx[child_index] != nullptr &&
-             "Parent DOWN RX Flit Port is NULL!");
-      assert(t[i]->hierarchical_buffer_full_status_up_tx != nullptr &&
-             "Child UP TX Status Port is NULL!");
-      assert(
-          t[parent_id]->hierarchical_buffer_full_status_down_rx[child_index] !=
-              nullptr &&
-          "Parent DOWN RX Status Port is NULL!");
-
-      // --- 执行绑定 ---
-      t[i]->hierarchical_flit_up_tx->bind(hierarchical_flit[i][0]);
-      t[i]->hierarchical_req_up_tx->bind(hierarchical_req[i][0]);
-      t[i]->hierarchical_ack_up_tx->bind(hierarchical_ack[i][0]);
-      t[i]->hierarchical_buffer_full_status_up_tx->bind(
-          hierarchical_buffer_full_status[i][0]);
-
-      t[parent_id]->hierarchical_flit_down_rx[child_index]->bind(
-          hierarchical_flit[i][0]);
-      t[parent_id]->hierarchical_req_down_rx[child_index]->bind(
-          hierarchical_req[i][0]);
-      t[parent_id]->hierarchical_ack_down_rx[child_index]->bind(
-          hierarchical_ack[i][0]);
-      t[parent_id]->hierarchical_buffer_full_status_down_rx[child_index]->bind(
-          hierarchical_buffer_full_status[i][0]);
-
-      // t[parent_id]->pe->downstream_ready_in[child_index]->bind(downstream_ready_signals[i][0]);
-      // t[i]->pe->downstream_ready_out.bind(downstream_ready_signals[i][0]);
-
-      cout << "    - C->P Bind OK." << endl;
-    }
+    // 当前节点在其父节点的子节点列表中的索引 (子节点 ID 连续)
+    int child_index = GlobalParams::childIndexOf(i);
+    assert(child_index >= 0 &&
+           child_index < topology.getNumChildren(parent_id) &&
+           "无法在父节点的子节点列表中找到当前节点");
 
-    // =================================================================
-    //                 方向 2: 父节点 -> 子节点
-    // =================================================================
-    {
-
-      cout << "  [DEBUG] 方向 P->C: 正在绑定..." << endl;
-
-      // --- [DEBUG] 打印关键指针地址 ---
-      cout << "    - Parent (DW) TX flit   port addr: "
-           << t[parent_id]->hierarchical_flit_down_tx[child_index] << endl;
-      cout << "    - Child  (UP) RX flit   port addr: "
-           << t[i]->hierarchical_flit_up_rx << endl;
-      cout << "    - Parent (DW) TX status port addr: "
-           << t[parent_id]->hierarchical_buffer_full_status_down_tx[child_index]
-           << endl;
-      cout << "    - Child  (UP) RX status port addr: "
-           << t[i]->hierarchical_buffer_full_status_up_rx << endl;
-
-      // --- [DEBUG] 添加断言进行运行时检查 ---
-      assert(t[parent_id]->hierarchical_flit_down_tx[child_index] != nullptr &&
-             "Parent DOWN TX Flit Port is NULL!");
-      assert(t[i]->hierarchical_flit_up_rx != nullptr &&
-             "Child UP RX Flit Port is NULL!");
-      assert(
-          t[parent_id]->hierarchical_buffer_full_status_down_tx[child_index] !=
-              nullptr &&
-          "Parent DOWN TX Status Port is NULL!");
-      assert(t[i]->hierarchical_buffer_full_status_up_rx != nullptr &&
-             "Child UP RX Status Port is NULL!");
-
-      // --- 执行绑定 ---
-      t[parent_id]->hierarchical_flit_down_tx[child_index]->bind(
-          hierarchical_flit[i][1]);
-      t[parent_id]->hierarchical_req_down_tx[child_index]->bind(
-          hierarchical_req[i][1]);
-      t[parent_id]->hierarchical_ack_down_tx[child_index]->bind(
-          hierarchical_ack[i][1]);
-      t[parent_id]->hierarchical_buffer_full_status_down_tx[child_index]->bind(
-          hierarchical_buffer_full_status[i][1]);
-
-      t[i]->hierarchical_flit_up_rx->bind(hierarchical_flit[i][1]);
-      t[i]->hierarchical_req_up_rx->bind(hierarchical_req[i][1]);
-      t[i]->hierarchical_ack_up_rx->bind(hierarchical_ack[i][1]);
-      t[i]->hierarchical_buffer_full_status_up_rx->bind(
-          hierarchical_buffer_full_status[i][1]);
-
-      cout << "    - P->C Bind OK." << endl;
-    }
-    cout << "--- [DEBUG] Node " << i << " 连接完成 ---" << endl << endl;
+    assert(t[i]->hierarchical_link_up_tx != nullptr &&
+           "Child UP TX Link Port is NULL!");
+    assert(t[parent_id]->hierarchical_link_down_rx[child_index] != nullptr &&
+           "Parent DOWN RX Link Port is NULL!");
+
+    // 父节点所在层的配置决定这条链路的流控方式、延迟和宽度
+    const LevelConfig &link_config =
+        GlobalParams::hierarchical_config.get_level_config(
+            GlobalParams::node_level_map[parent_id]);
+
+    char link_name[32];
+    snprintf(link_name, sizeof(link_name), "HLink_%d_up", i);
+    hierarchical_link_up[i] =
+        new (&link_storage[2 * (i - 1)]) LinkChannel(link_name);
+    snprintf(link_name, sizeof(link_name), "HLink_%d_down", i);
+    hierarchical_link_down[i] =
+        new (&link_storage[2 * (i - 1) + 1]) LinkChannel(link_name);
+    // 两层时钟周期不同时链路为跨时钟域 FIFO (强制信用流控)
+    int parent_period = GlobalParams::levelClockPeriod(
+        GlobalParams::node_level_map[parent_id]);
+    int child_period =
+        GlobalParams::levelClockPeriod(GlobalParams::node_level_map[i]);
+    hierarchical_link_up[i]->configure(
+        link_config.credit_flow_control, link_config.link_latency,
+        GlobalParams::buffer_depth, GlobalParams::n_virtual_channels,
+        link_config.bandwidth, child_period);
+    hierarchical_link_up[i]->setClockCrossing(parent_period,
+                                              link_config.cdc_sync_stages);
+    hierarchical_link_down[i]->configure(
+        link_config.credit_flow_control, link_config.link_latency,
+        GlobalParams::buffer_depth, GlobalParams::n_virtual_channels,
+        link_config.bandwidth, parent_period);
+    hierarchical_link_down[i]->setClockCrossing(child_period,
+                                                link_config.cdc_sync_stages);
+
+    // 方向 1: 子节点 -> 父节点
+    t[i]->hierarchical_link_up_tx->bind(*hierarchical_link_up[i]);
+    t[parent_id]->hierarchical_link_down_rx[child_index]->bind(
+        *hierarchical_link_up[i]);
+
+    // 方向 2: 父节点 -> 子节点
+    t[parent_id]->hierarchical_link_down_tx[child_index]->bind(
+        *hierarchical_link_down[i]);
+    t[i]->hierarchical_link_up_rx->bind(*hierarchical_link_down[i]);
+
+    LOG_MEDIUM << "连接 Node " << i << " (UP) <--> Node " << parent_id
+               << " (DOWN " << child_index << ")" << endl;
   }
-  cout << "[连接] Tile 间的层次化连接建立完成。" << endl;
 }
 
 void NoC::showHierarchicalIdleStats(std::ostream &out) {
   out << "=== Hierarchical Router Idle Statistics ===" << endl;
 
   for (int level = 0; level < num_levels; level++) {
-    out << "Level " << level << " (" << nodes_per_level[level]
+    out << "Level " << level << " (" << topology.getNodesInLevel(level)
         << " nodes):" << endl;
 
     // Find first node in this level
-    int first_node = -1;
-    for (int i = 0; i < total_nodes; i++) {
-      if (node_level_map[i] == level) {
-        first_node = i;
-        break;
-      }
-    }
+    int first_node =
+        topology.getNodesInLevel(level) > 0 ? topology.getLevelStart(level) : -1;
 
     if (first_node != -1) {
       // Show detailed stats for the first node
@@ -654,9 +380,10 @@ int NoC::getParentNode(int node_id) {
   return -1;
 }
 
-const int *NoC::getChildNodes(int node_id) {
-  if (node_id >= 0 && node_id < total_nodes) {
-    return child_map[node_id];
+const int *NoC::getChildNodes(int node_id, int &num_children) {
+  num_children = topology.getNumChildren(node_id);
+  if (num_children > 0) {
+    return GlobalParams::childrenOf(node_id);
   }
   return NULL;
 }
@@ -677,17 +404,6 @@ Tile *NoC::searchNode(const int id) const {
   return NULL;
 }
 
-void NoC::writeToGlobalParams() {
-  // Make hierarchical topology information available globally
-  GlobalParams::node_level_map = node_level_map;
-  GlobalParams::parent_map = parent_map;
-  GlobalParams::child_map = child_map;
-  GlobalParams::num_nodes = total_nodes;
-  GlobalParams::num_levels = num_levels;
-
-  cout << "已将拓扑映射信息写入GlobalParams" << endl;
-}
-
 void NoC::asciiMonitor() {
   // cout << sc_time_stamp().to_double()/GlobalParams::clock_period_ps << endl;
   system("clear");
@@ -717,82 +433,24 @@ void NoC::asciiMonitor() {
   }
 }
 
-void NoC::setupLocalConnections() {
-  // cout << "[连接] 正在建立 Tile 和 MockPE 间的本地连接..." << endl;
-
-  // 将这些信号声明为 NoC 的成员变量，以便在析构函数中释放它们
-  // 例如在 NoC.h 中:
-  // std::vector<sc_signal<Flit>*> local_flit_signals;
-  // ... 其他信号向量 ...
-
-  for (int i = 0; i < GlobalParams::num_nodes; i++) {
-    int current_level = node_level_map[i];
-
-    if (current_level > 0) {
-      t[i]->r->h_flit_rx_up->bind(*(t[i]->hierarchical_flit_up_rx));
-      t[i]->r->h_req_rx_up->bind(*(t[i]->hierarchical_req_up_rx));
-      t[i]->r->h_ack_rx_up->bind(*(t[i]->hierarchical_ack_up_rx));
-      t[i]->r->h_buffer_full_status_rx_up->bind(
-          *(t[i]->hierarchical_buffer_full_status_up_rx));
-
-      t[i]->r->h_flit_tx_up->bind(*(t[i]->hierarchical_flit_up_tx));
-      t[i]->r->h_req_tx_up->bind(*(t[i]->hierarchical_req_up_tx));
-      t[i]->r->h_ack_tx_up->bind(*(t[i]->hierarchical_ack_up_tx));
-      t[i]->r->h_buffer_full_status_tx_up->bind(
-          *(t[i]->hierarchical_buffer_full_status_up_tx));
-
-      cout << "[连接] Tile" << i << "和其Router的UP绑定建立完成。" << endl;
-    }
-    int num_children = GlobalParams::fanouts_per_level[current_level];
-
-    if (num_children <= 0 || current_level >= GlobalParams::num_levels - 1)
-      continue;
-
-    for (int j = 0; j < num_children; j++) {
-      t[i]->r->h_flit_rx_down[j]->bind(*(t[i]->hierarchical_flit_down_rx[j]));
-      t[i]->r->h_req_rx_down[j]->bind(*(t[i]->hierarchical_req_down_rx[j]));
-      t[i]->r->h_ack_rx_down[j]->bind(*(t[i]->hierarchical_ack_down_rx[j]));
-      t[i]->r->h_buffer_full_status_rx_down[j]->bind(
-          *(t[i]->hierarchical_buffer_full_status_down_rx[j]));
-
-      t[i]->r->h_flit_tx_down[j]->bind(*(t[i]->hierarchical_flit_down_tx[j]));
-      t[i]->r->h_req_tx_down[j]->bind(*(t[i]->hierarchical_req_down_tx[j]));
-      t[i]->r->h_ack_tx_down[j]->bind(*(t[i]->hierarchical_ack_down_tx[j]));
-      t[i]->r->h_buffer_full_status_tx_down[j]->bind(
-          *(t[i]->hierarchical_buffer_full_status_down_tx[j]));
-
-      cout << "[连接] Tile" << i << "和其Router的DOWN" << j << "绑定建立完成。"
-           << endl;
-    }
-  }
-}
-
 NoC::~NoC() {
-  // 这是一个示例，您需要根据您实际分配的成员变量来编写
+  if (GlobalParams::topology != TOPOLOGY_HIERARCHICAL)
+    return;
 
-  // 释放 Tiles
-  for (int i = 0; i < GlobalParams::num_nodes; i++) {
-    delete t[i]; // t[i] 是通过 new Tile(...) 创建的
-  }
-  delete[] t; // t 本身是通过 new Tile*[] 创建的
-
-  // 释放 PEs (如果您是在NoC中创建的)
-  // ...
-
-  // 释放所有 sc_signal 数组
-  // 例如，为层次化连接创建的信号
-  for (int i = 1; i < GlobalParams::num_nodes; i++) {
-    // 确保指针非空
-    if (hierarchical_flit[i] != nullptr)
-      delete[] hierarchical_flit[i];
-    if (hierarchical_req[i] != nullptr)
-      delete[] hierarchical_req[i];
-    // ...
+  // Tile 和链路都是在整块内存中 placement new 构造的，逐个析构后整块释放
+  for (int i = 0; i < total_nodes; i++)
+    tile_storage[i].~Tile();
+  ::operator delete(tile_storage);
+  delete[] t;
+
+  for (int i = 1; i < total_nodes; i++) {
+    hierarchical_link_up[i]->~LinkChannel();
+    hierarchical_link_down[i]->~LinkChannel();
   }
-  delete[] hierarchical_flit;
-  delete[] hierarchical_req;
-  // ...
+  ::operator delete(link_storage);
+  delete[] hierarchical_link_up;
+  delete[] hierarchical_link_down;
 
-  // 释放其他任何在构造函数中 new 出来的东西
-  // delete grtable; // 假设 grtable 是 new 出来的
-}
\ No newline at end of file
+  for (auto &domain_clock : domain_clocks)
+    delete domain_clock.second;
+}
@@ -15,7 +15,9 @@
 #include "GlobalParams.h"
 #include "GlobalRoutingTable.h"
 #include "GlobalTrafficTable.h"
+#include "HierarchicalTopologyManager.h"
 #include "Hub.h"
+#include "LinkChannel.h"
 #include "Tile.h"
 #include "TokenRing.h"
 #include <systemc.h>
@@ -58,7 +60,6 @@ enum HierarchicalDirection {
 };
 
 SC_MODULE(NoC) {
-  sc_signal<int> **downstream_ready_signals;
   sc_signal<int> dummy_signal;
 
 public:
@@ -67,36 +68,35 @@ public:
   sc_in_clk clock;   // The input clock for the NoC
   sc_in<bool> reset; // The reset signal for the NoC
 
-  // Hierarchical structure signals - redesigned for tree topology
-  sc_signal<bool> **hierarchical_req; // 层次化请求信号
-  sc_signal<bool> **hierarchical_ack; // 层次化应答信号
-  sc_signal<TBufferFullStatus> *
-      *hierarchical_buffer_full_status; // 层次化缓冲区状态
-  sc_signal<Flit> **hierarchical_flit;  // 层次化数据流信号
+  // Hierarchical structure links - redesigned for tree topology
+  // 按子节点 ID 索引，每条父子链路两个方向各一个 LinkChannel
+  LinkChannel **hierarchical_link_up;   // C->P
+  LinkChannel **hierarchical_link_down; // P->C
 
   // Hierarchical topology parameters
-  int num_levels;       // 层次化层级数
-  int *nodes_per_level; // 每层的节点数数组
-  int total_nodes;      // 总节点数
-  int *node_level_map;  // 节点->层级映射 (1D数组)
-  int *parent_map;      // 节点->父节点映射 (1D数组)
-  int **child_map;      // 节点->子节点映射 (2D数组)
+  HierarchicalTopologyManager topology; // 拓扑映射 (CSR) 的持有者
+  int num_levels;      // 层次化层级数
+  int total_nodes;     // 总节点数
+  int *node_level_map; // 节点->层级映射，指向 topology 中的数组
+  int *parent_map;     // 节点->父节点映射，指向 topology 中的数组
 
   // Tile storage for hierarchical topology
   Tile **t;    // 1D数组存储所有Tile，按层级和ID索引
+  // Tile 和层次化链路各自在一块连续内存中构造 (10 万级节点时避免逐个分配)，
+  // t / hierarchical_link_* 指向其中的元素
+  Tile *tile_storage;
+  LinkChannel *link_storage; // [2 * (total_nodes - 1)]
+  // 配置了 clock_period_ps 的层使用各自的时钟 (按周期共用)，这些层的 Tile
+  // 只在自己的时钟沿上被调度；其余层绑定到 NoC 的 clock
+  map<int, sc_clock *> domain_clocks;
   Tile **core; // 核心Tile数组
 
   // Hierarchical connection management
-  void setupHierarchicalTopology();      // 设置层次化拓扑
-  void setupHierarchicalConnections();   // 建立层次化连接
-  int getParentNode(int node_id);        // 获取节点的父节点
-  const int *getChildNodes(int node_id); // 获取节点的子节点数组
-  int getLevelOfNode(int node_id);       // 获取节点所在的层级
-  void writeToGlobalParams();
-
-  void buildRoleMappings();
-
-  void findComputeNodes(int node_id, int target_level, vector<int> &result);
+  void setupHierarchicalConnections(); // 建立层次化连接
+  int getParentNode(int node_id);      // 获取节点的父节点
+  const int *getChildNodes(int node_id,
+                           int &num_children); // 获取节点的子节点数组
+  int getLevelOfNode(int node_id);             // 获取节点所在的层级
 
   // Statistics
   void showHierarchicalIdleStats(std::ostream & out);
@@ -155,7 +155,6 @@ private:
   void buildHierarchical();
   void buildCommon();
   void asciiMonitor();
-  void setupLocalConnections();
   int *hub_connected_ports;
 };
 
@@ -17,65 +17,59 @@
 
 using namespace std;
 
+vector<PowerParams> Power::params_table(1); // 0: 未配置 (全零)
+map<Power::RouterParamsKey, int> Power::router_params_index;
+PowerBreakdown Power::power_dynamic;
+PowerBreakdown Power::power_static;
+
 Power::Power()
 {
-    total_power_s = 0.0;
-
-    buffer_router_push_pwr_d = 0.0;
-    buffer_router_pop_pwr_d = 0.0;
-    buffer_router_front_pwr_d = 0.0;
-    buffer_router_pwr_s = 0.0;
-
-    buffer_to_tile_push_pwr_d = 0.0;
-    buffer_to_tile_pop_pwr_d = 0.0;
-    buffer_to_tile_front_pwr_d = 0.0;
-    buffer_to_tile_pwr_s = 0.0;
-
-    buffer_from_tile_push_pwr_d = 0.0;
-    buffer_from_tile_pop_pwr_d = 0.0;
-    buffer_from_tile_front_pwr_d = 0.0;
-    buffer_from_tile_pwr_s = 0.0;
-
-    antenna_buffer_push_pwr_d = 0.0;
-    antenna_buffer_pop_pwr_d = 0.0;
-    antenna_buffer_front_pwr_d = 0.0;
-    antenna_buffer_pwr_s = 0.0;
-
-    wireless_rx_pwr = 0.0;
-    transceiver_tx_pwr_s = 0.0;
-    transceiver_rx_pwr_s = 0.0;
-    transceiver_tx_pwr_biasing = 0.0;
-    transceiver_rx_pwr_biasing = 0.0;
-    wireless_snooping = 0.0;
-
-    routing_pwr_d = 0.0;
-    routing_pwr_s = 0.0;
+    params_id = 0;
 
-    selection_pwr_d = 0.0;
-    selection_pwr_s = 0.0;
-
-    crossbar_pwr_d = 0.0;
-    crossbar_pwr_s = 0.0;
-
-    link_r2r_pwr_d = 0.0;
-    link_r2r_pwr_s = 0.0;
-    link_r2h_pwr_s = 0.0;
-    link_r2h_pwr_d = 0.0;
-
-    default_tx_energy = 0.0;
-
-    ni_pwr_d = 0.0;
-    ni_pwr_s = 0.0;
+    for (int i = 0; i < NO_BREAKDOWN_ENTRIES_D; i++)
+        dynamic_count[i] = 0;
+    for (int i = 0; i < NO_BREAKDOWN_ENTRIES_S; i++)
+    {
+        static_count[i] = 0;
+        leakage_instances[i] = 0;
+    }
+    powered_cycles = 0;
 
     sleep_end_cycle = NOT_VALID;
-
-    initPowerBreakdown();
 }
 
+// 同一层、同链路宽度、同 buffer 配置的 router 共享同一组参数，
+// GlobalParams::power_configuration 的 map 查找每种组合只做一次
 void Power::configureRouter(int link_width, int buffer_depth,
                             int buffer_item_size, string routing_function,
                             string selection_function, int level)
 {
+    RouterParamsKey table_key(level, link_width, buffer_depth,
+                              buffer_item_size, routing_function,
+                              selection_function);
+    map<RouterParamsKey, int>::const_iterator it =
+        router_params_index.find(table_key);
+    if (it != router_params_index.end())
+    {
+        params_id = it->second;
+        return;
+    }
+
+    params_id = params_table.size();
+    params_table.push_back(
+        resolveRouterParams(link_width, buffer_depth, buffer_item_size,
+                            routing_function, selection_function, level));
+    router_params_index[table_key] = params_id;
+}
+
+PowerParams Power::resolveRouterParams(int link_width, int buffer_depth,
+                                       int buffer_item_size,
+                                       const string &routing_function,
+                                       const string &selection_function,
+                                       int level)
+{
+    PowerParams p = PowerParams();
+
     // (s)tatic, (d)ynamic power
 
     // Buffer
@@ -94,13 +88,13 @@ void Power::configureRouter(int link_width, int buffer_depth,
     // Dynamic values are expressed in Joule
     // Static/Leakage values must be converted from Watt to Joule
 
-    buffer_router_pwr_s =
+    p.unit_s[BUFFER_ROUTER_PWR_S] =
         W2J(GlobalParams::power_configuration.bufferPowerConfig.leakage[key]);
-    buffer_router_push_pwr_d =
+    p.unit_d[BUFFER_PUSH_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.push[key];
-    buffer_router_front_pwr_d =
+    p.unit_d[BUFFER_FRONT_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.front[key];
-    buffer_router_pop_pwr_d =
+    p.unit_d[BUFFER_POP_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.pop[key];
 
     // Routing
@@ -109,10 +103,10 @@ void Power::configureRouter(int link_width, int buffer_depth,
            GlobalParams::power_configuration.routerPowerConfig
                .routing_algorithm_pm.end());
 
-    routing_pwr_s = W2J(GlobalParams::power_configuration.routerPowerConfig
+    p.unit_s[ROUTING_PWR_S] = W2J(GlobalParams::power_configuration.routerPowerConfig
                             .routing_algorithm_pm[routing_function]
                             .first);
-    routing_pwr_d = GlobalParams::power_configuration.routerPowerConfig
+    p.unit_d[ROUTING_PWR_D] = GlobalParams::power_configuration.routerPowerConfig
                         .routing_algorithm_pm[routing_function]
                         .second;
 
@@ -122,10 +116,10 @@ void Power::configureRouter(int link_width, int buffer_depth,
            GlobalParams::power_configuration.routerPowerConfig
                .selection_strategy_pm.end());
 
-    selection_pwr_s = W2J(GlobalParams::power_configuration.routerPowerConfig
+    p.unit_s[SELECTION_PWR_S] = W2J(GlobalParams::power_configuration.routerPowerConfig
                               .selection_strategy_pm[selection_function]
                               .first);
-    selection_pwr_d = GlobalParams::power_configuration.routerPowerConfig
+    p.unit_d[SELECTION_PWR_D] = GlobalParams::power_configuration.routerPowerConfig
                           .selection_strategy_pm[selection_function]
                           .second;
 
@@ -161,8 +155,8 @@ void Power::configureRouter(int link_width, int buffer_depth,
                 static_cast<int>(e[2]) == in_bits &&
                 static_cast<int>(e[3]) == out_bits)
             {
-                crossbar_pwr_s = W2J(e[4]);
-                crossbar_pwr_d = e[5];
+                p.unit_s[CROSSBAR_PWR_S] = W2J(e[4]);
+                p.unit_d[CROSSBAR_PWR_D] = e[5];
                 matched = true;
                 break;
             }
@@ -189,8 +183,8 @@ void Power::configureRouter(int link_width, int buffer_depth,
                 assert(false && "No matching asymmetric_crossbar entry for non-last "
                                 "level in HIERARCHICAL mode");
             }
-            crossbar_pwr_s = 0.0;
-            crossbar_pwr_d = 0.0;
+            p.unit_s[CROSSBAR_PWR_S] = 0.0;
+            p.unit_d[CROSSBAR_PWR_D] = 0.0;
         }
     }
     else
@@ -201,19 +195,19 @@ void Power::configureRouter(int link_width, int buffer_depth,
             GlobalParams::power_configuration.routerPowerConfig.crossbar_pm.find(
                 xbar_k) !=
             GlobalParams::power_configuration.routerPowerConfig.crossbar_pm.end());
-        crossbar_pwr_s = W2J(
+        p.unit_s[CROSSBAR_PWR_S] = W2J(
             GlobalParams::power_configuration.routerPowerConfig.crossbar_pm[xbar_k]
                 .first);
-        crossbar_pwr_d =
+        p.unit_d[CROSSBAR_PWR_D] =
             GlobalParams::power_configuration.routerPowerConfig.crossbar_pm[xbar_k]
                 .second;
     }
 
     // NetworkInterface
-    ni_pwr_s = W2J(GlobalParams::power_configuration.routerPowerConfig
+    p.unit_s[NI_PWR_S] = W2J(GlobalParams::power_configuration.routerPowerConfig
                        .network_interface[GlobalParams::flit_size]
                        .first);
-    ni_pwr_d = GlobalParams::power_configuration.routerPowerConfig
+    p.unit_d[NI_PWR_D] = GlobalParams::power_configuration.routerPowerConfig
                    .network_interface[GlobalParams::flit_size]
                    .second;
 
@@ -229,20 +223,28 @@ void Power::configureRouter(int link_width, int buffer_depth,
                length_r2h) !=
            GlobalParams::power_configuration.linkBitLinePowerConfig.end());
 
-    link_r2r_pwr_s = W2J(link_width * GlobalParams::power_configuration
-                                          .linkBitLinePowerConfig[length_r2r]
-                                          .first);
-    link_r2r_pwr_d = link_width * GlobalParams::power_configuration
+    p.unit_d[LINK_R2R_PWR_D] = link_width * GlobalParams::power_configuration
                                       .linkBitLinePowerConfig[length_r2r]
                                       .second;
-    link_r2h_pwr_s = W2J(link_width * GlobalParams::power_configuration
+    p.unit_s[LINK_R2H_PWR_S] = W2J(link_width * GlobalParams::power_configuration
                                           .linkBitLinePowerConfig[length_r2h]
                                           .first);
-    link_r2h_pwr_d = link_width * GlobalParams::power_configuration
+    p.unit_d[LINK_R2H_PWR_D] = link_width * GlobalParams::power_configuration
                                       .linkBitLinePowerConfig[length_r2h]
                                       .second;
+
+    // 本层有独立时钟时泄漏按本层时钟沿计数 (W2J 按全局周期换算)，
+    // 每次计数对应的能量按周期之比缩放
+    double period_scale = (double)GlobalParams::levelClockPeriod(level) /
+                          GlobalParams::clock_period_ps;
+    if (period_scale != 1.0)
+        for (int i = 0; i < NO_BREAKDOWN_ENTRIES_S; i++)
+            p.unit_s[i] *= period_scale;
+
+    return p;
 }
 
+// Hub 数量很少，每个 hub 单独占一个表项
 void Power::configureHub(int link_width,
                          int buffer_to_tile_depth,   // buffer to tile
                          int buffer_from_tile_depth, // buffer from tile
@@ -251,6 +253,8 @@ void Power::configureHub(int link_width,
                          int antenna_buffer_tx_depth, // rx/tx antenna buffers
                          int antenna_buffer_item_size, int data_rate_gbs)
 {
+    PowerParams p = PowerParams();
+
     // (s)tatic, (d)ynamic power
 
     // Buffer
@@ -285,22 +289,22 @@ void Power::configureHub(int link_width,
                key_from_tile) !=
            GlobalParams::power_configuration.bufferPowerConfig.pop.end());
 
-    buffer_to_tile_pwr_s = W2J(
+    p.unit_s[BUFFER_TO_TILE_PWR_S] = W2J(
         GlobalParams::power_configuration.bufferPowerConfig.leakage[key_to_tile]);
-    buffer_to_tile_push_pwr_d =
+    p.unit_d[BUFFER_TO_TILE_PUSH_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.push[key_to_tile];
-    buffer_to_tile_front_pwr_d =
+    p.unit_d[BUFFER_TO_TILE_FRONT_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.front[key_to_tile];
-    buffer_to_tile_pop_pwr_d =
+    p.unit_d[BUFFER_TO_TILE_POP_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.pop[key_to_tile];
 
-    buffer_from_tile_pwr_s = W2J(GlobalParams::power_configuration
+    p.unit_s[BUFFER_FROM_TILE_PWR_S] = W2J(GlobalParams::power_configuration
                                      .bufferPowerConfig.leakage[key_from_tile]);
-    buffer_from_tile_push_pwr_d =
+    p.unit_d[BUFFER_FROM_TILE_PUSH_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.push[key_from_tile];
-    buffer_from_tile_front_pwr_d =
+    p.unit_d[BUFFER_FROM_TILE_FRONT_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.front[key_from_tile];
-    buffer_from_tile_pop_pwr_d =
+    p.unit_d[BUFFER_FROM_TILE_POP_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.pop[key_from_tile];
 
     // Buffer Antenna RX
@@ -317,13 +321,13 @@ void Power::configureHub(int link_width,
     assert(GlobalParams::power_configuration.bufferPowerConfig.pop.find(akey) !=
            GlobalParams::power_configuration.bufferPowerConfig.pop.end());
 
-    antenna_buffer_pwr_s =
+    p.unit_s[ANTENNA_BUFFER_PWR_S] =
         W2J(GlobalParams::power_configuration.bufferPowerConfig.leakage[akey]);
-    antenna_buffer_push_pwr_d =
+    p.unit_d[ANTENNA_BUFFER_PUSH_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.push[akey];
-    antenna_buffer_front_pwr_d =
+    p.unit_d[ANTENNA_BUFFER_FRONT_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.front[akey];
-    antenna_buffer_pop_pwr_d =
+    p.unit_d[ANTENNA_BUFFER_POP_PWR_D] =
         GlobalParams::power_configuration.bufferPowerConfig.pop[akey];
 
     // Buffer Antenna TX
@@ -341,51 +345,51 @@ void Power::configureHub(int link_width,
 
     // TODO: currently both RX/RX values are aggregated and then an average is
     // returned
-    antenna_buffer_pwr_s +=
+    p.unit_s[ANTENNA_BUFFER_PWR_S] +=
         W2J(GlobalParams::power_configuration.bufferPowerConfig.leakage[akey]);
-    antenna_buffer_push_pwr_d +=
+    p.unit_d[ANTENNA_BUFFER_PUSH_PWR_D] +=
         GlobalParams::power_configuration.bufferPowerConfig.push[akey];
-    antenna_buffer_front_pwr_d +=
+    p.unit_d[ANTENNA_BUFFER_FRONT_PWR_D] +=
         GlobalParams::power_configuration.bufferPowerConfig.front[akey];
-    antenna_buffer_pop_pwr_d +=
+    p.unit_d[ANTENNA_BUFFER_POP_PWR_D] +=
         GlobalParams::power_configuration.bufferPowerConfig.pop[akey];
 
-    antenna_buffer_pwr_s = antenna_buffer_pwr_s / 2;
-    antenna_buffer_push_pwr_d = antenna_buffer_push_pwr_d / 2;
-    antenna_buffer_front_pwr_d = antenna_buffer_front_pwr_d / 2;
-    antenna_buffer_pop_pwr_d = antenna_buffer_pop_pwr_d / 2;
+    p.unit_s[ANTENNA_BUFFER_PWR_S] = p.unit_s[ANTENNA_BUFFER_PWR_S] / 2;
+    p.unit_d[ANTENNA_BUFFER_PUSH_PWR_D] = p.unit_d[ANTENNA_BUFFER_PUSH_PWR_D] / 2;
+    p.unit_d[ANTENNA_BUFFER_FRONT_PWR_D] = p.unit_d[ANTENNA_BUFFER_FRONT_PWR_D] / 2;
+    p.unit_d[ANTENNA_BUFFER_POP_PWR_D] = p.unit_d[ANTENNA_BUFFER_POP_PWR_D] / 2;
 
-    attenuation_map = GlobalParams::power_configuration.hubPowerConfig
+    p.attenuation_map = GlobalParams::power_configuration.hubPowerConfig
                           .transmitter_attenuation_map;
 
     // TX
     // Joule
-    default_tx_energy =
+    p.unit_d[WIRELESS_TX] =
         (GlobalParams::power_configuration.hubPowerConfig.default_tx_energy /
          (1e9 * data_rate_gbs)) *
         antenna_buffer_item_size;
 
     // RX Dynamic
-    wireless_rx_pwr = antenna_buffer_item_size *
+    p.unit_d[WIRELESS_DYNAMIC_RX_PWR] = antenna_buffer_item_size *
                       GlobalParams::power_configuration.hubPowerConfig.rx_dynamic;
 
     // RX snooping
-    wireless_snooping =
+    p.unit_d[WIRELESS_SNOOPING] =
         GlobalParams::power_configuration.hubPowerConfig.rx_snooping;
 
     // RX leakage
-    transceiver_rx_pwr_s = W2J(GlobalParams::power_configuration.hubPowerConfig
+    p.unit_s[TRANSCEIVER_RX_PWR_S] = W2J(GlobalParams::power_configuration.hubPowerConfig
                                    .transceiver_leakage.first);
     // TX leakage
-    transceiver_tx_pwr_s = W2J(GlobalParams::power_configuration.hubPowerConfig
+    p.unit_s[TRANSCEIVER_TX_PWR_S] = W2J(GlobalParams::power_configuration.hubPowerConfig
                                    .transceiver_leakage.second);
 
     // RX biasing
-    transceiver_rx_pwr_biasing =
+    p.unit_s[TRANSCEIVER_RX_PWR_BIASING] =
         W2J(GlobalParams::power_configuration.hubPowerConfig.transceiver_biasing
                 .first);
     // TX biasing
-    transceiver_tx_pwr_biasing =
+    p.unit_s[TRANSCEIVER_TX_PWR_BIASING] =
         W2J(GlobalParams::power_configuration.hubPowerConfig.transceiver_biasing
                 .second);
     // Link
@@ -395,127 +399,118 @@ void Power::configureHub(int link_width,
                length_r2h) !=
            GlobalParams::power_configuration.linkBitLinePowerConfig.end());
 
-    link_r2h_pwr_s = W2J(link_width * GlobalParams::power_configuration
+    p.unit_s[LINK_R2H_PWR_S] = W2J(link_width * GlobalParams::power_configuration
                                           .linkBitLinePowerConfig[length_r2h]
                                           .first);
-    link_r2h_pwr_d = link_width * GlobalParams::power_configuration
+    p.unit_d[LINK_R2H_PWR_D] = link_width * GlobalParams::power_configuration
                                       .linkBitLinePowerConfig[length_r2h]
                                       .second;
+
+    params_id = params_table.size();
+    params_table.push_back(p);
 }
 
 // Router buffer
 void Power::bufferRouterPush()
 {
-    power_dynamic.breakdown[BUFFER_PUSH_PWR_D].value += buffer_router_push_pwr_d;
+    dynamic_count[BUFFER_PUSH_PWR_D]++;
 }
 
 void Power::bufferRouterPop()
 {
-    power_dynamic.breakdown[BUFFER_POP_PWR_D].value += buffer_router_pop_pwr_d;
+    dynamic_count[BUFFER_POP_PWR_D]++;
 }
 
 void Power::bufferRouterFront()
 {
-    power_dynamic.breakdown[BUFFER_FRONT_PWR_D].value +=
-        buffer_router_front_pwr_d;
+    dynamic_count[BUFFER_FRONT_PWR_D]++;
 }
 
 // Hub to tile
 void Power::bufferToTilePush()
 {
-    power_dynamic.breakdown[BUFFER_TO_TILE_PUSH_PWR_D].value +=
-        buffer_to_tile_push_pwr_d;
+    dynamic_count[BUFFER_TO_TILE_PUSH_PWR_D]++;
 }
 
 void Power::bufferToTilePop()
 {
-    power_dynamic.breakdown[BUFFER_TO_TILE_POP_PWR_D].value +=
-        buffer_to_tile_pop_pwr_d;
+    dynamic_count[BUFFER_TO_TILE_POP_PWR_D]++;
 }
 
 void Power::bufferToTileFront()
 {
 
-    power_dynamic.breakdown[BUFFER_TO_TILE_FRONT_PWR_D].value +=
-        buffer_to_tile_front_pwr_d;
+    dynamic_count[BUFFER_TO_TILE_FRONT_PWR_D]++;
 }
 
 // Hub from tile
 void Power::bufferFromTilePush()
 {
-    power_dynamic.breakdown[BUFFER_FROM_TILE_PUSH_PWR_D].value +=
-        buffer_from_tile_push_pwr_d;
+    dynamic_count[BUFFER_FROM_TILE_PUSH_PWR_D]++;
 }
 
 void Power::bufferFromTilePop()
 {
-    power_dynamic.breakdown[BUFFER_FROM_TILE_POP_PWR_D].value +=
-        buffer_from_tile_pop_pwr_d;
+    dynamic_count[BUFFER_FROM_TILE_POP_PWR_D]++;
 }
 
 void Power::bufferFromTileFront()
 {
 
-    power_dynamic.breakdown[BUFFER_FROM_TILE_FRONT_PWR_D].value +=
-        buffer_from_tile_front_pwr_d;
+    dynamic_count[BUFFER_FROM_TILE_FRONT_PWR_D]++;
 }
 
 // Antenna buffers (RX/TX)
 void Power::antennaBufferPush()
 {
-    power_dynamic.breakdown[ANTENNA_BUFFER_PUSH_PWR_D].value +=
-        antenna_buffer_push_pwr_d;
+    dynamic_count[ANTENNA_BUFFER_PUSH_PWR_D]++;
 }
 
 void Power::antennaBufferPop()
 {
-    power_dynamic.breakdown[ANTENNA_BUFFER_POP_PWR_D].value +=
-        antenna_buffer_pop_pwr_d;
+    dynamic_count[ANTENNA_BUFFER_POP_PWR_D]++;
 }
 
 void Power::antennaBufferFront()
 {
-    power_dynamic.breakdown[ANTENNA_BUFFER_FRONT_PWR_D].value +=
-        antenna_buffer_front_pwr_d;
+    dynamic_count[ANTENNA_BUFFER_FRONT_PWR_D]++;
 }
 
 void Power::routing()
 {
-    power_dynamic.breakdown[ROUTING_PWR_D].value += routing_pwr_d;
+    dynamic_count[ROUTING_PWR_D]++;
 }
 
 void Power::selection()
 {
-    power_dynamic.breakdown[SELECTION_PWR_D].value += selection_pwr_d;
+    dynamic_count[SELECTION_PWR_D]++;
 }
 
 void Power::crossBar()
 {
-    power_dynamic.breakdown[CROSSBAR_PWR_D].value += crossbar_pwr_d;
+    dynamic_count[CROSSBAR_PWR_D]++;
 }
 
 void Power::r2rLink()
 {
-    power_dynamic.breakdown[LINK_R2R_PWR_D].value += link_r2r_pwr_d;
+    dynamic_count[LINK_R2R_PWR_D]++;
 }
 
 void Power::r2hLink()
 {
-    power_dynamic.breakdown[LINK_R2H_PWR_D].value += link_r2h_pwr_d;
+    dynamic_count[LINK_R2H_PWR_D]++;
 }
 
 void Power::networkInterface()
 {
-    power_dynamic.breakdown[NI_PWR_D].value += ni_pwr_d;
+    dynamic_count[NI_PWR_D]++;
 }
 
 double Power::getDynamicPower()
 {
     double power = 0.0;
-    for (int i = 0; i < power_dynamic.size; i++)
-    {
-        power += power_dynamic.breakdown[i].value;
-    }
+    for (int i = 0; i < NO_BREAKDOWN_ENTRIES_D; i++)
+        power += dynamicEnergy(i);
 
     return power;
 }
@@ -523,8 +518,8 @@ double Power::getDynamicPower()
 double Power::getStaticPower()
 {
     double power = 0.0;
-    for (int i = 0; i < power_static.size; i++)
-        power += power_static.breakdown[i].value;
+    for (int i = 0; i < NO_BREAKDOWN_ENTRIES_S; i++)
+        power += staticEnergy(i);
 
     return power;
 }
@@ -537,38 +532,31 @@ double Power::attenuation2power(double attenuation)
 
 void Power::wirelessTx(int src, int dst, int length)
 {
-    power_dynamic.breakdown[WIRELESS_TX].value += default_tx_energy;
-    return;
-
-    // TODO enable attenuation_map
-
-    pair<int, int> key = pair<int, int>(src, dst);
-    assert(attenuation_map.find(key) != attenuation_map.end());
+    dynamic_count[WIRELESS_TX]++;
 
-    power_dynamic.breakdown[WIRELESS_TX].value +=
-        attenuation2power(attenuation_map[key]) * length;
+    // TODO enable attenuation_map: per-(src,dst) energy cannot be expressed
+    // as a single per-event value, it needs its own accumulator
+    // (attenuation2power(attenuation_map[pair(src, dst)]) * length)
 }
 
 void Power::wirelessDynamicRx()
 {
-    power_dynamic.breakdown[WIRELESS_DYNAMIC_RX_PWR].value += wireless_rx_pwr;
+    dynamic_count[WIRELESS_DYNAMIC_RX_PWR]++;
 }
 
 void Power::wirelessSnooping()
 {
-    power_dynamic.breakdown[WIRELESS_SNOOPING].value += wireless_snooping;
+    dynamic_count[WIRELESS_SNOOPING]++;
 }
 
 void Power::biasingRx()
 {
-    power_static.breakdown[TRANSCEIVER_RX_PWR_BIASING].value +=
-        transceiver_rx_pwr_biasing;
+    static_count[TRANSCEIVER_RX_PWR_BIASING]++;
 }
 
 void Power::biasingTx()
 {
-    power_static.breakdown[TRANSCEIVER_TX_PWR_BIASING].value +=
-        transceiver_tx_pwr_biasing;
+    static_count[TRANSCEIVER_TX_PWR_BIASING]++;
 }
 
 // Note: In the following 3 functions buffer_pwr_s
@@ -577,56 +565,55 @@ void Power::biasingTx()
 // - Hub: takes the leakage value of buffer_from_tile/to_tile
 void Power::leakageBufferRouter()
 {
-    power_static.breakdown[BUFFER_ROUTER_PWR_S].value += buffer_router_pwr_s;
+    static_count[BUFFER_ROUTER_PWR_S]++;
 }
 
 void Power::leakageBufferToTile()
 {
-    power_static.breakdown[BUFFER_TO_TILE_PWR_S].value += buffer_to_tile_pwr_s;
+    static_count[BUFFER_TO_TILE_PWR_S]++;
 }
 
 void Power::leakageBufferFromTile()
 {
-    power_static.breakdown[BUFFER_FROM_TILE_PWR_S].value +=
-        buffer_from_tile_pwr_s;
+    static_count[BUFFER_FROM_TILE_PWR_S]++;
 }
 
 // Account for each buffer_rx (Targets) or buffer_tx (Initiators)
 void Power::leakageAntennaBuffer()
 {
-    power_static.breakdown[ANTENNA_BUFFER_PWR_S].value += (antenna_buffer_pwr_s);
+    static_count[ANTENNA_BUFFER_PWR_S]++;
 }
 
 void Power::leakageLinkRouter2Router()
 {
-    // power_static.breakdown[LINK_R2R_PWR_S].value +=link_r2r_pwr_s;
+    // static_count[LINK_R2R_PWR_S]++;
 }
 
 void Power::leakageLinkRouter2Hub()
 {
-    power_static.breakdown[LINK_R2H_PWR_S].value += link_r2h_pwr_s;
+    static_count[LINK_R2H_PWR_S]++;
 }
 
 void Power::leakageRouter()
 {
     // note: leakage contributions depending on instance number are
     // accounted in specific separate leakage functions
-    power_static.breakdown[ROUTING_PWR_S].value += routing_pwr_s;
-    power_static.breakdown[SELECTION_PWR_S].value += selection_pwr_s;
-    power_static.breakdown[CROSSBAR_PWR_S].value += crossbar_pwr_s;
-    power_static.breakdown[NI_PWR_S].value += ni_pwr_s;
+    static_count[ROUTING_PWR_S]++;
+    static_count[SELECTION_PWR_S]++;
+    static_count[CROSSBAR_PWR_S]++;
+    static_count[NI_PWR_S]++;
 }
 
 void Power::leakageTransceiverRx()
 {
 
-    power_static.breakdown[TRANSCEIVER_RX_PWR_S].value += transceiver_rx_pwr_s;
+    static_count[TRANSCEIVER_RX_PWR_S]++;
 }
 
 void Power::leakageTransceiverTx()
 {
 
-    power_static.breakdown[TRANSCEIVER_TX_PWR_S].value += transceiver_tx_pwr_s;
+    static_count[TRANSCEIVER_TX_PWR_S]++;
 }
 
 void Power::printBreakDown(std::ostream &out)
@@ -652,6 +639,43 @@ bool Power::isSleeping()
     return (now < sleep_end_cycle);
 }
 
+void Power::setLeakageInstances(int entry, int instances)
+{
+    assert(entry >= 0 && entry < NO_BREAKDOWN_ENTRIES_S);
+    leakage_instances[entry] = instances;
+}
+
+// 计数 -> 能量 (J)。单位能耗在 configureRouter/configureHub 之后不再变化，
+// 因此结果与逐事件浮点累加一致，只是省掉了仿真期间的浮点运算
+double Power::dynamicEnergy(int entry) const
+{
+    return dynamic_count[entry] * params_table[params_id].unit_d[entry];
+}
+
+double Power::staticEnergy(int entry) const
+{
+    uint64_t events = static_count[entry] +
+                      powered_cycles * (uint64_t)leakage_instances[entry];
+    return events * params_table[params_id].unit_s[entry];
+}
+
+// breakdown 的标签所有实例共用，返回的指针在下一次调用前有效
+PowerBreakdown *Power::getDynamicPowerBreakDown()
+{
+    initPowerBreakdown();
+    for (int i = 0; i < NO_BREAKDOWN_ENTRIES_D; i++)
+        power_dynamic.breakdown[i].value = dynamicEnergy(i);
+    return &power_dynamic;
+}
+
+PowerBreakdown *Power::getStaticPowerBreakDown()
+{
+    initPowerBreakdown();
+    for (int i = 0; i < NO_BREAKDOWN_ENTRIES_S; i++)
+        power_static.breakdown[i].value = staticEnergy(i);
+    return &power_static;
+}
+
 void Power::initPowerBreakdownEntry(PowerBreakdownEntry *pbe, string label)
 {
     pbe->label = label;
@@ -660,6 +684,9 @@ void Power::initPowerBreakdownEntry(PowerBreakdownEntry *pbe, string label)
 
 void Power::initPowerBreakdown()
 {
+    if (power_dynamic.size == NO_BREAKDOWN_ENTRIES_D)
+        return;
+
     power_dynamic.size = NO_BREAKDOWN_ENTRIES_D;
     power_static.size = NO_BREAKDOWN_ENTRIES_S;
 
@@ -13,12 +13,22 @@
 
 #include "DataStructs.h"
 #include <cassert>
+#include <cstdint>
 #include <map>
+#include <tuple>
+#include <vector>
 
 #include "yaml-cpp/yaml.h"
 
 using namespace std;
 
+// 已解析的单位能耗：动态项为 J/事件，静态项为 J/周期 (已由 W 换算)
+struct PowerParams {
+  double unit_d[NO_BREAKDOWN_ENTRIES_D];
+  double unit_s[NO_BREAKDOWN_ENTRIES_S];
+  map<pair<int, int>, double> attenuation_map; // hub only
+};
+
 class Power {
 
 public:
@@ -57,6 +67,10 @@ public:
   void r2rLink();
   void networkInterface();
 
+  // 每周期泄漏只记一个周期数，能量在报告时按 周期数 × 实例数 × 单位能耗 计算
+  void poweredCycle() { powered_cycles++; }
+  void setLeakageInstances(int entry, int instances);
+
   void leakageBufferRouter();
   void leakageBufferToTile();
   void leakageBufferFromTile();
@@ -76,72 +90,44 @@ public:
 
   void printBreakDown(std::ostream &out);
 
-  PowerBreakdown *getDynamicPowerBreakDown() { return &power_dynamic; }
-  PowerBreakdown *getStaticPowerBreakDown() { return &power_static; }
+  PowerBreakdown *getDynamicPowerBreakDown();
+  PowerBreakdown *getStaticPowerBreakDown();
 
   void rxSleep(int cycles);
   bool isSleeping();
 
 private:
-  double total_power_s;
-
-  double buffer_router_push_pwr_d;
-  double buffer_router_pop_pwr_d;
-  double buffer_router_front_pwr_d;
-  double buffer_router_pwr_s;
-
-  double buffer_to_tile_push_pwr_d;
-  double buffer_to_tile_pop_pwr_d;
-  double buffer_to_tile_front_pwr_d;
-  double buffer_to_tile_pwr_s;
-
-  double buffer_from_tile_push_pwr_d;
-  double buffer_from_tile_pop_pwr_d;
-  double buffer_from_tile_front_pwr_d;
-  double buffer_from_tile_pwr_s;
-
-  double antenna_buffer_push_pwr_d;
-  double antenna_buffer_pop_pwr_d;
-  double antenna_buffer_front_pwr_d;
-  double antenna_buffer_pwr_s;
+  // (level, link_width, buffer_depth, buffer_item_size, routing, selection)
+  typedef tuple<int, int, int, int, string, string> RouterParamsKey;
 
-  double wireless_rx_pwr;
-  double transceiver_tx_pwr_s;
-  double transceiver_rx_pwr_s;
-  double transceiver_tx_pwr_biasing;
-  double transceiver_rx_pwr_biasing;
-  double wireless_snooping;
+  // 所有 Power 实例共享的只读参数表，实例只保存下标
+  static vector<PowerParams> params_table;
+  static map<RouterParamsKey, int> router_params_index;
+  int params_id;
 
-  double default_tx_energy;
+  static PowerParams resolveRouterParams(int link_width, int buffer_depth,
+                                         int buffer_item_size,
+                                         const string &routing_function,
+                                         const string &selection_function,
+                                         int level);
 
-  double routing_pwr_d;
-  double routing_pwr_s;
-
-  double selection_pwr_d;
-  double selection_pwr_s;
-
-  double crossbar_pwr_d;
-  double crossbar_pwr_s;
-
-  double link_r2r_pwr_d;
-  double link_r2r_pwr_s;
-  double link_r2h_pwr_s;
-  double link_r2h_pwr_d;
-
-  double ni_pwr_d;
-  double ni_pwr_s;
-
-  map<pair<int, int>, double> attenuation_map;
   double attenuation2power(double);
 
-  void printBreakDown(string label, const map<string, double> &m,
-                      std::ostream &out) const;
+  // 仿真期间只累加整数事件计数，breakdown 的值在读取时才由计数换算成能量
+  uint64_t dynamic_count[NO_BREAKDOWN_ENTRIES_D];
+  uint64_t static_count[NO_BREAKDOWN_ENTRIES_S];
+  uint64_t powered_cycles;
+  int leakage_instances[NO_BREAKDOWN_ENTRIES_S];
+
+  double dynamicEnergy(int entry) const;
+  double staticEnergy(int entry) const;
 
-  PowerBreakdown power_dynamic;
-  PowerBreakdown power_static;
+  // 报告用的 breakdown 只在读取时填充，所有实例共用一份
+  static PowerBreakdown power_dynamic;
+  static PowerBreakdown power_static;
 
-  void initPowerBreakdownEntry(PowerBreakdownEntry *pbe, string label);
-  void initPowerBreakdown();
+  static void initPowerBreakdownEntry(PowerBreakdownEntry *pbe, string label);
+  static void initPowerBreakdown();
 
   int sleep_end_cycle;
 };
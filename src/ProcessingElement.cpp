@@ -9,12 +9,34 @@
  */
 
 #include "ProcessingElement.h"
+#include "FlitTrace.h"
+#include "InjectionTrace.h"
+#include "Profiler.h"
 #include "dbg.h"
 #include <cmath>
+#include <limits>
 #include <numeric>
+
+unsigned int ProcessingElement::next_packet_id_ = 0;
+
 int ProcessingElement::randInt(int min, int max)
 {
-  return min + (int)((double)(max - min + 1) * rand() / (RAND_MAX + 1.0));
+  return rng.uniformInt(min, max);
+}
+
+// 同一角色的 PE 由同一份工作负载配置得到完全相同的任务时间线，TaskManager
+// 每个角色只构建一次，由这些 PE 共享 (配置后只读)。所有 PE 析构后重新构建
+static std::shared_ptr<TaskManager> shared_task_manager(const char *role)
+{
+  static std::map<std::string, std::weak_ptr<TaskManager>> cache;
+  std::shared_ptr<TaskManager> task_manager = cache[role].lock();
+  if (!task_manager)
+  {
+    task_manager = std::make_shared<TaskManager>();
+    task_manager->Configure(GlobalParams::workload, role);
+    cache[role] = task_manager;
+  }
+  return task_manager;
 }
 
 ProcessingElement::~ProcessingElement()
@@ -35,6 +57,7 @@ void ProcessingElement::configure(int id, int level_idx,
   //========================================================================
   this->local_id = id;
   this->level_index = level_idx;
+  this->rng = RngService::stream(RNG_DOMAIN_PE, id);
   if (GlobalParams::pe_registry.size() <= static_cast<size_t>(local_id))
   {
     GlobalParams::pe_registry.resize(local_id + 1, nullptr);
@@ -68,11 +91,11 @@ void ProcessingElement::configure(int id, int level_idx,
   }
 
   // 配置下游
-  int num_children = GlobalParams::fanouts_per_level[level_idx];
-  int *children = GlobalParams::child_map[this->local_id];
-  for (int i = 0; i < num_children; i++)
+  int num_children = GlobalParams::numChildren(this->local_id, level_idx);
+  if (num_children > 0)
   {
-    this->downstream_node_ids.push_back(children[i]);
+    const int *children = GlobalParams::childrenOf(this->local_id);
+    this->downstream_node_ids.assign(children, children + num_children);
   }
 
   //========================================================================
@@ -86,8 +109,7 @@ void ProcessingElement::configure(int id, int level_idx,
     unified_buffer_manager_ = new BufferManager(max_capacity);
 
     // 配置TaskManager
-    task_manager_ = std::unique_ptr<TaskManager>(new TaskManager());
-    task_manager_->Configure(GlobalParams::workload, "ROLE_DRAM");
+    task_manager_ = shared_task_manager("ROLE_DRAM");
     auto dataset = task_manager_->get_current_working_set();
     if (dataset.inputs >= 0 && dataset.weights >= 0)
     {
@@ -121,8 +143,7 @@ void ProcessingElement::configure(int id, int level_idx,
     current_data_size.write(unified_buffer_manager_->GetCurrentSize());
 
     // 配置TaskManager
-    task_manager_ = std::unique_ptr<TaskManager>(new TaskManager());
-    task_manager_->Configure(GlobalParams::workload, "ROLE_GLB");
+    task_manager_ = shared_task_manager("ROLE_GLB");
     // 使用配置的outputs_required_count值
     auto *role_working_set =
         task_manager_->get_working_set_for_role("ROLE_GLB");
@@ -151,8 +172,7 @@ void ProcessingElement::configure(int id, int level_idx,
     current_data_size.write(unified_buffer_manager_->GetCurrentSize());
 
     // 配置TaskManager
-    task_manager_ = std::unique_ptr<TaskManager>(new TaskManager());
-    task_manager_->Configure(GlobalParams::workload, "ROLE_BUFFER");
+    task_manager_ = shared_task_manager("ROLE_BUFFER");
 
     // 从配置中读取自驱逐参数
     const RoleProperties *props =
@@ -198,6 +218,37 @@ void ProcessingElement::configure(int id, int level_idx,
   //========================================================================
   logical_timestamp = 0;
 
+  // 存储层按调度推导的 tile 时间线跟踪驻留 tile (命中/缺失统计)
+  if ((role == ROLE_DRAM || role == ROLE_GLB) && task_manager_->is_configured())
+  {
+    TileReplacementPolicy policy = TileReplacementPolicy::LRU;
+    ParseTileReplacementPolicy(GlobalParams::tile_replacement, policy);
+    task_manager_->build_tile_timeline();
+    unified_buffer_manager_->EnableTileTracking(
+        policy, &task_manager_->get_tile_timeline());
+  }
+
+  // 按数据类型选择 LOCAL 端口 (Tile 只绑定本层用到的端口)
+  num_local_ports_ = level_config.num_local_ports;
+  std::copy(level_config.local_port, level_config.local_port + NUM_DATA_TYPES,
+            local_port_);
+
+  // 按数据类型选择 VC，发送时按本层策略在 VC 之间仲裁
+  std::copy(level_config.vc_of_type, level_config.vc_of_type + NUM_DATA_TYPES,
+            vc_of_type_);
+  vc_arbiter_.configure(level_config.vc_arbitration, level_config.vc_weights,
+                        GlobalParams::n_virtual_channels);
+
+  // 存储层在当前时间步完成之前最多预取的时间步数
+  prefetch_depth_ = level_config.prefetch_depth;
+  dispatch_window_.clear();
+
+  // 双缓冲：计算/分发占用当前 bank 时，下一时间步的数据写入另一个 bank
+  if (level_config.double_buffer && unified_buffer_manager_ != nullptr)
+  {
+    unified_buffer_manager_->EnableDoubleBuffering();
+  }
+
   // 调试日志
   LOG << "PE[" << local_id << "] configured as " << role_to_str(role)
       << " at level " << level_idx << endl;
@@ -214,33 +265,25 @@ int ProcessingElement::find_child_id(int id)
 
 void ProcessingElement::rxProcess()
 {
+  PROFILE_SCOPE(PROF_PE_RX, level_index);
   // --- 0. 复位逻辑 ---
   if (reset.read())
   {
     // 重置接收状态计数器
-    main_receiving_size_ = 0;
-    output_receiving_size_ = 0;
+    std::fill(std::begin(receiving_size_), std::end(receiving_size_), 0);
+
+    // LOCAL 链路由发送方 (Router) 复位
 
+    // 清空所有缓冲区
     for (int i = 0; i < NUM_LOCAL_PORTS; ++i)
     {
-      ack_rx[i].write(0);
-      current_level_rx[i] = 0;
-
-      // 重置 buffer_full_status_rx 输出端口（表示所有VC都未满）
-      TBufferFullStatus reset_status;
-      for (int vc = 0; vc < MAX_VIRTUAL_CHANNELS; ++vc)
+      rx_buffer[i].fill(Buffer()); // 重新构造所有Buffer
+      for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++)
       {
-        reset_status.mask[vc] = false; // false 表示未满
+        rx_buffer[i][vc].SetMaxBufferSize(GlobalParams::buffer_depth);
+        rx_buffer[i][vc].setLabel(string(name()) + "->buffer[" +
+                                  std::to_string(i) + "]");
       }
-      buffer_full_status_rx[i].write(reset_status);
-    }
-
-    // 清空所有缓冲区
-    rx_buffer.fill(Buffer()); // 重新构造所有Buffer
-    for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++)
-    {
-      rx_buffer[vc].SetMaxBufferSize(GlobalParams::buffer_depth);
-      rx_buffer[vc].setLabel(string(name()) + "->buffer[0]");
     }
     return;
   }
@@ -257,106 +300,87 @@ void ProcessingElement::rxProcess()
   // ==========================================================
   // 阶段二: 接收新的入站 Flit
   // ==========================================================
-  // 这部分是物理接收逻辑，负责将新来的 Flit Push 进 rx_buffer
-  for (int i = 0; i < NUM_LOCAL_PORTS; ++i)
+  // 这部分是物理接收逻辑，负责将新来的 Flit Push 进 rx_buffer。
+  // 每个 LOCAL 端口有自己的缓冲区，一个包的所有 flit 都经同一个端口到达
+  for (int i = 0; i < num_local_ports_; ++i)
   {
-    if (i == 0)
+    // 接收链路上本周期到达的所有 Flit
+    while (link_rx[i]->available())
     {
-      // --- Port 0: 新的支持VC的缓冲逻辑 ---
-
-      // 物理握手：检查是否有新的请求req_rx[port_index].read() == 1 -
-      // current_level
-      if (req_rx[0].read() == 1 - current_level_rx[0])
-      {
 
-        // 读取 Flit
-        Flit flit = flit_rx[0].read();
+      // 读取 Flit
+      Flit flit = link_rx[i]->receive();
 
-        // 获取 VC ID
-        int vc_id = flit.vc_id;
+      // 获取 VC ID
+      int vc_id = flit.vc_id;
 
-        // 检查 VC ID 是否有效
-        if (vc_id >= 0 && vc_id < MAX_VIRTUAL_CHANNELS)
-        {
+      // 检查 VC ID 是否有效
+      if (vc_id >= 0 && vc_id < MAX_VIRTUAL_CHANNELS)
+      {
 
-          // 推入 BufferBank 中对应的 VC 缓冲区
-          // 使用断言确保缓冲区未满（通过流控机制保证）
-          assert(!rx_buffer[vc_id].IsFull() &&
-                 "VC buffer should not be full due to backpressure");
-
-          rx_buffer[vc_id].Push(flit);
-
-          // 确认握手：翻转 current_level 并写入 ack_rx
-          current_level_rx[0] = 1 - current_level_rx[0];
-          ack_rx[0].write(current_level_rx[0]);
-
-          // 调试日志
-          LOG << "@" << sc_time_stamp() << " [" << name() << "]: "
-              << "[RX_PORT0] Received Flit on VC " << vc_id
-              << " src_id=" << flit.src_id << " dst_id=" << flit.dst_id
-              << " flit_type=" << flit.flit_type
-              << " buffer_size=" << rx_buffer[vc_id].Size()
-              << " flit_data_type=" << DataType_to_str(flit.data_type)
-              << " flit_seq_no=" << flit.sequence_no
-              << " flit_command=" << flit.command << std::endl
-              << " target_role=" << role_to_str(flit.target_role);
-        }
-        else
-        {
-          // 无效的 VC ID - 这是编程错误，应该使用断言
-          assert(false && "Invalid VC ID received");
-        }
+        // 推入 BufferBank 中对应的 VC 缓冲区
+        // 使用断言确保缓冲区未满（通过流控机制保证）
+        assert(!rx_buffer[i][vc_id].IsFull() &&
+               "VC buffer should not be full due to backpressure");
+
+        rx_buffer[i][vc_id].Push(flit);
+
+        if (FlitTrace::enabled())
+          FlitTrace::record(sc_time_stamp().to_double() /
+                                GlobalParams::clock_period_ps,
+                            local_id, i, vc_id, flit.flit_type,
+                            flit.packet_id, static_cast<int>(flit.data_type),
+                            flit.command, FT_EJECT);
+
+        // 调试日志
+        LOG << "@" << sc_time_stamp() << " [" << name() << "]: "
+            << "[RX_PORT" << i << "] Received Flit on VC " << vc_id
+            << " src_id=" << flit.src_id << " dst_id=" << flit.dst_id
+            << " flit_type=" << flit.flit_type
+            << " buffer_size=" << rx_buffer[i][vc_id].Size()
+            << " flit_data_type=" << DataType_to_str(flit.data_type)
+            << " flit_seq_no=" << flit.sequence_no
+            << " flit_command=" << flit.command << std::endl
+            << " target_role=" << role_to_str(flit.target_role);
+      }
+      else
+      {
+        // 无效的 VC ID - 这是编程错误，应该使用断言
+        assert(false && "Invalid VC ID received");
       }
-    }
-    else if (i == 1)
-    {
-      // --- Port 1: 暂时保留旧逻辑或占位符 ---
-      // TODO: 为 port 1 实现新的缓冲逻辑
-
-      // 暂时保留旧的调用（标记为待删除）
-      // handle_rx_for_port(1);
-
-      // 或者暂时留空
     }
   }
 
   // ==========================================================
   // 阶段三: 更新对上游的流控信号
   // ==========================================================
-  // 这个逻辑报告的是物理缓冲区 rx_buffer 的状态
-  for (int i = 0; i < NUM_LOCAL_PORTS; ++i)
+  // 这个逻辑报告的是各端口物理缓冲区 rx_buffer 的状态
+  for (int i = 0; i < num_local_ports_; ++i)
   {
-    TBufferFullStatus status;
+    unsigned int mask = 0; // 置位表示该 VC 已满
 
-    if (i == 0)
-    {
-      // Port 0: 检查每个 VC 的缓冲区状态
-      for (int vc = 0; vc < MAX_VIRTUAL_CHANNELS; ++vc)
-      {
-        status.mask[vc] = rx_buffer[vc].IsFull(); // true 表示已满
-      }
-    }
-    else
+    // 空位不足一个周期的 burst 即视为满 (宽链路一周期到达多个)
+    unsigned int burst = link_rx[i]->burstSize();
+    for (int vc = 0; vc < GlobalParams::n_virtual_channels; ++vc)
     {
-      // Port 1: 暂时返回默认状态（所有VC都未满）
-      for (int vc = 0; vc < MAX_VIRTUAL_CHANNELS; ++vc)
-      {
-        status.mask[vc] = false; // false 表示未满
-      }
+      if (rx_buffer[i][vc].getCurrentFreeSlots() < burst)
+        mask |= 1u << vc;
     }
 
-    // 写入流控状态输出端口
-    buffer_full_status_rx[i].write(status);
+    // 写入流控状态
+    link_rx[i]->setFullMask(mask);
   }
 }
 
 // 新增：内部流式处理函数实现
 void ProcessingElement::internal_transfer_process()
 {
-  // 遍历所有虚拟通道
-  for (int vc = 0; vc < GlobalParams::n_virtual_channels; ++vc)
+  // 遍历所有 LOCAL 端口的所有虚拟通道
+  int n_vcs = GlobalParams::n_virtual_channels;
+  for (int k = 0; k < num_local_ports_ * n_vcs; ++k)
   {
-    Buffer &vc_buffer = rx_buffer[vc];
+    int vc = k % n_vcs;
+    Buffer &vc_buffer = rx_buffer[k / n_vcs][vc];
 
     // 流式处理循环：处理该VC中所有可以处理的Flit
     while (!vc_buffer.IsEmpty())
@@ -379,33 +403,35 @@ void ProcessingElement::internal_transfer_process()
           continue; // 继续处理下一个flit
         }
 
-        // 正常数据包的流控检查
-        size_t *receiving_size = nullptr;
-
-        if (flit.data_type == DataType::OUTPUT)
+        // 正常数据包的流控检查：多载荷包的每个载荷按各自的数据类型检查，
+        // 全部放得下才接收
+        DataType types[3];
+        size_t sizes[3];
+        int num_payloads = split_payloads(flit.payload_sizes, flit.data_type,
+                                          flit.payload_data_size, types, sizes);
+        size_t required[NUM_DATA_TYPES];
+        std::copy(std::begin(receiving_size_), std::end(receiving_size_),
+                  required);
+        for (int k = 0; k < num_payloads; k++)
+          required[static_cast<int>(types[k])] += sizes[k];
+
+        bool fits = true;
+        bool carries_command = false;
+        for (int k = 0; k < num_payloads && fits; k++)
         {
-          receiving_size = &output_receiving_size_;
+          // 执行关键的流控决策 (双缓冲时按正在接收数据的 bank 判断)
+          fits = unified_buffer_manager_->CanAcceptPending(types[k], required);
+          carries_command |= types[k] != DataType::WEIGHT;
         }
-        else
-        {
-          receiving_size = &main_receiving_size_;
-        }
-
-        // 执行关键的流控决策
-        size_t required_capacity =
-            unified_buffer_manager_->GetCurrentSize(flit.data_type) +
-            *receiving_size + flit.payload_data_size;
 
-        if (required_capacity <=
-            unified_buffer_manager_->GetCapacity(flit.data_type))
+        if (fits)
         {
-          // 检查通过：预留空间
-          *receiving_size += flit.payload_data_size;
+          // 检查通过：按类型预留空间
+          std::copy(std::begin(required), std::end(required), receiving_size_);
           vc_buffer.Pop();
 
           // 处理command_id等元数据
-          if (flit.command != -1 &&
-              flit.data_type != DataType::WEIGHT)
+          if (flit.command != -1 && carries_command)
           { // need fix
             pending_commands_[flit.logical_timestamp] = flit.command;
           }
@@ -413,14 +439,16 @@ void ProcessingElement::internal_transfer_process()
           LOG << "[INTERNAL_TRANSFER] Accepted HEAD Flit on VC " << vc
               << " src_id=" << flit.src_id
               << " payload=" << flit.payload_data_size
-              << " reserved_space=" << *receiving_size
+              << " reserved_space="
+              << std::accumulate(std::begin(receiving_size_),
+                                 std::end(receiving_size_), size_t(0))
               << " command_id=" << flit.command << endl;
         }
         else
         {
           // 逻辑缓冲区空间不足，阻塞当前VC
           LOG << "[INTERNAL_TRANSFER] HEAD Flit BLOCKED on VC " << vc
-              << " required=" << required_capacity << " capacity="
+              << " payload=" << flit.payload_data_size << " capacity="
               << unified_buffer_manager_->GetCapacity(flit.data_type) << endl;
           break;
         }
@@ -446,39 +474,32 @@ void ProcessingElement::internal_transfer_process()
 
           vc_buffer.Pop();
 
-          cout << "sc_timestamp = " << sc_time_stamp()
-               << " cycle= " << current_cycle
-               << "[INTERNAL_TRANSFER] Processed OUTPUT_RETURN TAIL Flit on VC "
-               << vc << " src_id=" << flit.src_id
-               << " payload=" << flit.payload_data_size
-               << " total_outputs_received=" << outputs_received_count_ << "/"
-               << outputs_required_count_ << endl;
+          LOG << "[INTERNAL_TRANSFER] Processed OUTPUT_RETURN TAIL Flit on VC "
+              << vc << " src_id=" << flit.src_id
+              << " payload=" << flit.payload_data_size
+              << " total_outputs_received=" << outputs_received_count_ << "/"
+              << outputs_required_count_ << endl;
 
           // 通知可能等待输出的逻辑
           buffer_state_changed_event.notify(SC_ZERO_TIME);
           continue;
         }
 
-        // 正常数据包的TAIL处理
-        size_t *receiving_size = nullptr;
+        // 正常数据包的TAIL处理：每个载荷分别调用OnDataReceived"入库"
+        DataType types[3];
+        size_t sizes[3];
+        int num_payloads = split_payloads(flit.payload_sizes, flit.data_type,
+                                          flit.payload_data_size, types, sizes);
 
-        if (flit.data_type == DataType::OUTPUT)
-        {
-          receiving_size = &output_receiving_size_;
-        }
-        else
+        for (int k = 0; k < num_payloads; k++)
         {
-          receiving_size = &main_receiving_size_;
+          size_t &receiving_size = receiving_size_[static_cast<int>(types[k])];
+          unified_buffer_manager_->OnDataReceived(types[k], sizes[k]);
+          // 释放预留的空间
+          assert(receiving_size >= sizes[k] && "Receiving size underflow");
+          receiving_size -= sizes[k];
         }
 
-        // 调用OnDataReceived将数据正式"入库"
-        unified_buffer_manager_->OnDataReceived(flit.data_type,
-                                                flit.payload_data_size);
-        // 释放预留的空间
-        assert(*receiving_size >= flit.payload_data_size &&
-               "Receiving size underflow");
-        *receiving_size -= flit.payload_data_size;
-
         vc_buffer.Pop();
 
         // 通知计算逻辑
@@ -497,20 +518,19 @@ void ProcessingElement::internal_transfer_process()
   }
 }
 // 新增：统一的VC发送处理函数实现
-void ProcessingElement::handle_tx_for_all_vcs()
+bool ProcessingElement::handle_tx_for_all_vcs()
 {
-  // [核心] 遍历所有 VC 发送队列
+  // [核心] 按 VC 仲裁器给出的顺序遍历所有 VC 发送队列
+  const int *vc_order = vc_arbiter_.order();
   for (int i = 0; i < GlobalParams::n_virtual_channels; ++i)
   {
-    int vc = (last_serviced_vc_ + 1 + i) % GlobalParams::n_virtual_channels;
+    int vc = vc_order[i];
     // 如果这个 VC 的队列里没有包，跳过
     if (packet_queues_[vc].empty())
     {
       continue;
     }
 
-    // 检查当前端口是否正在等待ACK（简化模型：假设统一使用port 0）
-
     // "窥视"队首的包
     Packet &packet_to_send = packet_queues_[vc].front();
 
@@ -532,26 +552,21 @@ void ProcessingElement::handle_tx_for_all_vcs()
         continue;
       }
 
+      on_packet_dequeued(packet_to_send);
       packet_queues_[vc].pop();
-      last_serviced_vc_ = vc;
+      vc_arbiter_.served(vc);
       LOG << "[TX_VC" << vc << "] Direct-delivered packet "
           << "src=" << packet_to_send.src_id
           << " payload=" << packet_to_send.payload_data_size
           << " type=" << DataType_to_str(packet_to_send.data_type)
           << " command_id=" << packet_to_send.command << endl;
-      break;
-    }
-
-    // Physical flit path still requires ABP handshake readiness.
-    if (ack_tx[0].read() != current_level_tx[0])
-    {
-      continue;
+      return false;
     }
 
-    // 检查下游邻居的 VC 流控状态
-    TBufferFullStatus downstream_status = buffer_full_status_tx[0].read();
-
-    if (downstream_status.mask[vc] == true || packet_queues_[vc].empty())
+    // 检查本包数据类型对应的 LOCAL 链路的流控 (下游 VC 满掩码) 和带宽预算，
+    // 两个端口的预算互不影响
+    int port = local_port_[static_cast<int>(packet_to_send.data_type)];
+    if (!link_tx[port]->canSend(vc))
     {
       // 这个 VC 被阻塞了，跳过，去处理下一个 VC
       continue;
@@ -563,12 +578,18 @@ void ProcessingElement::handle_tx_for_all_vcs()
 
     // 设置VC ID
     flit_to_send.vc_id = vc;
-    last_serviced_vc_ = vc;
+    vc_arbiter_.served(vc);
 
-    // 物理发送 (统一到 Port 0)
-    flit_tx[0].write(flit_to_send);
-    current_level_tx[0] = 1 - current_level_tx[0];
-    req_tx[0].write(current_level_tx[0]);
+    // 物理发送
+    link_tx[port]->send(flit_to_send);
+
+    if (FlitTrace::enabled())
+      FlitTrace::record(sc_time_stamp().to_double() /
+                            GlobalParams::clock_period_ps,
+                        local_id, port, vc, flit_to_send.flit_type,
+                        flit_to_send.packet_id,
+                        static_cast<int>(flit_to_send.data_type),
+                        flit_to_send.command, FT_INJECT);
 
     // 打印发送日志
     LOG << "[TX_VC" << vc << "] Sent Flit type=" << flit_to_send.flit_type
@@ -582,9 +603,10 @@ void ProcessingElement::handle_tx_for_all_vcs()
       LOG << "[TX_VC" << vc << "] Completed packet transmission" << endl;
     }
 
-    // 既然我们每周期只发送一个 Flit，就在成功发送后退出循环
-    break;
+    // 每次调用只发送一个 Flit，宽链路由 txProcess 重复调用
+    return true;
   }
+  return false;
 }
 
 // 新增：辅助函数实现
@@ -602,44 +624,14 @@ bool ProcessingElement::packet_queues_are_empty() const
 
 int ProcessingElement::get_vc_id_for_packet(const Packet &pkt) const
 {
-  if (pkt.data_type == DataType::WEIGHT)
-  {
-    return 0; // 权重数据使用VC 0
-  }
-  else if (pkt.data_type == DataType::INPUT)
-  {
-    return 1; // 输入数据使用VC 1
-  }
-  else if (pkt.data_type == DataType::OUTPUT)
-  {
-    return 2; // 输出数据使用VC 2
-  }
-  else
-  {
-    return 0; // 默认VC 0
-  }
+  // 按本层的 vc_map 分配 VC (默认 WEIGHT 0 / INPUT 1 / OUTPUT 2)
+  return vc_of_type_[static_cast<int>(pkt.data_type)];
 }
 
 int ProcessingElement::get_vc_id_for_packet_by_task(
     DataDispatchInfo task) const
 {
-  // 根据数据类型分配VC ID的辅助函数
-  if (task.type == DataType::WEIGHT)
-  {
-    return 0; // 权重数据使用VC 0
-  }
-  else if (task.type == DataType::INPUT)
-  {
-    return 1; // 输入数据使用VC 1
-  }
-  else if (task.type == DataType::OUTPUT)
-  {
-    return 2; // 输出数据使用VC 2
-  }
-  else
-  {
-    return 0; // 默认VC 0
-  }
+  return vc_of_type_[static_cast<int>(task.type)];
 }
 
 bool ProcessingElement::can_accept_direct_packet(const Packet &pkt) const
@@ -655,9 +647,18 @@ bool ProcessingElement::can_accept_direct_packet(const Packet &pkt) const
     return true;
   }
 
-  size_t current_size = unified_buffer_manager_->GetCurrentSize(pkt.data_type);
-  size_t cap = unified_buffer_manager_->GetCapacity(pkt.data_type);
-  return current_size + static_cast<size_t>(pkt.payload_data_size) <= cap;
+  DataType types[3];
+  size_t sizes[3];
+  int num_payloads = split_payloads(pkt.payload_sizes, pkt.data_type,
+                                    pkt.payload_data_size, types, sizes);
+  for (int k = 0; k < num_payloads; k++)
+  {
+    if (!unified_buffer_manager_->CanAccept(types[k], sizes[k]))
+    {
+      return false;
+    }
+  }
+  return true;
 }
 
 bool ProcessingElement::receive_direct_packet(const Packet &pkt, int src_id)
@@ -675,8 +676,17 @@ bool ProcessingElement::receive_direct_packet(const Packet &pkt, int src_id)
     return true;
   }
 
-  unified_buffer_manager_->OnDataReceived(pkt.data_type, pkt.payload_data_size);
-  if (pkt.command != -1 && pkt.data_type != DataType::WEIGHT)
+  DataType types[3];
+  size_t sizes[3];
+  int num_payloads = split_payloads(pkt.payload_sizes, pkt.data_type,
+                                    pkt.payload_data_size, types, sizes);
+  bool carries_command = false;
+  for (int k = 0; k < num_payloads; k++)
+  {
+    unified_buffer_manager_->OnDataReceived(types[k], sizes[k]);
+    carries_command |= types[k] != DataType::WEIGHT;
+  }
+  if (pkt.command != -1 && carries_command)
   {
     pending_commands_[pkt.logical_timestamp] = pkt.command;
   }
@@ -774,15 +784,16 @@ bool ProcessingElement::direct_deliver_packet(const Packet &pkt)
 
 void ProcessingElement::txProcess()
 {
+  PROFILE_SCOPE(PROF_PE_TX, level_index);
   // 复位逻辑保持不变（更新以清空新的VC队列）
   if (reset.read())
   {
-    req_tx[0].write(0);
-    current_level_tx[0] = 0;
+    for (int i = 0; i < num_local_ports_; ++i)
+      link_tx[i]->reset();
     compute_in_progress_ = false;
     is_compute_complete = false;
     compute_cycles = 0;
-    last_serviced_vc_ = -1;
+    vc_arbiter_.reset();
 
     // 清空所有VC队列
     for (auto &q : packet_queues_)
@@ -790,6 +801,8 @@ void ProcessingElement::txProcess()
       while (!q.empty())
         q.pop();
     }
+    dispatch_window_.clear();
+    queued_return_packets_ = 0;
     return;
   }
 
@@ -812,7 +825,9 @@ void ProcessingElement::txProcess()
   }
 
   // --- 步骤 B: [核心替换] 调用新的统一发送处理器 ---
-  handle_tx_for_all_vcs();
+  // 宽链路每周期可以发送多个 flit，直到链路的带宽预算或流控不再允许
+  while (handle_tx_for_all_vcs())
+    ;
 
   // 计算当前需要的输出数量
   size_t required_outputs = outputs_required_count_;
@@ -842,8 +857,11 @@ void ProcessingElement::txProcess()
     return; // 阻塞时间步递增
   }
 
-  if (role != ROLE_BUFFER && current_dispatch_task_.sub_tasks.empty() &&
-      packet_queues_are_empty() && dispatch_in_progress_)
+  // 最早的时间步所有子任务都已发出 (回送包也已发出) 时完成该时间步
+  if (role != ROLE_BUFFER && dispatch_in_progress_ &&
+      dispatch_window_.front().task.sub_tasks.empty() &&
+      dispatch_window_.front().queued_packets == 0 &&
+      queued_return_packets_ == 0)
   {
     if (task_manager_->is_in_sync_points(logical_timestamp))
     {
@@ -858,16 +876,20 @@ void ProcessingElement::txProcess()
         outputs_received_count_ -= outputs_required_count_;
       }
     }
+    dispatch_window_.pop_front();
     logical_timestamp++;
-    dispatch_in_progress_ = false;
+    dispatch_in_progress_ = !dispatch_window_.empty();
     if (role == ROLE_DRAM)
-      cout << sc_time_stamp() << ": PE[" << local_id
-           << "] Completed dispatch for timestamp " << logical_timestamp - 1
-           << endl;
+      LOG_LOW << "PE[" << local_id << "] Completed dispatch for timestamp "
+              << logical_timestamp - 1 << endl;
     if (logical_timestamp >= task_manager_->get_total_timesteps())
     {
       reset_logic();
     }
+    unified_buffer_manager_->ReleaseBank();
+    // 已预取的下一个时间步成为当前分发的时间步
+    if (dispatch_in_progress_)
+      unified_buffer_manager_->AcquireBank();
   }
 
   if (role == ROLE_BUFFER && is_compute_complete == true)
@@ -890,6 +912,8 @@ void ProcessingElement::txProcess()
     {
       reset_logic();
     }
+    // 本时间步的数据已驱逐，另一个 bank 中的数据供下一次计算使用
+    unified_buffer_manager_->ReleaseBank();
   }
 }
 
@@ -906,6 +930,7 @@ void ProcessingElement::reset_logic()
   {
 
     auto it = pending_commands_.begin();
+    int timestamp = it->first;
     int command = it->second;
     pending_commands_.erase(it);
     DataDelta cmd;
@@ -928,14 +953,11 @@ void ProcessingElement::reset_logic()
       pkt.dst_id = -2;
       pkt.payload_data_size = cmd.outputs;
       pkt.data_type = DataType::OUTPUT;
-      int bandwidth_scale =
-          GlobalParams::hierarchical_config.get_level_config(level_index - 1)
-              .bandwidth /
-          GlobalParams::word_bits;
-      pkt.size = pkt.flit_left =
-          (cmd.outputs + bandwidth_scale - 1) / bandwidth_scale + 2;
+      // 上游聚合 router 以 (logical_timestamp, sequence_no) 匹配各子节点的回送
+      pkt.logical_timestamp = timestamp;
+      pkt.size = pkt.flit_left = payload_flits(cmd.outputs) + 2;
       pkt.command = -1; // 表示这是一个回送包
-      pkt.vc_id = 2;    // 回送包使用vc 0
+      pkt.vc_id = vc_of_type_[static_cast<int>(DataType::OUTPUT)];
 
       pkt.target_role = static_cast<PE_Role>(static_cast<int>(role) - 1);
       // dbg(sc_time_stamp(), name(), "[RESET_LOGIC] Generating output return
@@ -945,11 +967,14 @@ void ProcessingElement::reset_logic()
           << pkt.target_role << " for " << cmd.outputs << " bytes." << endl;
 
       packet_queues_[pkt.vc_id].push(pkt);
+      queued_return_packets_++;
+      if (InjectionTrace::recording())
+        record_injection(pkt);
     }
     unified_buffer_manager_->RemoveData(DataType::OUTPUT, cmd.outputs);
 
     LOG << sc_time_stamp() << ": PE[" << local_id << "]"
-        << " Resetting for timestamp " << it->first << " "
+        << " Resetting for timestamp " << timestamp << " "
         << unified_buffer_manager_->GetCurrentSize() << "/"
         << unified_buffer_manager_->GetCapacity()
         << " bytes remaining after resetting for timestamp "
@@ -1016,6 +1041,7 @@ void ProcessingElement::run_compute_logic()
 
     // 所有数据都准备好了，开始计算。
     // 注意：本周期只进入“计算中”状态，不立刻扣减，避免墙钟观测少1个周期。
+    unified_buffer_manager_->AcquireBank();
     int latency = task_manager_->get_compute_latency();
     if (latency <= 0)
     {
@@ -1096,6 +1122,12 @@ int ProcessingElement::calculate_target_count(int current_level,
   return target_count;
 }
 
+int ProcessingElement::payload_flits(int words) const
+{
+  int bits = words * GlobalParams::word_bits;
+  return (bits + GlobalParams::flit_size - 1) / GlobalParams::flit_size;
+}
+
 int ProcessingElement::get_target_bandwidth(int current_level,
                                             PE_Role target_role)
 {
@@ -1135,153 +1167,392 @@ void ProcessingElement::run_storage_logic()
     return;
   }
 
-  if (!dispatch_in_progress_)
+  // 打开 logical_timestamp 以及之后最多 prefetch_depth_ 个时间步
+  while (dispatch_window_.size() <= static_cast<size_t>(prefetch_depth_) &&
+         open_dispatch_timestep(logical_timestamp + dispatch_window_.size()))
+    ;
+
+  // --- 1. [核心] 按时间步顺序为空闲的VC生成包 ---
+  // 同一VC上较早时间步的子任务尚未入队时，后面时间步的子任务不能越过它
+  bool vc_blocked[MAX_VIRTUAL_CHANNELS] = {false};
+
+  for (DispatchWindowEntry &entry : dispatch_window_)
   {
-    std::map<DataType, size_t> data_map =
-        task_manager_->get_working_set_for_role(role_to_str(role))
-            ->get_data_map();
-    for (const auto &entry : data_map)
+    auto it = entry.task.sub_tasks.begin();
+    while (it != entry.task.sub_tasks.end())
     {
-      if (entry.first != DataType::OUTPUT)
+      DataDispatchInfo &selected_task = *it;
+      // 计算此数据类型对应的VC ID
+      int vc_id = get_vc_id_for_packet_by_task(selected_task);
+
+      // 检查对应的VC队列是否为空（实现"size只为1"的规则）
+      if (vc_blocked[vc_id] || !packet_queues_[vc_id].empty())
       {
-        if (!unified_buffer_manager_->AreDataTypeReady(entry.first,
-                                                       entry.second))
-          return;
+        vc_blocked[vc_id] = true;
+        ++it;
+        continue; // 该VC通道忙，跳过
+      }
+
+      LOG << "PE[" << local_id << "] Generating packet for task: "
+          << "Type=" << DataType_to_str(selected_task.type)
+          << ", Size=" << selected_task.size
+          << ", Timestep=" << entry.timestep << endl;
+
+      Packet pkt;
+      pkt.src_id = local_id;
+      pkt.dst_id = -2;
+      pkt.target_role = selected_task.target_role;
+
+      // 计算实际的目标数量
+      int target_count = calculate_target_count(
+          level_index, selected_task.type, selected_task.target_role);
+
+      pkt.vc_id = vc_id; // 使用预先计算的VC ID
+      pkt.logical_timestamp = entry.timestep;
+      pkt.data_type = selected_task.type;
+
+      // 打包：同一时间步中目标相同、路由相同且自身VC空闲的子任务合入本包，
+      // 按数据类型记入 payload_sizes，省去各自的 HEAD/TAIL 和仲裁
+      int payload = selected_task.size;
+      if (GlobalParams::pack_subtasks)
+      {
+        int payload_sizes[3] = {0, 0, 0};
+        payload_sizes[static_cast<int>(selected_task.type)] =
+            selected_task.size;
+        int packed = 0;
+        auto other = std::next(it);
+        while (other != entry.task.sub_tasks.end())
+        {
+          int other_vc = get_vc_id_for_packet_by_task(*other);
+          if (other->target_role != selected_task.target_role ||
+              vc_blocked[other_vc] ||
+              (other_vc != vc_id && !packet_queues_[other_vc].empty()) ||
+              !same_route(selected_task.type, other->type,
+                          selected_task.target_role))
+          {
+            ++other;
+            continue;
+          }
+          payload_sizes[static_cast<int>(other->type)] += other->size;
+          payload += other->size;
+          // 后面时间步的同VC子任务不能越过本包
+          vc_blocked[other_vc] = true;
+          packed++;
+          other = entry.task.sub_tasks.erase(other);
+        }
+        if (packed > 0)
+        {
+          std::copy(std::begin(payload_sizes), std::end(payload_sizes),
+                    pkt.payload_sizes);
+          packed_subtasks_ += packed;
+        }
+      }
+      pkt.payload_data_size = payload;
+
+      // flit 数只取决于载荷的物理大小，各层带宽由链路宽度体现
+      if (target_count > 1)
+      {
+        // Transmission mode switching logic for packet size calculation
+        if (GlobalParams::transmission_mode == "traditional")
+        {
+          // 获取目标层带宽
+          int target_bandwidth =
+              get_target_bandwidth(level_index, selected_task.target_role);
+          // 获取当前层带宽
+          int current_level_bandwidth =
+              GlobalParams::hierarchical_config.get_level_config(level_index)
+                  .bandwidth;
+          // 获取当前层的 bank_count
+          int bank_count =
+              GlobalParams::hierarchical_config.get_level_config(level_index)
+                  .bank_count;
+
+          // 计算并行度：受限于带宽比和 bank 数量
+          int bandwidth_ratio = current_level_bandwidth / target_bandwidth;
+          int parallel_degree =
+              std::max(1, std::min(bandwidth_ratio, bank_count));
+
+          // Traditional mode: 每个目标一份拷贝串行发送。当前层的宽链路
+          // 一周期可以承载 bandwidth_ratio 个目标的数据，bank 数不足时按比例放大
+          int total_flits = target_count * payload_flits(payload);
+          total_flits = (total_flits * std::max(1, bandwidth_ratio) +
+                         parallel_degree - 1) /
+                        parallel_degree;
+          pkt.size = pkt.flit_left = 2 + total_flits;
+        }
+        else
+        {
+          // Optimized mode: 一个 packet 携带所有目标的数据，
+          // 超出链路宽度的部分由链路串行传输
+          pkt.size = pkt.flit_left =
+              payload_flits(target_count * payload) + 2;
+        }
       }
       else
       {
-        if (!unified_buffer_manager_->AreDataTypeReady(entry.first,
-                                                       entry.second))
-          return;
+        // 单目标场景
+        pkt.size = pkt.flit_left = payload_flits(payload) + 2;
       }
+      pkt.command = entry.command;
+
+      // 将Packet推入对应的VC队列
+      packet_queues_[vc_id].push(pkt);
+      if (InjectionTrace::recording())
+        record_injection(pkt);
+      entry.queued_packets++;
+      dispatched_packets_++;
+      if (entry.timestep != logical_timestamp)
+        prefetched_packets_++;
+      it = entry.task.sub_tasks.erase(it);
     }
+  }
+}
 
-    current_dispatch_task_ =
-        task_manager_->get_task_for_timestep(logical_timestamp);
-    LOG << "PE[" << local_id << "] Starting dispatch for timestep "
-        << logical_timestamp << " with "
-        << current_dispatch_task_.sub_tasks.size() << " subtasks." << endl;
-    command_to_send = get_command_to_send();
+// 开始分发时间步 timestep。每个时间步 (包括向前预取的) 都要求本层数据已经
+// 就绪，否则会把尚未从上一层到达的数据发给下一层；向前预取时不能越过尚未
+// 完成的同步点，且预取的数据量受目标层缓冲区的剩余容量限制
+bool ProcessingElement::open_dispatch_timestep(int timestep)
+{
+  if (static_cast<size_t>(timestep) >= task_manager_->get_total_timesteps())
+  {
+    return false;
+  }
+
+  if (!holds_working_set())
+  {
+    return false;
+  }
+
+  if (!dispatch_window_.empty())
+  {
+    // 同步点之后的数据要等同步点的输出全部返回后再发
+    for (const DispatchWindowEntry &entry : dispatch_window_)
+    {
+      if (task_manager_->is_in_sync_points(entry.timestep))
+        return false;
+    }
+  }
+
+  DispatchWindowEntry entry;
+  entry.timestep = timestep;
+  entry.task = task_manager_->get_task_for_timestep(timestep);
+  entry.queued_packets = 0;
+  std::fill(std::begin(entry.bytes), std::end(entry.bytes), 0);
+  for (const DataDispatchInfo &sub_task : entry.task.sub_tasks)
+    entry.bytes[static_cast<int>(sub_task.type)] += sub_task.size;
 
+  if (!dispatch_window_.empty() && !prefetch_fits(entry))
+  {
+    return false;
+  }
+  entry.command = get_command_to_send(timestep);
+
+  LOG << "PE[" << local_id << "] Starting dispatch for timestep " << timestep
+      << " with " << entry.task.sub_tasks.size() << " subtasks." << endl;
+
+  // 本时间步访问的 tile：不在缓冲区中的需要从上一层重新取回
+  if (unified_buffer_manager_->IsTileTrackingEnabled())
+  {
+    for (const TileRef &ref : task_manager_->get_tile_refs(timestep))
+      unified_buffer_manager_->ReferenceTile(ref.tile, ref.size, timestep);
+  }
+
+  if (dispatch_window_.empty())
+  {
+    unified_buffer_manager_->AcquireBank();
     dispatch_in_progress_ = true;
   }
+  dispatch_window_.push_back(entry);
+  return true;
+}
 
-  if (current_dispatch_task_.sub_tasks.empty())
+// 本角色工作集中的每种数据是否都已在缓冲区中
+bool ProcessingElement::holds_working_set() const
+{
+  const RoleWorkingSet *working_set =
+      task_manager_->get_working_set_for_role(roleToString(role));
+  if (working_set == nullptr)
+    return true;
+  for (const auto &entry : working_set->get_data_map())
   {
-    return;
+    if (!unified_buffer_manager_->AreDataTypeReady(entry.first, entry.second))
+      return false;
   }
+  return true;
+}
 
-  // --- 1. [核心] 从待办列表中随机选择一个子任务 ---
-  int num_pending_subtasks = current_dispatch_task_.sub_tasks.size();
-  auto it = current_dispatch_task_.sub_tasks.begin();
+// window 中已预取的时间步加上 candidate 的数据量不能超过目标层每个节点的
+// 缓冲区中除去常驻数据后的容量。共享模式的目标 (GLB 等) 比较所有类型的合计
+bool ProcessingElement::prefetch_fits(
+    const DispatchWindowEntry &candidate) const
+{
+  size_t ahead[NUM_DATA_TYPES];
+  std::copy(std::begin(candidate.bytes), std::end(candidate.bytes), ahead);
+  for (size_t k = 1; k < dispatch_window_.size(); k++)
+  {
+    for (int i = 0; i < NUM_DATA_TYPES; i++)
+      ahead[i] += dispatch_window_[k].bytes[i];
+  }
 
-  while (it != current_dispatch_task_.sub_tasks.end())
+  // 按目标角色分别检查：BUFFER 每种类型独立容量，其余 (GLB 等) 所有类型
+  // 共用一个容量
+  bool checked[ROLE_DISTRIBUTOR + 1] = {};
+  for (const DataDispatchInfo &sub_task : candidate.task.sub_tasks)
   {
-    DataDispatchInfo &selected_task = *it;
-    // 计算此数据类型对应的VC ID
-    int vc_id = get_vc_id_for_packet_by_task(selected_task);
+    PE_Role target = sub_task.target_role;
+    if (checked[target])
+      continue;
+    checked[target] = true;
 
-    // 检查对应的VC队列是否为空（实现"size只为1"的规则）
-    if (!packet_queues_[vc_id].empty())
+    size_t capacity[NUM_DATA_TYPES];
+    size_t resident[NUM_DATA_TYPES];
+    size_t target_ahead[NUM_DATA_TYPES] = {};
+    for (int i = 0; i < NUM_DATA_TYPES; i++)
     {
-      ++it;
-      continue; // 该VC通道忙，跳过
+      DataType type = static_cast<DataType>(i);
+      capacity[i] = get_target_capacity(type, target);
+      resident[i] = get_target_resident(type, target);
     }
-
-    LOG << "PE[" << local_id << "] Generating packet for task: "
-        << "Type=" << DataType_to_str(selected_task.type)
-        << ", Size=" << selected_task.size << endl;
-
-    Packet pkt;
-    pkt.src_id = local_id;
-    pkt.dst_id = -2;
-    pkt.target_role = selected_task.target_role;
-
-    // 计算实际的目标数量
-    int target_count = calculate_target_count(level_index, selected_task.type,
-                                              selected_task.target_role);
-
-    int bandwidth_scale =
-        GlobalParams::hierarchical_config.get_level_config(level_index)
-            .bandwidth /
-        GlobalParams::word_bits;
-    pkt.vc_id = vc_id; // 使用预先计算的VC ID
-    pkt.payload_data_size = selected_task.size;
-    pkt.logical_timestamp = logical_timestamp;
-    pkt.data_type = selected_task.type;
-
-    if (target_count > 1)
+    for (const DataDispatchInfo &other : candidate.task.sub_tasks)
     {
-      // 多目标场景：使用当前层实际带宽
-      int current_bandwidth =
-          GlobalParams::hierarchical_config.get_level_config(level_index)
-              .bandwidth;
-
-      // Transmission mode switching logic for packet size calculation
-      if (GlobalParams::transmission_mode == "traditional")
+      if (other.target_role == target)
       {
-        // 获取目标层带宽
-        int target_bandwidth =
-            get_target_bandwidth(level_index, selected_task.target_role);
-        // 获取当前层带宽
-        int current_level_bandwidth =
-            GlobalParams::hierarchical_config.get_level_config(level_index)
-                .bandwidth;
-        // 获取当前层的 bank_count
-        int bank_count =
-            GlobalParams::hierarchical_config.get_level_config(level_index)
-                .bank_count;
-
-        // 计算并行度：受限于带宽比和 bank 数量
-        int bandwidth_ratio = current_level_bandwidth / target_bandwidth;
-        int parallel_degree =
-            std::max(1, std::min(bandwidth_ratio, bank_count));
-
-        // Traditional mode: 基于并行度调整 flit 数
-        int bandwidth_scale = target_bandwidth / GlobalParams::word_bits;
-        int single_packet_size =
-            (selected_task.size + bandwidth_scale - 1) / bandwidth_scale;
-        int total_flits = target_count * single_packet_size;
-        pkt.size = pkt.flit_left =
-            2 + (total_flits + parallel_degree - 1) / parallel_degree;
+        int i = static_cast<int>(other.type);
+        target_ahead[i] = ahead[i];
       }
-      else
-      {
-        // Optimized mode: hierarchical slicing based on bandwidth overflow
+    }
 
-        // 步骤A：计算单层切片是否溢出
-        double R = (double)(target_count * 8) / current_bandwidth;
+    BufferMode mode = target == ROLE_BUFFER ? BufferMode::INDEPENDENT
+                                            : BufferMode::SHARED;
+    if (!PrefetchFits(mode, capacity, resident, target_ahead))
+      return false;
+  }
+  return true;
+}
 
-        // 步骤B：确定单层Flit数（向上取整）
-        int Nslice;
-        if (R <= 1.0)
-        {
-          Nslice = 1;
-        }
-        else
-        {
-          Nslice = (int)ceil(R);
-        }
+// 目标节点处理当前时间步时缓冲区中常驻的数据量 (目标角色的工作集)。
+// 目标层双缓冲时预取的数据写入另一个 bank，不与常驻数据争用容量
+size_t ProcessingElement::get_target_resident(DataType type,
+                                              PE_Role target_role) const
+{
+  for (int level = level_index + 1; level < GlobalParams::num_levels; level++)
+  {
+    const LevelConfig &level_config =
+        GlobalParams::hierarchical_config.get_level_config(level);
+    if (level_config.roles != target_role)
+      continue;
+    if (level_config.double_buffer)
+      return 0;
+    break;
+  }
 
-        // 步骤C：计算总长度
-        pkt.size = pkt.flit_left = Nslice * selected_task.size + 2;
-      }
+  const RoleWorkingSet *working_set =
+      task_manager_->get_working_set_for_role(roleToString(target_role));
+  if (working_set == nullptr)
+    return 0;
+  std::map<DataType, size_t> data_map = working_set->get_data_map();
+  auto it = data_map.find(type);
+  return it != data_map.end() ? it->second : 0;
+}
+
+// 目标角色所在层每个节点为 type 提供的缓冲区容量 (与 configure 中的划分一致)
+size_t ProcessingElement::get_target_capacity(DataType type,
+                                              PE_Role target_role) const
+{
+  for (int level = level_index + 1; level < GlobalParams::num_levels; level++)
+  {
+    const LevelConfig &level_config =
+        GlobalParams::hierarchical_config.get_level_config(level);
+    if (level_config.roles != target_role)
+      continue;
+    if (target_role != ROLE_BUFFER)
+      return level_config.buffer_size[0];
+    switch (type)
+    {
+    case DataType::WEIGHT:
+      return level_config.buffer_size[0];
+    case DataType::INPUT:
+      return level_config.buffer_size[1];
+    case DataType::OUTPUT:
+      return level_config.buffer_size[2];
+    default:
+      return 0;
     }
-    else
+  }
+  return std::numeric_limits<size_t>::max();
+}
+
+// 从 level_index 到目标角色所在层，两种数据类型的路由模式是否完全相同
+// (都没有配置或 port_groups/forward_count 相同)，相同时可以共用一个包
+bool ProcessingElement::same_route(DataType a, DataType b,
+                                   PE_Role target_role) const
+{
+  if (a == b)
+    return true;
+  for (int level = level_index; level < GlobalParams::num_levels; level++)
+  {
+    const LevelConfig &level_config =
+        GlobalParams::hierarchical_config.get_level_config(level);
+    if (level_config.roles == target_role)
+      break;
+    if (!level_config.has_routing_patterns)
+      continue;
+    auto it_a = level_config.routing_patterns.find(a);
+    auto it_b = level_config.routing_patterns.find(b);
+    bool has_a = it_a != level_config.routing_patterns.end();
+    bool has_b = it_b != level_config.routing_patterns.end();
+    if (has_a != has_b)
+      return false;
+    if (has_a && (it_a->second.port_groups != it_b->second.port_groups ||
+                  it_a->second.forward_count != it_b->second.forward_count))
+      return false;
+  }
+  return true;
+}
+
+// 多载荷包按 payload_sizes (DataType 下标) 拆分，普通包只有 data_type 一个载荷
+int ProcessingElement::split_payloads(const int payload_sizes[3],
+                                      DataType data_type,
+                                      int payload_data_size, DataType types[3],
+                                      size_t sizes[3])
+{
+  int n = 0;
+  for (int i = 0; i < 3; i++)
+  {
+    if (payload_sizes[i] > 0)
     {
-      // 单目标场景：保持原有计算
-      pkt.size = pkt.flit_left =
-          (selected_task.size + bandwidth_scale - 1) / bandwidth_scale + 2;
+      types[n] = static_cast<DataType>(i);
+      sizes[n++] = payload_sizes[i];
     }
-    pkt.command = command_to_send;
+  }
+  if (n == 0)
+  {
+    types[0] = data_type;
+    sizes[0] = payload_data_size;
+    n = 1;
+  }
+  return n;
+}
 
-    // 将Packet推入对应的VC队列
-    packet_queues_[vc_id].push(pkt);
-    it = current_dispatch_task_.sub_tasks.erase(it);
+// 包的最后一个 flit 发出 (或被直接投递) 时更新所属时间步的在途计数
+void ProcessingElement::on_packet_dequeued(const Packet &pkt)
+{
+  if (pkt.command == -1)
+  {
+    queued_return_packets_--;
+    return;
+  }
+  for (DispatchWindowEntry &entry : dispatch_window_)
+  {
+    if (entry.timestep == pkt.logical_timestamp)
+    {
+      entry.queued_packets--;
+      return;
+    }
   }
 }
 
-int ProcessingElement::get_command_to_send() // tofix
+int ProcessingElement::get_command_to_send(int timestep) // tofix
                                              // 当完整模拟时需要通过获取子
 {
   PE_Role nextRole = static_cast<PE_Role>(static_cast<int>(role) + 1);
@@ -1295,7 +1566,7 @@ int ProcessingElement::get_command_to_send() // tofix
     return -2; // 返回无效命令
   }
 
-  if (logical_timestamp + 1 >= task_manager_->get_total_timesteps())
+  if (timestep + 1 >= task_manager_->get_total_timesteps())
   {
     return commands->size() + 1;
   }
@@ -1308,7 +1579,7 @@ int ProcessingElement::get_command_to_send() // tofix
   // }
   DataDelta next_delta;
   DispatchTask next_task = task_manager_->get_task_for_timestep(
-      (logical_timestamp + 1) % task_manager_->get_total_timesteps());
+      (timestep + 1) % task_manager_->get_total_timesteps());
   // 这条命令需要在负载下被测试
 
   for (const DataDispatchInfo &sub_task : next_task.sub_tasks)
@@ -1355,15 +1626,19 @@ Flit ProcessingElement::generate_next_flit_from_queue(
   flit.hub_relay_node = NOT_VALID;
   flit.data_type = packet.data_type;
   flit.command = packet.command;
+  // 多载荷包的各载荷大小，接收方在 HEAD 预留、在 TAIL 提交
+  std::copy(std::begin(packet.payload_sizes), std::end(packet.payload_sizes),
+            flit.payload_sizes);
 
   flit.target_role = packet.target_role;
+  flit.packet_id = packet.packet_id;
 
   // 确定flit类型
   if (packet.size == packet.flit_left)
   {
+    queue.front().packet_id = packet.packet_id = next_packet_id_++;
+    flit.packet_id = packet.packet_id;
     flit.flit_type = FLIT_TYPE_HEAD;
-    std::copy(std::begin(packet.payload_sizes), std::end(packet.payload_sizes),
-              flit.payload_sizes);
   }
   else if (packet.flit_left == 1)
   {
@@ -1378,12 +1653,32 @@ Flit ProcessingElement::generate_next_flit_from_queue(
   queue.front().flit_left--;
   if (queue.front().flit_left == 0)
   {
+    on_packet_dequeued(queue.front());
     queue.pop();
   }
 
   return flit;
 }
 
+void ProcessingElement::record_injection(const Packet &pkt)
+{
+  InjectionTraceRecord r;
+  r.cycle = sc_time_stamp().to_double() / GlobalParams::clock_period_ps -
+            GlobalParams::reset_time;
+  r.src_id = local_id;
+  r.size = pkt.size;
+  r.payload_data_size = pkt.payload_data_size;
+  r.command = pkt.command;
+  r.logical_timestamp = pkt.logical_timestamp;
+  for (int k = 0; k < 3; k++)
+    r.payload_sizes[k] = pkt.payload_sizes[k];
+  r.target_role = static_cast<int8_t>(pkt.target_role);
+  r.data_type = static_cast<int8_t>(pkt.data_type);
+  r.vc_id = static_cast<int8_t>(pkt.vc_id);
+  r.reserved = 0;
+  InjectionTrace::record(r);
+}
+
 unsigned int ProcessingElement::getQueueSize() const
 {
   return packet_queues_.size();
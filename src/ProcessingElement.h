@@ -11,6 +11,7 @@
 #ifndef __NOXIMPROCESSINGELEMENT_H__
 #define __NOXIMPROCESSINGELEMENT_H__
 
+#include <deque>
 #include <map>
 #include <queue>
 #include <systemc.h>
@@ -20,15 +21,15 @@
 #include "DataStructs.h"
 #include "GlobalParams.h"
 #include "GlobalTrafficTable.h"
+#include "LinkChannel.h"
+#include "Rng.h"
 #include "Utils.h"
+#include "VcArbiter.h"
 #include "dbg.h"
 #include "smartbuffer/BufferManager.h"
 #include "taskmanager/TaskManager.h"
 #include <memory>
 
-// Hierarchical topology configuration structures
-#define NUM_LOCAL_PORTS 1
-
 using namespace std;
 
 SC_MODULE(ProcessingElement) {
@@ -41,36 +42,24 @@ SC_MODULE(ProcessingElement) {
   sc_in<bool> reset; // The reset signal for the PE
 
   // Primary and Secondary connections as arrays
-  sc_in<Flit>
-      flit_rx[NUM_LOCAL_PORTS]; // The input channels [0: PRIMARY, 1: SECONDARY]
-  sc_in<bool> req_rx[NUM_LOCAL_PORTS];  // The request signals associated with
-                                        // input channels
-  sc_out<bool> ack_rx[NUM_LOCAL_PORTS]; // The outgoing ack signals associated
-                                        // with input channels
-  sc_out<TBufferFullStatus> buffer_full_status_rx[NUM_LOCAL_PORTS];
-
-  sc_out<Flit> flit_tx[NUM_LOCAL_PORTS]; // The output channels [0: PRIMARY, 1:
-                                         // SECONDARY]
-  sc_out<bool> req_tx[NUM_LOCAL_PORTS];  // The request signals associated with
-                                         // output channels
-  sc_in<bool> ack_tx[NUM_LOCAL_PORTS];   // The incoming ack signals associated
-                                         // with output channels
-  sc_in<TBufferFullStatus> buffer_full_status_tx[NUM_LOCAL_PORTS];
+  // 与 Router LOCAL 端口之间的链路 (每个方向一个 LinkChannel)。
+  // 只有本层把数据类型映射到 SECONDARY 时才绑定第二个端口
+  sc_port<LinkRxIf, 1, SC_ZERO_OR_MORE_BOUND>
+      link_rx[NUM_LOCAL_PORTS]; // [0: PRIMARY, 1: SECONDARY]
+  sc_port<LinkTxIf, 1, SC_ZERO_OR_MORE_BOUND> link_tx[NUM_LOCAL_PORTS];
+  int num_local_ports_;               // 本层使用的 LOCAL 端口数
+  int local_port_[NUM_DATA_TYPES];    // 数据类型 -> LOCAL 端口
 
   // Registers
-  int local_id;                           // Unique identification number
-  bool current_level_rx[NUM_LOCAL_PORTS]; // Current level for Alternating Bit
-                                          // Protocol (ABP)
-  bool current_level_tx[NUM_LOCAL_PORTS]; // Current level for Alternating Bit
-                                          // Protocol (ABP)
+  int local_id; // Unique identification number
   std::vector<std::queue<Packet>> packet_queues_; // VC-aware packet queues
   bool transmittedAtPreviousCycle; // Used for distributions with memory
 
-  BufferBank rx_buffer; // 物理输入缓冲区
+  BufferBank rx_buffer[NUM_LOCAL_PORTS]; // 物理输入缓冲区 (每个 LOCAL 端口一组)
 
   // [新增] 用于跟踪正在接收、但未完全提交到逻辑缓冲区的数据的总大小
-  size_t main_receiving_size_;
-  size_t output_receiving_size_;
+  // 按数据类型记录，多载荷包的每个载荷只占用自己类型的预留
+  size_t receiving_size_[NUM_DATA_TYPES];
 
   // Functions
   void rxProcess(); // The receiving process
@@ -97,6 +86,7 @@ SC_MODULE(ProcessingElement) {
   // Utility functions - only keeping used ones
   int randInt(int min,
               int max); // Extracts a random integer number between min and max
+  RngStream rng;        // 本 PE 独立的随机数流 (configure 中按 id 生成)
 
   // Unused utility functions removed
   // void fixRanges(const Coord, Coord &);
@@ -122,8 +112,23 @@ public:
   // 移除: std::unique_ptr<BufferManager> buffer_manager_
   // 移除: std::unique_ptr<BufferManager> output_buffer_manager_
 
-  std::unique_ptr<TaskManager> task_manager_; // 任务管理器实例
-  DispatchTask current_dispatch_task_;        // 当前任务
+  std::shared_ptr<TaskManager> task_manager_; // 同角色 PE 共享的任务管理器
+
+  // 已开始分发、尚未完成的时间步，front 为 logical_timestamp。
+  // prefetch_depth > 0 时最多向前打开 prefetch_depth 个时间步。
+  struct DispatchWindowEntry {
+    int timestep;
+    DispatchTask task;  // 尚未入队的子任务
+    int command;        // 随本时间步数据下发的命令
+    int queued_packets; // 已入队、尚未发完的包
+    size_t bytes[NUM_DATA_TYPES]; // 本时间步下发的数据量 (按数据类型)
+  };
+  std::deque<DispatchWindowEntry> dispatch_window_;
+  int prefetch_depth_;
+  int queued_return_packets_;  // 已入队、尚未发完的回送包
+  size_t dispatched_packets_;  // 分发的包数
+  size_t prefetched_packets_;  // 其中在前面的时间步完成之前入队的包数
+  size_t packed_subtasks_;     // 合入其他子任务的包中发送的子任务数
   size_t outputs_received_count_;
   size_t outputs_required_count_;
 
@@ -193,7 +198,6 @@ public: // 建议将内部状态变量设为私有
   // +++ 新增：一个专门用于通知缓冲区状态改变的事件 +++
   sc_event buffer_state_changed_event;
   sc_event output_buffer_state_changed_event; // 新增：output buffer状态改变事件
-  int command_to_send;
   std::map<int, int> pending_commands_;
   bool compute_in_progress_;
   bool is_compute_complete;
@@ -206,7 +210,8 @@ public: // 建议将内部状态变量设为私有
   std::unordered_map<DataType, size_t> data_wait_stats_;
   size_t total_wait_cycles_ = 0;
 
-  int last_serviced_vc_; // 上一个服务的虚拟通道ID
+  VcArbiter vc_arbiter_;             // 发送时 VC 的服务顺序 (vc_arbitration)
+  int vc_of_type_[NUM_DATA_TYPES];   // 数据类型 -> VC (vc_map)
   int current_cycle = 0;
   // 这并不是一个优雅的实现 但是我们必须这么做。。。
 
@@ -220,14 +225,28 @@ public: // 建议将内部状态变量设为私有
   void run_storage_logic();
   void run_compute_logic();
 
-  int get_command_to_send();
+  int get_command_to_send(int timestep);
+
+  // 多时间步预取
+  bool open_dispatch_timestep(int timestep);
+  bool holds_working_set() const;
+  bool prefetch_fits(const DispatchWindowEntry &candidate) const;
+  size_t get_target_capacity(DataType type, PE_Role target_role) const;
+  size_t get_target_resident(DataType type, PE_Role target_role) const;
+  void on_packet_dequeued(const Packet &pkt);
+
+  // 子任务打包 (-pack_subtasks)
+  bool same_route(DataType a, DataType b, PE_Role target_role) const;
+  static int split_payloads(const int payload_sizes[3], DataType data_type,
+                            int payload_data_size, DataType types[3],
+                            size_t sizes[3]);
 
   void reset_logic(); // 达到timestamp上限时的重置行为
 
   void internal_transfer_process();
 
-  // 新增：统一的VC发送处理函数
-  void handle_tx_for_all_vcs();
+  // 新增：统一的VC发送处理函数，发送了一个 flit 时返回 true
+  bool handle_tx_for_all_vcs();
 
   // 新增：辅助函数
   bool packet_queues_are_empty() const;
@@ -239,6 +258,8 @@ public: // 建议将内部状态变量设为私有
 
   int find_child_id(int id);
   Flit generate_next_flit_from_queue(std::queue<Packet> & queue);
+  void record_injection(const Packet &pkt); // 写入注入 trace (-record_injections)
+  static unsigned int next_packet_id_; // 全局包编号计数器
 
   unsigned int getQueueSize() const;
 
@@ -246,12 +267,31 @@ public: // 建议将内部状态变量设为私有
   int calculate_target_count(int current_level, DataType data_type,
                              PE_Role target_role);
   int get_target_bandwidth(int current_level, PE_Role target_role);
+  // words 个字的载荷需要的 flit 数 (flit 为 GlobalParams::flit_size 位)
+  int payload_flits(int words) const;
 
   // 获取PE数据等待统计数据的接口
   const std::unordered_map<DataType, size_t> &getDataWaitStats() const {
     return data_wait_stats_;
   }
   size_t getTotalWaitCycles() const { return total_wait_cycles_; }
+  size_t getDispatchedPackets() const { return dispatched_packets_; }
+  size_t getPrefetchedPackets() const { return prefetched_packets_; }
+  size_t getPackedSubtasks() const { return packed_subtasks_; }
+  // 驻留 tile 统计 (存储层启用 tile 跟踪时有效，否则为 nullptr)
+  const TileStats *getTileStats() const {
+    return unified_buffer_manager_ &&
+                   unified_buffer_manager_->IsTileTrackingEnabled()
+               ? &unified_buffer_manager_->GetTileStats()
+               : nullptr;
+  }
+  // 双缓冲统计 (本层启用 double_buffer 时有效，否则为 nullptr)
+  const BankStats *getBankStats() const {
+    return unified_buffer_manager_ &&
+                   unified_buffer_manager_->IsDoubleBuffered()
+               ? &unified_buffer_manager_->GetBankStats()
+               : nullptr;
+  }
   // 新增：动态配置函数
   void configure(int id, int level_idx,
                  const HierarchicalConfig &topology_config);
@@ -259,8 +299,16 @@ public: // 建议将内部状态变量设为私有
 
   SC_CTOR(ProcessingElement) {
     // 初始化新的成员变量
-    main_receiving_size_ = 0;
-    output_receiving_size_ = 0;
+    std::fill(std::begin(receiving_size_), std::end(receiving_size_), 0);
+    unified_buffer_manager_ = nullptr;
+    prefetch_depth_ = 0;
+    queued_return_packets_ = 0;
+    dispatched_packets_ = 0;
+    prefetched_packets_ = 0;
+    packed_subtasks_ = 0;
+    num_local_ports_ = 1;
+    std::fill(local_port_, local_port_ + NUM_DATA_TYPES, 0);
+    std::fill(vc_of_type_, vc_of_type_ + NUM_DATA_TYPES, 0);
 
     // 初始化VC队列
     packet_queues_.resize(GlobalParams::n_virtual_channels);
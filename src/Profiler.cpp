@@ -0,0 +1,59 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the simulator self-profiler
+ */
+
+#include "Profiler.h"
+
+bool Profiler::enabled_ = false;
+int Profiler::num_levels_ = 1;
+std::vector<Profiler::Counter> Profiler::counters_(PROF_NUM_REGIONS);
+uint64_t Profiler::phase_start_[PROF_NUM_PHASES] = {0};
+uint64_t Profiler::phase_ns_[PROF_NUM_PHASES] = {0};
+double Profiler::simulated_cycles_ = 0;
+
+static const char *region_names[PROF_NUM_REGIONS] = {
+    "Router::rxProcess", "Router::txProcess", "Power (perCycleUpdate)",
+    "PE::rxProcess", "PE::txProcess"};
+
+static const char *phase_names[PROF_NUM_PHASES] = {
+    "configuration", "elaboration", "reset", "simulation"};
+
+void Profiler::enable(int num_levels) {
+  enabled_ = true;
+  num_levels_ = num_levels > 0 ? num_levels : 1;
+  counters_.assign(PROF_NUM_REGIONS * num_levels_, Counter());
+}
+
+void Profiler::report(std::ostream &out) {
+  if (!enabled_)
+    return;
+
+  double sim_s = phase_ns_[PHASE_SIMULATION] * 1e-9;
+  out << "% Profiler:" << std::endl;
+  for (int p = 0; p < PROF_NUM_PHASES; p++)
+    out << "%   " << phase_names[p] << " time (s): "
+        << phase_ns_[p] * 1e-9 << std::endl;
+  out << "%   Simulated cycles: " << simulated_cycles_ << std::endl;
+  out << "%   Cycles per wall-second: "
+      << (sim_s > 0 ? simulated_cycles_ / sim_s : 0.0) << std::endl;
+
+  // 各进程在主仿真阶段中所占的比例
+  for (int r = 0; r < PROF_NUM_REGIONS; r++) {
+    for (int l = 0; l < num_levels_; l++) {
+      const Counter &c = counters_[r * num_levels_ + l];
+      if (c.calls == 0)
+        continue;
+      double s = c.ns * 1e-9;
+      out << "%   " << region_names[r] << " level " << l << ": calls "
+          << c.calls << ", time (s) " << s << ", avg (ns) "
+          << (double)c.ns / c.calls << ", share "
+          << (sim_s > 0 ? 100.0 * s / sim_s : 0.0) << "%" << std::endl;
+    }
+  }
+}
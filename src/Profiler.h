@@ -0,0 +1,107 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the simulator self-profiler.
+ * It measures the wall time spent in the simulation phases and in the
+ * Router / ProcessingElement / Power processes (per hierarchy level), and
+ * reports simulated cycles per wall-second at the end of the stats.
+ */
+
+#ifndef __NOXIMPROFILER_H__
+#define __NOXIMPROFILER_H__
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+enum ProfileRegion {
+  PROF_ROUTER_RX = 0,
+  PROF_ROUTER_TX,
+  PROF_POWER, // Router::perCycleUpdate (空闲统计 + 泄漏周期计数)
+  PROF_PE_RX,
+  PROF_PE_TX,
+  PROF_NUM_REGIONS
+};
+
+enum ProfilePhase {
+  PHASE_CONFIGURATION = 0, // 命令行 + YAML 解析
+  PHASE_ELABORATION,       // 拓扑构建，NoC / Tile / Router / PE 实例化与绑定
+  PHASE_RESET,             // 复位阶段的 sc_start
+  PHASE_SIMULATION,        // 主 sc_start
+  PROF_NUM_PHASES
+};
+
+class Profiler {
+public:
+  // 由 configure() 在解析完 -profile / profile 后调用
+  static void enable(int num_levels);
+  static bool enabled() { return enabled_; }
+
+  static uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  static void add(ProfileRegion region, int level, uint64_t ns) {
+    if (level < 0 || level >= num_levels_)
+      level = num_levels_ - 1;
+    Counter &c = counters_[region * num_levels_ + level];
+    c.calls++;
+    c.ns += ns;
+  }
+
+  // 阶段计时始终进行 (开销可以忽略)，只在开启时输出；elaboration 时间
+  // 另外始终列在统计摘要中
+  static void beginPhase(ProfilePhase phase) { phase_start_[phase] = now(); }
+  static void endPhase(ProfilePhase phase) {
+    phase_ns_[phase] += now() - phase_start_[phase];
+  }
+
+  static double phaseSeconds(ProfilePhase phase) {
+    return phase_ns_[phase] * 1e-9;
+  }
+
+  static void setSimulatedCycles(double cycles) { simulated_cycles_ = cycles; }
+
+  static void report(std::ostream &out);
+
+private:
+  struct Counter {
+    unsigned long calls = 0;
+    uint64_t ns = 0;
+  };
+
+  static bool enabled_;
+  static int num_levels_;
+  static std::vector<Counter> counters_; // [region][level]
+  static uint64_t phase_start_[PROF_NUM_PHASES];
+  static uint64_t phase_ns_[PROF_NUM_PHASES];
+  static double simulated_cycles_;
+};
+
+// 作用域计时：未开启时只有一次布尔判断
+class ProfileScope {
+public:
+  ProfileScope(ProfileRegion region, int level)
+      : region_(region), level_(level),
+        start_(Profiler::enabled() ? Profiler::now() : 0) {}
+  ~ProfileScope() {
+    if (start_)
+      Profiler::add(region_, level_, Profiler::now() - start_);
+  }
+
+private:
+  ProfileRegion region_;
+  int level_;
+  uint64_t start_;
+};
+
+#define PROFILE_SCOPE(region, level) ProfileScope profile_scope_(region, level)
+
+#endif
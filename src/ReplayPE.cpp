@@ -0,0 +1,219 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the replay processing element
+ */
+
+#include "ReplayPE.h"
+
+#include "FlitTrace.h"
+#include "Log.h"
+#include "Profiler.h"
+
+int ReplayPE::active_sources_ = 0;
+double ReplayPE::last_activity_cycle_ = 0;
+unsigned long ReplayPE::total_injected_flits_ = 0;
+unsigned long ReplayPE::total_ejected_flits_ = 0;
+
+void ReplayPE::configure(int id)
+{
+  local_id = id;
+  int level = GlobalParams::node_level_map[id];
+  if (level < (int)GlobalParams::hierarchical_config.levels.size())
+  {
+    const LevelConfig &level_config =
+        GlobalParams::hierarchical_config.get_level_config(level);
+    num_local_ports_ = level_config.num_local_ports;
+    std::copy(level_config.local_port, level_config.local_port + NUM_DATA_TYPES,
+              local_port_);
+    // VC 由 trace 记录给出，只有 VC 之间的仲裁按本层配置
+    vc_arbiter_.configure(level_config.vc_arbitration, level_config.vc_weights,
+                          GlobalParams::n_virtual_channels);
+  }
+  else
+  {
+    vc_arbiter_.configure(VC_ARB_ROUND_ROBIN, std::vector<int>(),
+                          GlobalParams::n_virtual_channels);
+  }
+  exhausted_ = InjectionTrace::recordsOf(local_id) == 0;
+  if (!exhausted_)
+    active_sources_++;
+}
+
+void ReplayPE::rxProcess()
+{
+  PROFILE_SCOPE(PROF_PE_RX, GlobalParams::node_level_map[local_id]);
+  if (reset.read())
+    return; // LOCAL 链路由发送方 (Router) 复位
+
+  // 回放模式下 PE 是理想的 sink，永远不反压 (满掩码保持为 0)
+  for (int i = 0; i < num_local_ports_; ++i)
+  {
+    while (link_rx[i]->available())
+    {
+      Flit flit = link_rx[i]->receive();
+      ejected_flits++;
+      total_ejected_flits_++;
+      last_activity_cycle_ = currentCycle();
+      if (flit.flit_type == FLIT_TYPE_TAIL)
+        ejected_packets++;
+
+      if (FlitTrace::enabled())
+        FlitTrace::record(currentCycle(), local_id, i, flit.vc_id,
+                          flit.flit_type, flit.packet_id,
+                          static_cast<int>(flit.data_type), flit.command,
+                          FT_EJECT);
+    }
+  }
+}
+
+void ReplayPE::txProcess()
+{
+  PROFILE_SCOPE(PROF_PE_TX, GlobalParams::node_level_map[local_id]);
+  if (reset.read())
+  {
+    for (int i = 0; i < num_local_ports_; ++i)
+      link_tx[i]->reset();
+    vc_arbiter_.reset();
+    for (auto &q : packet_queues_)
+    {
+      while (!q.empty())
+        q.pop();
+    }
+    return;
+  }
+
+  // 复位期间时间也在前进，trace 周期相对于复位结束
+  double now = currentCycle() - GlobalParams::reset_time;
+
+  // --- 步骤 A: 把到期的 trace 记录转换成 Packet 推入 VC 队列 ---
+  const InjectionTraceRecord *rec;
+  while ((rec = InjectionTrace::recordOf(local_id, next_record_)) != nullptr &&
+         rec->cycle <= now)
+  {
+    Packet pkt;
+    pkt.src_id = rec->src_id;
+    pkt.dst_id = -2;
+    pkt.vc_id = rec->vc_id;
+    pkt.logical_timestamp = rec->logical_timestamp;
+    pkt.size = pkt.flit_left = rec->size;
+    pkt.use_low_voltage_path = false;
+    pkt.payload_data_size = rec->payload_data_size;
+    for (int k = 0; k < 3; k++)
+      pkt.payload_sizes[k] = rec->payload_sizes[k];
+    pkt.data_type = static_cast<DataType>(rec->data_type);
+    pkt.command = rec->command;
+    pkt.target_role = static_cast<PE_Role>(rec->target_role);
+
+    assert(pkt.vc_id >= 0 && pkt.vc_id < GlobalParams::n_virtual_channels &&
+           "replay trace uses more VCs than configured");
+    packet_queues_[pkt.vc_id].push(pkt);
+    injected_packets++;
+    next_record_++;
+  }
+
+  // --- 步骤 B: 按 VC 仲裁顺序发送，直到链路不能再接收 ---
+  // (每个包走其数据类型对应的 LOCAL 端口；窄链路每周期最多一个 flit，
+  // 宽链路每周期多个)
+  bool sent = true;
+  while (sent)
+  {
+    sent = false;
+    for (int i = 0; i < GlobalParams::n_virtual_channels; ++i)
+    {
+      int vc = vc_arbiter_.order()[i];
+      if (packet_queues_[vc].empty())
+        continue;
+      int port =
+          local_port_[static_cast<int>(packet_queues_[vc].front().data_type)];
+      if (!link_tx[port]->canSend(vc))
+        continue;
+
+      Flit flit = nextFlit(packet_queues_[vc]);
+      flit.vc_id = vc;
+      vc_arbiter_.served(vc);
+
+      link_tx[port]->send(flit);
+      sent = true;
+
+      injected_flits++;
+      total_injected_flits_++;
+      last_activity_cycle_ = currentCycle();
+
+      if (FlitTrace::enabled())
+        FlitTrace::record(currentCycle(), local_id, port, vc, flit.flit_type,
+                          flit.packet_id, static_cast<int>(flit.data_type),
+                          flit.command, FT_INJECT);
+      break;
+    }
+  }
+
+  // --- 步骤 C: 排空检测 ---
+  if (!exhausted_ && next_record_ >= InjectionTrace::recordsOf(local_id))
+  {
+    bool queues_empty = true;
+    for (const auto &q : packet_queues_)
+      queues_empty = queues_empty && q.empty();
+    if (queues_empty)
+    {
+      exhausted_ = true;
+      active_sources_--;
+      LOG_MEDIUM << "[REPLAY] Node " << local_id << " finished injecting "
+                 << injected_packets << " packets" << endl;
+    }
+  }
+
+  // 只由一个节点负责结束仿真
+  if (local_id == 0 && active_sources_ == 0 &&
+      currentCycle() - last_activity_cycle_ > REPLAY_DRAIN_CYCLES)
+  {
+    LOG_LOW << "[REPLAY] All sources exhausted and network drained, "
+            << "stopping simulation" << endl;
+    sc_stop();
+  }
+}
+
+Flit ReplayPE::nextFlit(std::queue<Packet> &queue)
+{
+  Flit flit;
+  Packet &packet = queue.front();
+
+  flit.src_id = packet.src_id;
+  flit.vc_id = packet.vc_id;
+  flit.logical_timestamp = packet.logical_timestamp;
+  flit.sequence_no = packet.size - packet.flit_left;
+  flit.sequence_length = packet.size;
+  flit.hop_no = 0;
+  flit.payload_data_size = packet.payload_data_size;
+  flit.hub_relay_node = NOT_VALID;
+  flit.data_type = packet.data_type;
+  flit.command = packet.command;
+  flit.target_role = packet.target_role;
+  std::copy(std::begin(packet.payload_sizes), std::end(packet.payload_sizes),
+            flit.payload_sizes);
+
+  if (packet.size == packet.flit_left)
+  {
+    packet.packet_id = ProcessingElement::next_packet_id_++;
+    flit.flit_type = FLIT_TYPE_HEAD;
+  }
+  else if (packet.flit_left == 1)
+  {
+    flit.flit_type = FLIT_TYPE_TAIL;
+  }
+  else
+  {
+    flit.flit_type = FLIT_TYPE_BODY;
+  }
+  flit.packet_id = packet.packet_id;
+
+  packet.flit_left--;
+  if (packet.flit_left == 0)
+    queue.pop();
+
+  return flit;
+}
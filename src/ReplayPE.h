@@ -0,0 +1,95 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the replay processing element.
+ * It re-injects the packets of an injection trace (see InjectionTrace.h)
+ * at their recorded cycles and sinks everything it receives, so that the
+ * NoC can be simulated without TaskManager / BufferManager.
+ */
+
+#ifndef __NOXIMREPLAYPE_H__
+#define __NOXIMREPLAYPE_H__
+
+#include <queue>
+#include <systemc.h>
+#include <vector>
+
+#include "DataStructs.h"
+#include "GlobalParams.h"
+#include "InjectionTrace.h"
+#include "ProcessingElement.h"
+#include "VcArbiter.h"
+
+// 所有源耗尽后，连续这么多周期没有 flit 被接收即认为网络已排空
+#define REPLAY_DRAIN_CYCLES 1000
+
+using namespace std;
+
+SC_MODULE(ReplayPE) {
+
+  // I/O Ports (与 ProcessingElement 保持一致，Tile 用同一套绑定)
+  sc_in_clk clock;
+  sc_in<bool> reset;
+
+  sc_port<LinkRxIf, 1, SC_ZERO_OR_MORE_BOUND> link_rx[NUM_LOCAL_PORTS];
+  sc_port<LinkTxIf, 1, SC_ZERO_OR_MORE_BOUND> link_tx[NUM_LOCAL_PORTS];
+  int num_local_ports_;            // 本层使用的 LOCAL 端口数
+  int local_port_[NUM_DATA_TYPES]; // 数据类型 -> LOCAL 端口
+
+  // Registers
+  int local_id;
+  std::vector<std::queue<Packet>> packet_queues_;
+  VcArbiter vc_arbiter_; // 发送时 VC 的服务顺序 (本层 vc_arbitration)
+
+  size_t next_record_;  // 下一条待注入的 trace 记录
+  bool exhausted_;      // trace 记录已全部注入且队列已清空
+
+  // 本节点统计
+  unsigned long injected_packets;
+  unsigned long injected_flits;
+  unsigned long ejected_packets;
+  unsigned long ejected_flits;
+
+  // Functions
+  void rxProcess();
+  void txProcess();
+  void configure(int id);
+
+  // 全局排空检测
+  static int active_sources_;
+  static double last_activity_cycle_;
+  static unsigned long total_injected_flits_;
+  static unsigned long total_ejected_flits_;
+
+  SC_CTOR(ReplayPE) {
+    local_id = -1;
+    next_record_ = 0;
+    exhausted_ = false;
+    num_local_ports_ = 1;
+    std::fill(local_port_, local_port_ + NUM_DATA_TYPES, 0);
+    injected_packets = injected_flits = 0;
+    ejected_packets = ejected_flits = 0;
+
+    packet_queues_.resize(GlobalParams::n_virtual_channels);
+
+    SC_METHOD(rxProcess);
+    sensitive << reset;
+    sensitive << clock.neg();
+
+    SC_METHOD(txProcess);
+    sensitive << reset;
+    sensitive << clock.pos();
+  }
+
+private:
+  Flit nextFlit(std::queue<Packet> & queue);
+  double currentCycle() const {
+    return sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+  }
+};
+
+#endif
@@ -91,15 +91,16 @@ void ReservationTable::print()
 {
   for (int o = 0; o < n_outputs; o++)
   {
-    LOG << o << ": ";
+    ostringstream line;
+    line << o << ": ";
     for (vector<TReservation>::size_type i = 0;
          i < rtable[o].reservations.size(); i++)
     {
-      LOG << "<" << rtable[o].reservations[i].input << ","
-          << rtable[o].reservations[i].vc << ">, ";
+      line << "<" << rtable[o].reservations[i].input << ","
+           << rtable[o].reservations[i].vc << ">, ";
     }
-    LOG << " | " << rtable[o].index;
-    LOG << endl;
+    line << " | " << rtable[o].index;
+    LOG << line.str() << endl;
   }
 }
 
@@ -210,14 +211,14 @@ void ReservationTable::reserve(const TReservation &r,
 {
   assert(checkReservation(r, outputs) == RT_AVAILABLE); // 断言检查
 
-  LOG << "[RT::reserve] input=" << r.input << " vc=" << r.vc << " outputs={";
-  for (size_t i = 0; i < outputs.size(); ++i)
+  if (LOG_ENABLED(noxim_log::LVL_HIGH))
   {
-    if (i > 0)
-      LOG << ",";
-    LOG << outputs[i];
+    ostringstream list;
+    for (size_t i = 0; i < outputs.size(); ++i)
+      list << (i > 0 ? "," : "") << outputs[i];
+    LOG << "[RT::reserve] input=" << r.input << " vc=" << r.vc << " outputs={"
+        << list.str() << "}" << endl;
   }
-  LOG << "}" << endl;
 
   // 提交阶段：预留所有端口（直接操作，避免重复检查）
   for (vector<int>::const_iterator it = outputs.begin(); it != outputs.end();
@@ -233,14 +234,14 @@ void ReservationTable::reserve(const TReservation &r,
 void ReservationTable::release(const TReservation &r,
                                const vector<int> &outputs)
 {
-  LOG << "[RT::release] input=" << r.input << " vc=" << r.vc << " outputs={";
-  for (size_t i = 0; i < outputs.size(); ++i)
+  if (LOG_ENABLED(noxim_log::LVL_HIGH))
   {
-    if (i > 0)
-      LOG << ",";
-    LOG << outputs[i];
+    ostringstream list;
+    for (size_t i = 0; i < outputs.size(); ++i)
+      list << (i > 0 ? "," : "") << outputs[i];
+    LOG << "[RT::release] input=" << r.input << " vc=" << r.vc << " outputs={"
+        << list.str() << "}" << endl;
   }
-  LOG << "}" << endl;
 
   for (vector<int>::const_iterator it = outputs.begin(); it != outputs.end();
        ++it)
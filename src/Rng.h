@@ -0,0 +1,71 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the per-module random number streams.
+ * Every module owns an RngStream derived from (rnd_generator_seed, domain,
+ * id). The k-th draw of a stream is a pure function of its key and k
+ * (counter-based, SplitMix64 finaliser), so results do not depend on the
+ * evaluation order of the modules and a stream can be re-positioned with
+ * seek().
+ */
+
+#ifndef __NOXIMRNG_H__
+#define __NOXIMRNG_H__
+
+#include <cstdint>
+
+#include "GlobalParams.h"
+
+// 不同种类的模块使用不同的 domain，保证同一个 id 的 PE/Hub 流互不相关
+enum RngDomain {
+  RNG_DOMAIN_PE = 1,
+  RNG_DOMAIN_HUB,
+  RNG_DOMAIN_MOCK_PE,
+};
+
+class RngStream {
+public:
+  RngStream() : key_(0), counter_(0) {}
+  RngStream(uint64_t seed, uint64_t stream)
+      : key_(mix(seed ^ mix(stream + 0x632be59bd9b4e019ULL))), counter_(0) {}
+
+  // 第 counter 个 64 位随机数
+  uint64_t next() { return mix(key_ + (++counter_) * 0x9e3779b97f4a7c15ULL); }
+
+  // [0, 1)
+  double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+  // [min, max]
+  int uniformInt(int min, int max) {
+    return min + (int)((double)(max - min + 1) * uniform());
+  }
+
+  // [0, n)
+  unsigned int below(unsigned int n) { return (unsigned int)(uniform() * n); }
+
+  uint64_t position() const { return counter_; }
+  void seek(uint64_t counter) { counter_ = counter; }
+
+private:
+  uint64_t key_;
+  uint64_t counter_;
+
+  static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+};
+
+namespace RngService {
+inline RngStream stream(RngDomain domain, int id) {
+  uint64_t s = ((uint64_t)domain << 32) | (uint32_t)id;
+  return RngStream((uint64_t)(uint32_t)GlobalParams::rnd_generator_seed, s);
+}
+} // namespace RngService
+
+#endif
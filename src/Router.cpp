@@ -9,6 +9,8 @@
  */
 
 #include "Router.h"
+#include "FlitTrace.h"
+#include "Profiler.h"
 #include <dbg.h>
 #include <iomanip>
 #include <systemc.h>
@@ -21,15 +23,9 @@ void Router::process() {
 }
 
 void Router::rxProcess() {
+  PROFILE_SCOPE(PROF_ROUTER_RX, local_level);
   if (reset.read()) {
-    TBufferFullStatus bfs;
-    // Clear outputs and indexes of receiving protocol
-    for (size_t i = 0; i < all_flit_rx.size(); i++) {
-      all_ack_rx[i]->write(0);
-      current_level_rx[i] = 0;
-      all_buffer_full_status_rx[i]->write(bfs);
-    }
-    routed_flits = 0;
+    // 链路由发送方在 txProcess 中复位
     routed_flits = 0;
     local_drained = 0;
     has_rx_activity = false;
@@ -37,96 +33,67 @@ void Router::rxProcess() {
     has_rx_activity = false; // Reset per cycle
     // This process simply sees a flow of incoming flits. All arbitration
     // and wormhole related issues are addressed in the txProcess()
-    // assert(false);
-    for (size_t i = 0; i < all_flit_rx.size(); i++) {
-      // To accept a new flit, the following conditions must match:
-      // 1) there is an incoming request
-      // 2) there is a free slot in the input buffer of direction i
-      // LOG<<"****RX****DIRECTION ="<<i<<  endl;
-      if (i == 1) {
-        LOG << " h_flit_rx_down[0] req=" << all_req_rx[i]->read()
-            << " current_level_rx=" << current_level_rx[i] << endl;
-      }
-
-      if (all_req_rx[i]->read() == 1 - current_level_rx[i]) {
-        Flit received_flit = all_flit_rx[i]->read();
-
-        // LOG<<"request opposite to the current_level, reading flit
-        // "<<received_flit<<endl;
-
-        int vc = received_flit.vc_id;
-        assert(buffers[i] != nullptr && "Pointer to BufferBank is null!");
-        if (!(*buffers[i])[vc].IsFull()) {
-
-          if (use_predefined_routing &&
-              routing_patterns.count(received_flit.data_type) > 0 &&
-              received_flit.command != -1) {
-
-            const RoutingPattern &pattern =
-                routing_patterns[received_flit.data_type];
-            if (received_flit.target_role == role) {
-              received_flit.forward_count = 1;
-            }
-            // Transmission mode switching logic
-            else if (GlobalParams::transmission_mode == "traditional") {
-              // Traditional mode: forward_count equals number of port_groups
-              received_flit.forward_count = pattern.port_groups.size();
-            } else {
-              // Optimized mode: based on target_role setting
-              received_flit.forward_count = pattern.forward_count; // 从配置获取
-            }
-          }
-
-          received_flit.current_forward = 0;
-
-          (*buffers[i])[vc].Push(received_flit);
-          LOG << " Flit " << received_flit << " " << received_flit.flit_type
-              << " collected from Input[" << i << "][" << vc << "]" << endl;
-          LOG << "[RX_PORT0] Received Flit on VC " << vc
-              << " src_id=" << received_flit.src_id
-              << " dst_id=" << received_flit.dst_id
-              << " flit_type=" << received_flit.flit_type
-              << " buffer_size=" << (*buffers[i])[vc].Size()
-              << " flit_data_type=" << DataType_to_str(received_flit.data_type)
-              << " flit_seq_no=" << received_flit.sequence_no
-              << " flit_command=" << received_flit.command << endl;
-
-          power.bufferRouterPush();
-
-          // Negate the old value for Alternating Bit Protocol (ABP)
-          // LOG<<"INVERTING CL FROM "<< current_level_rx[i]<< " TO "<<  1 -
-          // current_level_rx[i]<<endl;
-          current_level_rx[i] = 1 - current_level_rx[i];
-
-          if (received_flit.src_id == local_id)
-            power.networkInterface();
-
-          has_rx_activity = true; // Mark RX activity
-        }
-
-        else // buffer full
-        {
-          // should not happen with the new TBufferFullStatus control signals
-          // except for flit coming from local PE, which don't use it
-          LOG << " Flit " << received_flit << " buffer full Input[" << i << "]["
-              << vc << "]" << endl;
-          std::cout << "buffer_full_status_rx[" << i << "].mask[" << vc
-                    << "] = " << all_buffer_full_status_rx[i]->read().mask[vc]
-                    << std::endl;
-          assert(port_info_map[i].type == PORT_LOCAL);
-        }
+    for (size_t i = 0; i < all_link_rx.size(); i++) {
+      LinkRxPort &link = *all_link_rx[i];
+      // 链路的流控 (信用或满掩码) 保证到达的 flit 一定有空位
+      while (link->available()) {
+        Flit received_flit = link->receive();
+        assert(!(*buffers[i])[received_flit.vc_id].IsFull() &&
+               "link flow control violated");
+        acceptFlit(i, received_flit);
       }
-      all_ack_rx[i]->write(current_level_rx[i]);
-      // updates the mask of VCs to prevent incoming data on full buffers
-      TBufferFullStatus bfs;
-      for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++) {
-        bfs.mask[vc] = (*buffers[i])[vc].IsFull();
+      // ABP: 空位不足一个周期的 burst 时报告为满
+      if (!link->usesCredits()) {
+        unsigned int mask = 0;
+        unsigned int burst = link->burstSize();
+        for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++)
+          if ((*buffers[i])[vc].getCurrentFreeSlots() < burst)
+            mask |= 1u << vc;
+        link->setFullMask(mask);
       }
-      all_buffer_full_status_rx[i]->write(bfs);
     }
   }
 }
 
+// 把一个到达的 flit 写入输入 buffer
+void Router::acceptFlit(int i, Flit &received_flit) {
+  int vc = received_flit.vc_id;
+
+  // forward_count 已在 buildRouteDecisions() 中按传输模式预先算好
+  const RouteDecision &decision =
+      routeDecision(received_flit.data_type, received_flit.command,
+                    received_flit.target_role);
+  if (decision.forward_count >= 0)
+    received_flit.forward_count = decision.forward_count;
+
+  received_flit.current_forward = 0;
+
+  (*buffers[i])[vc].Push(received_flit);
+  if (FlitTrace::enabled())
+    FlitTrace::record(
+        sc_time_stamp().to_double() / GlobalParams::clock_period_ps, local_id,
+        i, vc, received_flit.flit_type, received_flit.packet_id,
+        static_cast<int>(received_flit.data_type), received_flit.command,
+        FT_ROUTER_RX);
+  LOG << " Flit " << received_flit << " " << received_flit.flit_type
+      << " collected from Input[" << i << "][" << vc << "]" << endl;
+  LOG << "[RX_PORT0] Received Flit on VC " << vc
+      << " src_id=" << received_flit.src_id
+      << " dst_id=" << received_flit.dst_id
+      << " flit_type=" << received_flit.flit_type
+      << " buffer_size=" << (*buffers[i])[vc].Size()
+      << " flit_data_type=" << DataType_to_str(received_flit.data_type)
+      << " flit_seq_no=" << received_flit.sequence_no
+      << " flit_command=" << received_flit.command << endl;
+
+  power.bufferRouterPush();
+
+  if (received_flit.src_id == local_id)
+    power.networkInterface();
+
+  has_rx_activity = true; // Mark RX activity
+}
+
 vector<vector<int>>
 Router::getCurrentPortGroups(int forward_count, int current_forward,
                              const vector<vector<int>> &all_groups) {
@@ -148,143 +115,154 @@ Router::getCurrentPortGroups(int forward_count, int current_forward,
 }
 
 void Router::txProcess() {
+  PROFILE_SCOPE(PROF_ROUTER_TX, local_level);
 
   if (reset.read()) {
     // Clear outputs and indexes of transmitting protocol
-    for (size_t i = 0; i < all_flit_tx.size(); i++) {
-      all_req_tx[i]->write(0);
-      current_level_tx[i] = 0;
-    }
+    for (size_t i = 0; i < all_link_tx.size(); i++)
+      (*all_link_tx[i])->reset();
     reservation_table.reset();
+    aggregation_table.clear();
+    aggregation_ready.clear();
     has_tx_activity = false;
   } else {
+    (this->*tx_process_fn)();
+  }
+}
 
-    for (size_t j = 0; j < all_flit_rx.size(); j++) {
-      size_t i = (start_from_port + j) % all_flit_rx.size();
+bool Router::outputReady(int output_port, int vc) {
+  return (*all_link_tx[output_port])->canSend(vc);
+}
 
-      for (int k = 0; k < GlobalParams::n_virtual_channels; k++) {
+void Router::sendFlit(int output_port, const Flit &flit) {
+  (*all_link_tx[output_port])->send(flit);
+}
 
-        int vc = (start_from_vc[i] + k) % (GlobalParams::n_virtual_channels);
+void Router::popFlit(int input_port, int vc) {
+  (*buffers[input_port])[vc].Pop();
+  power.bufferRouterPop();
+  if ((*all_link_rx[input_port])->usesCredits())
+    (*all_link_rx[input_port])->returnCredit(vc);
+}
 
-        // Uncomment to enable deadlock checking on buffers.
-        // Please also set the appropriate threshold.
-        // (*buffers[i]).deadlockCheck();
+// txProcess 的主体，按层级特化：
+//  - AGGREGATE: 本层做回送包聚合 (GLB 等)，否则聚合相关分支在编译期消除
+//  - MULTICAST: 本层使用预定义 port_groups 路由 (多播/分批转发)
+// configure 按 is_aggregation / use_predefined_routing 选择实例，实例内部
+// 不再检查这两个运行时条件
+template <bool AGGREGATE, bool MULTICAST> void Router::txProcessPolicy() {
+  for (size_t j = 0; j < all_link_rx.size(); j++) {
+    size_t i = (start_from_port + j) % all_link_rx.size();
 
-        if (!(*buffers[i])[vc].IsEmpty()) {
+    for (int k = 0; k < GlobalParams::n_virtual_channels; k++) {
 
-          Flit flit = (*buffers[i])[vc].Front();
-          power.bufferRouterFront();
+      int vc = vc_arbitrated
+                   ? vc_arbiters[i].order()[k]
+                   : (start_from_vc[i] + k) % (GlobalParams::n_virtual_channels);
 
-          if (port_info_map[i].type == PORT_DOWN && vc == return_vc_id &&
-              is_aggregation) {
-            if (tryAggregation(i, flit)) {
-              (*buffers[i])[vc].Pop();
-              power.bufferRouterPop();
-            }
-            // 如果返回false(重复添加或属性不匹配),不弹出flit
-            continue;
-          }
+      // Uncomment to enable deadlock checking on buffers.
+      // Please also set the appropriate threshold.
+      // (*buffers[i]).deadlockCheck();
 
-          if (flit.flit_type == FLIT_TYPE_HEAD && flit.current_forward == 0) {
-            // 统一准备路由数据
-            RouteData route_data;
-            route_data.current_id = local_id;
-            route_data.src_id = flit.src_id;
-            // route_data.dst_ids = flit.dst_ids; // 删除：不再使用dst_ids
-            route_data.dir_in = i;
-            route_data.vc_id = flit.vc_id;
-            route_data.is_output = flit.is_output;
-            route_data.data_type = flit.data_type;
-            route_data.target_role = flit.target_role;
-            route_data.command = flit.command;
-
-            // 统一调用route()获取输出端口
-            vector<int> output_ports = route(route_data);
-
-            // 调试输出
-            // 调试输出
-            LOG << "Router " << local_id << " route from input " << i
-                << " to outputs: ";
-            for (size_t idx = 0; idx < output_ports.size(); idx++) {
-              LOG << output_ports[idx]
-                  << (idx < output_ports.size() - 1 ? ", " : "");
-            }
-            LOG << endl;
-
-            // 处理Hub中继的特殊情况
-            if (output_ports.size() == 1 &&
-                output_ports[0] >= DIRECTION_HUB_RELAY) {
-              Flit f = (*buffers[i])[vc].Pop();
-              f.hub_relay_node = output_ports[0] - DIRECTION_HUB_RELAY;
-              (*buffers[i])[vc].Push(f);
-              output_ports[0] = DIRECTION_HUB;
-            }
+      if (!(*buffers[i])[vc].IsEmpty()) {
 
-            // 统一的预留逻辑
-            TReservation r;
-            r.input = i;
-            r.vc = vc;
-
-            LOG << " checking availability of Output(s) for Input[" << i << "]["
-                << vc << "] flit " << flit << endl;
-
-            int reservation_status =
-                reservation_table.checkReservation(r, output_ports);
-
-            if (reservation_status == RT_AVAILABLE) {
-              LOG << " reserving outputs for flit " << flit << endl;
-              reservation_table.reserve(r, output_ports);
-
-              // // 建立output到dst_ids的映射(用于分裂转发)
-              // map<int, set<int>> output_to_dsts = buildOutputMapping(flit,
-              // output_ports, i); reservation_table.setOutputMapping(r.input,
-              // r.vc, output_to_dsts);
-            } else if (reservation_status == RT_ALREADY_SAME) {
-              LOG << " RT_ALREADY_SAME reserved outputs for flit " << flit
-                  << endl;
-            } else if (reservation_status == RT_OUTVC_BUSY) {
-              LOG << " RT_OUTVC_BUSY reservation for flit " << flit << endl;
-            } else if (reservation_status == RT_ALREADY_OTHER_OUT) {
-              LOG << "RT_ALREADY_OTHER_OUT: another outputs previously "
-                     "reserved for the same flit"
-                  << endl;
-            } else {
-              assert(false);
-            }
-          }
-        }
-      }
-      start_from_vc[i] =
-          (start_from_vc[i] + 1) % GlobalParams::n_virtual_channels;
-    }
+        Flit flit = (*buffers[i])[vc].Front();
+        power.bufferRouterFront();
 
-    start_from_port = (start_from_port + 1) % all_flit_rx.size();
+        if (AGGREGATE && vc == return_vc_id &&
+            port_info_map[i].type == PORT_DOWN) {
+          if (tryAggregation(i, flit))
+            popFlit(i, vc);
+          // 如果返回false(聚合表已满),不弹出flit
+          continue;
+        }
 
-    if (aggregation_entry.port_flits.size() ==
-            aggregation_entry.expected_port_count &&
-        is_aggregation) {
-      LOG << "All " << aggregation_entry.expected_port_count
-          << " downstream ports ready, triggering aggregation" << endl;
+        if (flit.flit_type == FLIT_TYPE_HEAD && flit.current_forward == 0) {
+          // 统一准备路由数据
+          RouteData route_data;
+          route_data.current_id = local_id;
+          route_data.src_id = flit.src_id;
+          // route_data.dst_ids = flit.dst_ids; // 删除：不再使用dst_ids
+          route_data.dir_in = i;
+          route_data.vc_id = flit.vc_id;
+          route_data.is_output = flit.is_output;
+          route_data.data_type = flit.data_type;
+          route_data.target_role = flit.target_role;
+          route_data.command = flit.command;
+
+          // 统一调用route()获取输出端口
+          const vector<int> &output_ports = route(route_data);
+
+          // 调试输出
+          if (LOG_ENABLED(noxim_log::LVL_HIGH)) {
+            ostringstream ports;
+            for (size_t idx = 0; idx < output_ports.size(); idx++)
+              ports << (idx > 0 ? ", " : "") << output_ports[idx];
+            LOG << "Router " << local_id << " route from input " << i
+                << " to outputs: " << ports.str() << endl;
+          }
 
-      if (performAggregation()) {
-        aggregation_entry.port_flits.clear();
+          // 统一的预留逻辑
+          TReservation r;
+          r.input = i;
+          r.vc = vc;
+
+          LOG << " checking availability of Output(s) for Input[" << i << "]["
+              << vc << "] flit " << flit << endl;
+
+          int reservation_status =
+              reservation_table.checkReservation(r, output_ports);
+
+          if (reservation_status == RT_AVAILABLE) {
+            LOG << " reserving outputs for flit " << flit << endl;
+            reservation_table.reserve(r, output_ports);
+
+            // // 建立output到dst_ids的映射(用于分裂转发)
+            // map<int, set<int>> output_to_dsts = buildOutputMapping(flit,
+            // output_ports, i); reservation_table.setOutputMapping(r.input,
+            // r.vc, output_to_dsts);
+          } else if (reservation_status == RT_ALREADY_SAME) {
+            LOG << " RT_ALREADY_SAME reserved outputs for flit " << flit
+                << endl;
+          } else if (reservation_status == RT_OUTVC_BUSY) {
+            LOG << " RT_OUTVC_BUSY reservation for flit " << flit << endl;
+          } else if (reservation_status == RT_ALREADY_OTHER_OUT) {
+            LOG << "RT_ALREADY_OTHER_OUT: another outputs previously "
+                   "reserved for the same flit"
+                << endl;
+          } else {
+            assert(false);
+          }
+        }
       }
     }
+    start_from_vc[i] =
+        (start_from_vc[i] + 1) % GlobalParams::n_virtual_channels;
+  }
 
-    //==================================================================
-    // 2nd phase: Two-Phase Arbitration & Atomic Forwarding
-    // 阶段A: 候选筛选 - 收集所有准备就绪的VC
-    //==================================================================
-    struct ForwardCandidate {
-      int input;
-      int vc;
-      vector<int> target_outputs;
-    };
-
-    vector<ForwardCandidate> candidates;
-
-    for (int i = 0; i < all_flit_rx.size(); i++)
-      for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++) {
+  start_from_port = (start_from_port + 1) % all_link_rx.size();
+
+  //==================================================================
+  // 2nd phase: Two-Phase Arbitration & Atomic Forwarding
+  // 阶段A: 候选筛选 - 收集所有准备就绪的VC
+  //==================================================================
+  struct ForwardCandidate {
+    int input;
+    int vc;
+    vector<int> target_outputs;
+  };
+
+  // 宽链路每周期可以传多个 flit：重复候选筛选与仲裁，直到没有授予或达到
+  // 本 router 最宽链路的 flit/周期数。输出是否还能发送由链路的带宽预算决定
+  vector<ForwardCandidate> candidates;
+  for (int round = 0; round < tx_rounds; round++) {
+    candidates.clear();
+
+    for (int i = 0; i < (int)all_link_rx.size(); i++) {
+      const int *vc_order = vc_arbitrated ? vc_arbiters[i].order() : nullptr;
+      int first_ready = -1;
+      for (int k = 0; k < GlobalParams::n_virtual_channels; k++) {
+        int vc = vc_order ? vc_order[k] : k;
         if ((*buffers[i])[vc].IsEmpty())
           continue;
 
@@ -295,25 +273,29 @@ void Router::txProcess() {
 
         bool all_outputs_ready = true;
         for (int output_port : target_outputs) {
-          if (current_level_tx[output_port] !=
-                  all_ack_tx[output_port]->read() ||
-              all_buffer_full_status_tx[output_port]->read().mask[vc] == 1) {
+          if (!outputReady(output_port, vc)) {
             all_outputs_ready = false;
             break;
           }
         }
         if (all_outputs_ready) {
+          // 非轮询仲裁：只提交最优先的就绪 VC
+          if (vc_order && first_ready >= 0 &&
+              !vc_arbiters[i].sameClass(first_ready, vc))
+            break;
+          if (first_ready < 0)
+            first_ready = vc;
           candidates.push_back({i, vc, target_outputs});
         }
       }
+    }
 
-    if (!aggregated_flit_queue.empty()) {
-      auto target_outputs = reservation_table.getReservations(-1, return_vc_id);
+    if (AGGREGATE && aggregatedFlitReady()) {
+      auto target_outputs =
+          reservation_table.getReservations(-1, return_vc_id);
       bool all_outputs_ready = true;
       for (int output_port : target_outputs) {
-        if (current_level_tx[output_port] != all_ack_tx[output_port]->read() ||
-            all_buffer_full_status_tx[output_port]->read().mask[return_vc_id] ==
-                1) {
+        if (!outputReady(output_port, return_vc_id)) {
           all_outputs_ready = false;
           break;
         }
@@ -326,57 +308,48 @@ void Router::txProcess() {
     //==================================================================
     // 阶段B: 仲裁与原子转发
     //==================================================================
+    // 聚合队列 (input == -1) 映射为分配器的最后一个 input
+    int agg_input = all_link_rx.size();
+    alloc_requests.clear();
+    for (const ForwardCandidate &c : candidates) {
+      AllocRequest req;
+      req.input = (c.input == -1) ? agg_input : c.input;
+      req.vc = c.vc;
+      req.outputs = &c.target_outputs;
+      req.age = 0;
+      alloc_requests.push_back(req);
+    }
+    // 每周期更新一次连续落选计数 (没有请求时也要清零上周期的请求者)
+    if (round == 0)
+      wait_ages.update(alloc_requests);
+
     if (!candidates.empty()) {
-      // 用于跟踪已使用的资源
-      std::set<int> used_inputs;
-      std::set<int> used_outputs;
-
-      while (!candidates.empty()) {
-        // 过滤出仍然可用的候选
-        vector<ForwardCandidate> available;
-        for (auto &c : candidates) {
-          // 检查 input 是否已被使用
-          if (used_inputs.count(c.input))
-            continue;
-
-          // 检查所有 output 是否都未被使用
-          bool output_conflict = false;
-          for (int o : c.target_outputs) {
-            if (used_outputs.count(o)) {
-              output_conflict = true;
-              break;
-            }
-          }
-          if (output_conflict)
-            continue;
+      for (AllocRequest &req : alloc_requests)
+        req.age = wait_ages.ageOf(req.input, req.vc);
 
-          // 添加到可用候选列表
-          available.push_back(c);
-        }
+      // 分配器保证授予集合中 input 互不相同、output 互不相交
+      allocator->allocate(alloc_requests, alloc_grants);
 
-        if (available.empty())
-          break; // 没有可用候选，退出循环
+      for (int winner_idx : alloc_grants) {
+        ForwardCandidate &selected = candidates[winner_idx];
+        const AllocRequest &granted = alloc_requests[winner_idx];
+        wait_ages.granted(granted);
+        if (vc_arbitrated && selected.input >= 0)
+          vc_arbiters[selected.input].served(selected.vc);
 
-        // 随机选择一个候选进行仲裁
-        int winner_idx = rand() % available.size();
-        ForwardCandidate &selected = available[winner_idx];
         Flit flit;
-        if (selected.input == -1) {
-          flit = aggregated_flit_queue.front();
-          aggregated_flit_queue.pop();
-          power.bufferRouterPop();
+        if (AGGREGATE && selected.input == -1) {
+          flit = popAggregatedFlit();
         } else {
           Flit &flit_ref = (*buffers[selected.input])[selected.vc].FrontRef();
           // 检查是否完成所有转发
           bool should_pop = true;
-          if (use_predefined_routing &&
-              routing_patterns.count(flit_ref.data_type) > 0) {
+          if (MULTICAST &&
+              pattern_by_type[static_cast<int>(flit_ref.data_type)]) {
             flit_ref.current_forward++;
             // 只有头flit和尾flit才可能复制多份
             if (flit_ref.flit_type == FLIT_TYPE_HEAD ||
                 flit_ref.flit_type == FLIT_TYPE_TAIL) {
-              const RoutingPattern &pattern =
-                  routing_patterns[flit_ref.data_type];
               if (flit_ref.current_forward < flit_ref.forward_count) {
                 should_pop = false; // 还未完成转发，不pop
               }
@@ -386,10 +359,8 @@ void Router::txProcess() {
 
           flit = (*buffers[selected.input])[selected.vc].Front();
 
-          if (should_pop) {
-            (*buffers[selected.input])[selected.vc].Pop();
-            power.bufferRouterPop();
-          }
+          if (should_pop)
+            popFlit(selected.input, selected.vc);
         }
 
         // 定义统一的功耗计算端口变量
@@ -397,23 +368,20 @@ void Router::txProcess() {
 
         if (flit.target_role == this->role) {
           int output_port = selected.target_outputs[0];
-          all_flit_tx[output_port]->write(flit);
-          current_level_tx[output_port] = 1 - current_level_tx[output_port];
-          all_req_tx[output_port]->write(current_level_tx[output_port]);
+          sendFlit(output_port, flit);
           has_tx_activity = true; // Mark TX activity
-        } else if (selected.input == -1 || flit.command == -1) {
+        } else if ((AGGREGATE && selected.input == -1) || flit.command == -1) {
           int output_port = selected.target_outputs[0];
-          all_flit_tx[output_port]->write(flit);
-          current_level_tx[output_port] = 1 - current_level_tx[output_port];
-          all_req_tx[output_port]->write(current_level_tx[output_port]);
+          sendFlit(output_port, flit);
           if (selected.target_outputs.size() > 0)
             has_tx_activity = true;
         }
 
         // 在转发阶段,检查是否使用预定义路由
-        else if (use_predefined_routing &&
-                 routing_patterns.count(flit.data_type) > 0) {
-          const RoutingPattern &pattern = routing_patterns[flit.data_type];
+        else if (MULTICAST &&
+                 pattern_by_type[static_cast<int>(flit.data_type)]) {
+          const RoutingPattern &pattern =
+              *pattern_by_type[static_cast<int>(flit.data_type)];
           vector<vector<int>> current_groups =
               getCurrentPortGroups(flit.forward_count, flit.current_forward - 1,
                                    pattern.port_groups);
@@ -436,16 +404,12 @@ void Router::txProcess() {
               // 根据组的大小决定转发方式
               if (group.size() == 1) {
                 // 单播到该端口
-                all_flit_tx[group[0]]->write(split_flit);
-                current_level_tx[group[0]] = 1 - current_level_tx[group[0]];
-                all_req_tx[group[0]]->write(current_level_tx[group[0]]);
+                sendFlit(group[0], split_flit);
                 has_tx_activity = true;
               } else {
                 // 多播到该组的所有端口
                 for (int port : group) {
-                  all_flit_tx[port]->write(split_flit);
-                  current_level_tx[port] = 1 - current_level_tx[port];
-                  all_req_tx[port]->write(current_level_tx[port]);
+                  sendFlit(port, split_flit);
                   has_tx_activity = true;
                 }
               }
@@ -456,16 +420,12 @@ void Router::txProcess() {
 
             if (group.size() == 1) {
               // 单播
-              all_flit_tx[group[0]]->write(flit);
-              current_level_tx[group[0]] = 1 - current_level_tx[group[0]];
-              all_req_tx[group[0]]->write(current_level_tx[group[0]]);
+              sendFlit(group[0], flit);
               has_tx_activity = true;
             } else {
               // 多播到所有端口
               for (int port : group) {
-                all_flit_tx[port]->write(flit);
-                current_level_tx[port] = 1 - current_level_tx[port];
-                all_req_tx[port]->write(current_level_tx[port]);
+                sendFlit(port, flit);
                 has_tx_activity = true;
               }
             }
@@ -485,6 +445,16 @@ void Router::txProcess() {
           power.crossBar();
         }
 
+        if (FlitTrace::enabled()) {
+          uint64_t cycle =
+              sc_time_stamp().to_double() / GlobalParams::clock_period_ps;
+          for (int output_port : power_calc_ports)
+            FlitTrace::record(cycle, local_id, output_port, selected.vc,
+                              flit.flit_type, flit.packet_id,
+                              static_cast<int>(flit.data_type), flit.command,
+                              FT_ROUTER_TX);
+        }
+
         for (int output_port : power_calc_ports) {
           if (output_port == DIRECTION_HUB) {
             power.r2hLink();
@@ -520,33 +490,16 @@ void Router::txProcess() {
           if (flit.current_forward >= flit.forward_count || flit.command == -1)
             reservation_table.release(r, selected.target_outputs);
         }
-        // 标记已使用的资源
-        used_inputs.insert(selected.input);
-        for (int o : selected.target_outputs) {
-          used_outputs.insert(o);
-        }
-
-        // 从候选列表中移除已处理的或产生冲突的候选
-        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
-                                        [&](const ForwardCandidate &c) {
-                                          // 移除使用相同 input 的
-                                          if (c.input == selected.input)
-                                            return true;
-
-                                          // 移除使用相同 output 的
-                                          for (int o : c.target_outputs) {
-                                            if (used_outputs.count(o))
-                                              return true;
-                                          }
-                                          return false;
-                                        }),
-                         candidates.end());
       }
     }
+
+    if (candidates.empty() || alloc_grants.empty())
+      break;
   }
 }
 
 void Router::perCycleUpdate() {
+  PROFILE_SCOPE(PROF_POWER, local_level);
   if (reset.read()) {
     return;
   } else {
@@ -565,24 +518,15 @@ void Router::perCycleUpdate() {
     has_tx_activity = false;
     has_rx_activity = false;
 
-    power.leakageRouter();
-    // 修正：遍历所有端口，包括本地端口
-    for (size_t i = 0; i < all_flit_rx.size(); i++) {
-      for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++) {
-        power.leakageBufferRouter();
-        power.leakageLinkRouter2Router();
-      }
-    }
-
-    power.leakageLinkRouter2Hub();
+    // 泄漏功耗只记周期数：router 逻辑 + 所有端口 (含本地端口) 的每个 VC
+    // buffer + r2h 链路，实例数在 configure() 中登记
+    power.poweredCycle();
   }
 }
 
 vector<int> Router::routingFunction(const RouteData &route_data) {
 
-  // TODO: fix all the deprecated verbose mode logs
-  if (GlobalParams::verbose_mode > VERBOSE_OFF)
-    LOG << "Wired routing for dst = " << route_data.dst_id << endl;
+  LOG_LOW << "Wired routing for dst = " << route_data.dst_id << endl;
 
   // not wireless direction taken, apply normal routing
   return routingAlgorithm->route(this, route_data);
@@ -617,45 +561,71 @@ vector<int> Router::routingFunction(const RouteData &route_data) {
 //     return output_to_dsts;
 // }
 
-vector<int> Router::route(const RouteData &route_data) {
-  vector<int> output_ports;
+const vector<int> &Router::route(const RouteData &route_data) {
+  const RouteDecision &decision = routeDecision(
+      route_data.data_type, route_data.command, route_data.target_role);
+  assert(!decision.output_ports.empty() &&
+         "No output ports determined in hierarchical routing");
 
-  if (GlobalParams::topology == TOPOLOGY_HIERARCHICAL) {
-    // 核心判断: target_role 是否匹配本地角色
-    if (route_data.target_role == this->role) {
-      // 情况1: 目标是本地角色,只需本地投递
-      output_ports.push_back(getLogicalPortIndex(PORT_LOCAL, 0));
-      return output_ports; // 直接返回,不再转发
-    } else {
-      // 情况2: target_role 不是本地角色,只转发不投递
-
-      // 子情况2a: 检查是否是回送包
-      if (route_data.command == -1) {
-        // 回送包向上发送
-        int up_port_index = getLogicalPortIndex(PORT_UP, -1);
-        assert(up_port_index != -1 &&
-               "No UP port found in hierarchical router for return packet");
-        if (local_level > 0) {
-          output_ports.push_back(up_port_index);
+  return decision.output_ports;
+}
+
+void Router::buildRouteDecisions() {
+  for (int t = 0; t < NUM_DATA_TYPES; t++) {
+    map<DataType, RoutingPattern>::const_iterator it =
+        routing_patterns.find(static_cast<DataType>(t));
+    bool found = use_predefined_routing && it != routing_patterns.end();
+    pattern_by_type[t] = found ? &it->second : nullptr;
+  }
+
+  bool traditional = GlobalParams::transmission_mode == "traditional";
+
+  for (int t = 0; t < NUM_DATA_TYPES; t++) {
+    const RoutingPattern *pattern = pattern_by_type[t];
+    for (int is_return = 0; is_return < 2; is_return++) {
+      for (int is_local = 0; is_local < 2; is_local++) {
+        RouteDecision &d = route_decisions[t][is_return][is_local];
+        d.output_ports.clear();
+        d.pattern = pattern;
+        d.forward_count = -1;
+
+        if (GlobalParams::topology != TOPOLOGY_HIERARCHICAL)
+          continue;
+
+        // 回送包不参与复制计数
+        if (pattern && !is_return) {
+          if (is_local)
+            d.forward_count = 1;
+          else if (traditional)
+            // Traditional mode: forward_count equals number of port_groups
+            d.forward_count = pattern->port_groups.size();
+          else
+            // Optimized mode: based on target_role setting
+            d.forward_count = pattern->forward_count;
         }
-      }
-      // 子情况2b: 使用预定义路由转发
-      else if (use_predefined_routing &&
-               routing_patterns.count(route_data.data_type) > 0) {
-        const RoutingPattern &pattern = routing_patterns[route_data.data_type];
-        for (const vector<int> &group : pattern.port_groups) {
-          for (int port : group) {
-            output_ports.push_back(port);
+
+        // 核心判断: target_role 是否匹配本地角色
+        if (is_local) {
+          // 情况1: 目标是本地角色,只需本地投递 (按数据类型选择 LOCAL 端口)
+          d.output_ports.push_back(
+              getLogicalPortIndex(PORT_LOCAL, local_port_of_type[t]));
+        } else if (is_return) {
+          // 情况2a: 回送包向上发送
+          if (local_level > 0) {
+            int up_port_index = getLogicalPortIndex(PORT_UP, -1);
+            assert(up_port_index != -1 &&
+                   "No UP port found in hierarchical router for return packet");
+            d.output_ports.push_back(up_port_index);
           }
+        } else if (pattern) {
+          // 情况2b: 使用预定义路由转发
+          for (const vector<int> &group : pattern->port_groups)
+            d.output_ports.insert(d.output_ports.end(), group.begin(),
+                                  group.end());
         }
       }
-      // 注意: 移除了动态路由的回退逻辑
     }
   }
-  assert(!output_ports.empty() &&
-         "No output ports determined in hierarchical routing");
-
-  return output_ports;
 }
 
 vector<int> Router::getMulticastChildren(const vector<int> &dst_ids) {
@@ -666,15 +636,7 @@ vector<int> Router::getMulticastChildren(const vector<int> &dst_ids) {
       int next_hop_child = getNextHopNode(dst_id);
 
       // 检查这个目标节点是否已经是我们的直接子节点
-      bool is_direct_child = false;
-      for (int i = 0; i < GlobalParams::fanouts_per_level
-                              [GlobalParams::node_level_map[local_id]];
-           i++) {
-        if (GlobalParams::child_map[local_id][i] == dst_id) {
-          is_direct_child = true;
-          break;
-        }
-      }
+      bool is_direct_child = GlobalParams::parent_map[dst_id] == local_id;
 
       // 如果目标是直接子节点，直接添加目标节点
       // 如果目标是孙子或更深层节点，添加下一跳子节点
@@ -719,13 +681,14 @@ void Router::configure(const int _id, const int _level,
   total_cycles = 0;
   has_tx_activity = false;
   has_rx_activity = false;
-  return_vc_id = 2;
+  // 回送包使用 OUTPUT 的 VC (各层一致，见 checkConfiguration)
+  return_vc_id = GlobalParams::hierarchical_config.get_level_config(local_level)
+                     .vc_of_type[static_cast<int>(DataType::OUTPUT)];
   is_aggregation =
       GlobalParams::hierarchical_config.get_level_config(local_level).aggregate;
-  aggregation_entry.expected_port_count =
-      GlobalParams::fanouts_per_level[local_level];
+  aggregation_expected_ports = num_down_ports;
   int down_port_offset =
-      (local_level > 0) ? 1 + NUM_LOCAL_PORTS : NUM_LOCAL_PORTS;
+      (local_level > 0) ? 1 + num_local_ports : num_local_ports;
 
   const LevelConfig &level_config =
       GlobalParams::hierarchical_config.get_level_config(local_level);
@@ -734,14 +697,24 @@ void Router::configure(const int _id, const int _level,
   if (level_config.has_routing_patterns) {
     this->routing_patterns = level_config.routing_patterns;
 
-    // 直接应用offset到所有路由模式
+    // 直接应用offset到所有路由模式。路由模式按层配置，子节点少于本层
+    // 最大 fanout 的节点去掉不存在的 DOWN 端口
     for (auto &pair : this->routing_patterns) {
       RoutingPattern &pattern = pair.second;
+      vector<vector<int>> groups;
       for (auto &group : pattern.port_groups) {
-        for (int &port : group) {
-          port += down_port_offset;
+        vector<int> ports;
+        for (int port : group) {
+          if (port < num_down_ports)
+            ports.push_back(port + down_port_offset);
         }
+        if (!ports.empty())
+          groups.push_back(ports);
       }
+      if (groups.size() < pattern.port_groups.size() &&
+          pattern.forward_count > (int)groups.size())
+        pattern.forward_count = groups.size();
+      pattern.port_groups.swap(groups);
     }
 
     int total_ports = 0;
@@ -755,13 +728,24 @@ void Router::configure(const int _id, const int _level,
     // Keep the default fanout-based expected port count when OUTPUT routing
     // groups are absent (e.g., root level with INPUT-only routing pattern).
     if (total_ports > 0) {
-      aggregation_entry.expected_port_count = total_ports;
+      aggregation_expected_ports = total_ports;
     }
 
     this->use_predefined_routing = true;
   }
+  buildRouteDecisions();
 
-  start_from_port = (all_flit_rx.size() > 0)
+  // 选择 txProcess 特化版本：叶子层/分发层不聚合，无预定义路由的层不做多播计数
+  if (is_aggregation)
+    tx_process_fn = use_predefined_routing
+                         ? &Router::txProcessPolicy<true, true>
+                         : &Router::txProcessPolicy<true, false>;
+  else
+    tx_process_fn = use_predefined_routing
+                        ? &Router::txProcessPolicy<false, true>
+                        : &Router::txProcessPolicy<false, false>;
+
+  start_from_port = (all_link_rx.size() > 0)
                         ? getLogicalPortIndex(PORT_LOCAL, 0)
                         : 0; // Start from LOCAL port
 
@@ -778,104 +762,153 @@ void Router::configure(const int _id, const int _level,
   if (grt.isValid())
     routing_table.configure(grt, _id);
 
-  reservation_table.setSize(all_flit_rx.size());
+  reservation_table.setSize(all_link_rx.size());
 
-  for (size_t i = 0; i < all_flit_rx.size(); i++) {
+  for (size_t i = 0; i < all_link_rx.size(); i++) {
+    // 同一端口的各 VC 共用一个标签
+    const string label = string(name()) + "->buffer[" + i_to_string(i) + "]";
     for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++) {
       (*buffers[i])[vc].SetMaxBufferSize(_max_buffer_size);
-      (*buffers[i])[vc].setLabel(string(name()) + "->buffer[" + i_to_string(i) +
-                                 "]");
+      (*buffers[i])[vc].setLabel(label);
     }
     start_from_vc[i] = 0;
   }
+
+  delete allocator;
+  allocator = Allocator::create(GlobalParams::allocator);
+  assert(allocator && "invalid allocator, checked by checkConfiguration()");
+  allocator->configure(all_link_rx.size(), all_link_tx.size(),
+                       GlobalParams::n_virtual_channels);
+  wait_ages.configure(all_link_rx.size(), GlobalParams::n_virtual_channels);
+
+  vc_arbitrated = level_config.vc_arbitration != VC_ARB_ROUND_ROBIN;
+  vc_arbiters.assign(all_link_rx.size(), VcArbiter());
+  for (VcArbiter &arbiter : vc_arbiters)
+    arbiter.configure(level_config.vc_arbitration, level_config.vc_weights,
+                      GlobalParams::n_virtual_channels);
+
+  // 每周期的转发轮数 = 本 router 最宽链路的 flit/周期数。
+  // LOCAL/DOWN 链路使用本层带宽，UP 链路使用父层带宽
+  const vector<LevelConfig> &levels = GlobalParams::hierarchical_config.levels;
+  tx_rounds = 1;
+  for (int l = _level - 1; l <= _level; l++)
+    if (l >= 0 && l < (int)levels.size())
+      tx_rounds =
+          max(tx_rounds, LinkChannel::flitsPerCycle(levels[l].bandwidth));
+
+  // 泄漏功耗：每个 powered cycle 对应的实例数 (见 perCycleUpdate)
+  power.setLeakageInstances(ROUTING_PWR_S, 1);
+  power.setLeakageInstances(SELECTION_PWR_S, 1);
+  power.setLeakageInstances(CROSSBAR_PWR_S, 1);
+  power.setLeakageInstances(NI_PWR_S, 1);
+  power.setLeakageInstances(BUFFER_ROUTER_PWR_S,
+                            all_link_rx.size() *
+                                GlobalParams::n_virtual_channels);
+  power.setLeakageInstances(LINK_R2H_PWR_S, 1);
 }
 
 bool Router::tryAggregation(int input_port, const Flit &flit) {
   // 验证是回送包且使用正确的VC
   assert(flit.vc_id == return_vc_id && "Return packet must use designated VC");
 
-  if (aggregation_entry.port_flits.count(input_port))
-    return false;
-
-  // 如果是第一个到达的flit,初始化聚合条目
-  if (aggregation_entry.port_flits.empty()) {
-    aggregation_entry.payload_data_size = flit.payload_data_size;
-    aggregation_entry.flit_type = flit.flit_type;
+  AggregationKey key(flit.logical_timestamp, flit.sequence_no);
+  auto it = aggregation_table.find(key);
+
+  // 如果是第一个到达的flit,初始化聚合条目；表满时反压该端口。
+  // 各端口按相同顺序发送回送 flit，最旧的未完成条目一定已在表中，不会死锁
+  if (it == aggregation_table.end()) {
+    if ((int)aggregation_table.size() >= GlobalParams::aggregation_entries)
+      return false;
+    it = aggregation_table.emplace(key, AggregationEntry()).first;
+    it->second.payload_data_size = flit.payload_data_size;
+    it->second.flit_type = flit.flit_type;
+    it->second.complete = false;
+    it->second.aggregated = flit;
   }
+  AggregationEntry &entry = it->second;
+
+  assert(!entry.complete && !entry.ports.count(input_port) &&
+         "duplicate return flit for the same aggregation entry");
 
   // 验证flit属性匹配
-  if (aggregation_entry.payload_data_size != flit.payload_data_size ||
-      aggregation_entry.flit_type != flit.flit_type) {
+  if (entry.payload_data_size != flit.payload_data_size ||
+      entry.flit_type != flit.flit_type) {
     assert(false && "mismatch in aggregation flit");
     return false;
   }
 
-  // 将该端口的flit加入聚合缓冲区
-  aggregation_entry.port_flits[input_port] = flit;
+  entry.ports.insert(input_port);
 
   // 检查是否所有下游端口都已到达
+  if ((int)entry.ports.size() == aggregation_expected_ports) {
+    LOG << "All " << aggregation_expected_ports
+        << " downstream ports ready for timestamp " << key.first << " seq "
+        << key.second << ", triggering aggregation" << endl;
+    performAggregation(entry);
+    aggregation_ready.push_back(key);
+  }
   return true;
 }
 
-bool Router::performAggregation() {
-  if (!aggregated_flit_queue.empty()) {
-    return false; // 队列中还有未转发的聚合flit,暂不聚合新的
-  }
-  // 创建聚合后的大flit
-  Flit aggregated_flit;
-
-  // 删除：不再合并dst_ids
-  // aggregated_flit.dst_ids.insert(
-  //     aggregated_flit.dst_ids.end(),
-  //     f.dst_ids.begin(),
-  //     f.dst_ids.end());
+void Router::performAggregation(AggregationEntry &entry) {
+  // 设置聚合flit的属性 (模板为第一个到达的 flit)
+  Flit &aggregated_flit = entry.aggregated;
 
-  // 设置聚合flit的属性
-  aggregated_flit = aggregation_entry.port_flits.begin()->second;
-  // aggregated_flit.payload_data_size *= aggregation_entry.expected_port_count;
-
-  if (routing_patterns.count(aggregated_flit.data_type) > 0) {
+  const RoutingPattern *pattern =
+      pattern_by_type[static_cast<int>(aggregated_flit.data_type)];
+  if (pattern) {
     aggregated_flit.payload_data_size =
-        routing_patterns[aggregated_flit.data_type].port_groups.size() *
-        aggregated_flit.payload_data_size;
+        pattern->port_groups.size() * aggregated_flit.payload_data_size;
   } else {
-    aggregated_flit.payload_data_size *= aggregation_entry.expected_port_count;
+    aggregated_flit.payload_data_size *= aggregation_expected_ports;
   }
 
   aggregated_flit.src_id = -1;
+  entry.complete = true;
+  entry.ports.clear();
+}
+
+// 最早完成的聚合 flit 是否可以参与仲裁。头 flit 在此路由并预留上游端口，
+// 预留一直保持到尾 flit 转发 (上一个包的尾 flit 之前不会轮到下一个头 flit)
+bool Router::aggregatedFlitReady() {
+  if (aggregation_ready.empty())
+    return false;
+
+  const Flit &aggregated_flit =
+      aggregation_table[aggregation_ready.front()].aggregated;
+  if (aggregated_flit.flit_type != FlitType::FLIT_TYPE_HEAD ||
+      !reservation_table.getReservations(-1, return_vc_id).empty())
+    return true;
 
-  // 路由并预留上游端口
-  if (aggregated_flit.flit_type != FlitType::FLIT_TYPE_HEAD) {
-    aggregated_flit_queue.push(aggregated_flit);
-    return true; // 只需要在头flit进行预留
-  }
   RouteData route_data;
   route_data.current_id = local_id;
-  // route_data.dst_ids = aggregated_flit.dst_ids; // 删除：不再使用dst_ids
   route_data.src_id = -1;
   route_data.dir_in = -2;
+  route_data.data_type = aggregated_flit.data_type;
   route_data.target_role = aggregated_flit.target_role;
   route_data.command = aggregated_flit.command;
 
-  vector<int> output_ports = route(route_data);
+  const vector<int> &output_ports = route(route_data);
 
   TReservation r;
   r.input = -1; // 特殊标记
   r.vc = return_vc_id;
 
-  int reservation_status = reservation_table.checkReservation(r, output_ports);
-  if (reservation_status == RT_AVAILABLE) {
-    reservation_table.reserve(r, output_ports);
-    aggregated_flit_queue.push(aggregated_flit);
-    // map<int, set<int>> output_to_dsts = buildOutputMapping(aggregated_flit,
-    // output_ports, -2); reservation_table.setOutputMapping(r.input, r.vc,
-    // output_to_dsts);
-
-    return true;
-  }
+  if (reservation_table.checkReservation(r, output_ports) != RT_AVAILABLE)
+    return false;
+  reservation_table.reserve(r, output_ports);
+  return true;
+}
 
-  return false;
+Flit Router::popAggregatedFlit() {
+  auto it = aggregation_table.find(aggregation_ready.front());
+  Flit flit = it->second.aggregated;
+  aggregation_table.erase(it);
+  aggregation_ready.pop_front();
+  power.bufferRouterPop();
+  return flit;
 }
+
 unsigned long Router::getRoutedFlits() { return routed_flits; }
 
 int Router::reflexDirection(int direction) const {
@@ -920,7 +953,7 @@ int Router::getNeighborId(int _id, int direction) const {
     my_coord.x--;
     break;
   default:
-    LOG << "Direction not valid : " << direction;
+    LOG << "Direction not valid : " << direction << endl;
     assert(false);
   }
 
@@ -930,7 +963,7 @@ int Router::getNeighborId(int _id, int direction) const {
 }
 
 void Router::ShowBuffersStats(std::ostream &out) {
-  for (size_t i = 0; i < all_flit_rx.size(); i++)
+  for (size_t i = 0; i < all_link_rx.size(); i++)
     for (int vc = 0; vc < GlobalParams::n_virtual_channels; vc++)
       (*buffers[i])[vc].ShowStats(out);
 }
@@ -961,6 +994,15 @@ Router::Router(sc_module_name nm) {
   sensitive << reset;
   sensitive << clock.neg();
 
+  allocator = nullptr;
+  tx_rounds = 1;
+  link_rx_storage = nullptr;
+  link_tx_storage = nullptr;
+  buffer_storage = nullptr;
+
+  // 未 configure 前不聚合、不做多播计数
+  tx_process_fn = &Router::txProcessPolicy<false, false>;
+
   SC_METHOD(txProcess);
   sensitive << reset;
   sensitive << clock.pos();
@@ -972,254 +1014,126 @@ Router::Router(sc_module_name nm) {
 }
 
 // Destructor implementation
-Router::~Router() { cleanupPorts(); }
+Router::~Router() {
+  cleanupPorts();
+  delete allocator;
+}
 
 // Initialize all dynamic ports based on hierarchical configuration
 void Router::initPorts() {
   // Initialize all pointers to nullptr
-  h_flit_rx_up = nullptr;
-  h_req_rx_up = nullptr;
-  h_ack_rx_up = nullptr;
-  h_buffer_full_status_rx_up = nullptr;
-
-  h_flit_tx_up = nullptr;
-  h_req_tx_up = nullptr;
-  h_ack_tx_up = nullptr;
-  h_buffer_full_status_tx_up = nullptr;
+  h_link_rx_up = nullptr;
+  h_link_tx_up = nullptr;
 
   for (int i = 0; i < NUM_LOCAL_PORTS; i++) {
-    h_flit_rx_local[i] = nullptr;
-    h_req_rx_local[i] = nullptr;
-    h_ack_rx_local[i] = nullptr;
-    h_buffer_full_status_rx_local[i] = nullptr;
-
-    h_flit_tx_local[i] = nullptr;
-    h_req_tx_local[i] = nullptr;
-    h_ack_tx_local[i] = nullptr;
-    h_buffer_full_status_tx_local[i] = nullptr;
+    h_link_rx_local[i] = nullptr;
+    h_link_tx_local[i] = nullptr;
   }
 
   // Clear DOWN port vectors
-  h_flit_tx_down.clear();
-  h_req_tx_down.clear();
-  h_ack_tx_down.clear();
-  h_buffer_full_status_tx_down.clear();
-
-  h_flit_rx_down.clear();
-  h_req_rx_down.clear();
-  h_ack_rx_down.clear();
-  h_buffer_full_status_rx_down.clear();
+  h_link_tx_down.clear();
+  h_link_rx_down.clear();
+  num_down_ports = 0;
+
+  link_rx_storage = nullptr;
+  link_tx_storage = nullptr;
+  buffer_storage = nullptr;
+}
+
+// 每个逻辑端口：一对 LinkChannel 端口 (每个方向一个)、buffer 和 VC 轮询起点。
+// 端口和 buffer 从 buildUnifiedInterface() 整块分配的数组中依次取用，端口名
+// 由 SystemC 生成，不再逐个拼接字符串
+void Router::addLinkPorts(LogicalPortType type, int instance) {
+  int k = all_link_rx.size();
+  LinkRxPort *link_rx = &link_rx_storage[k];
+  LinkTxPort *link_tx = &link_tx_storage[k];
+
+  if (type == PORT_UP) {
+    h_link_rx_up = link_rx;
+    h_link_tx_up = link_tx;
+  } else if (type == PORT_LOCAL) {
+    h_link_rx_local[instance] = link_rx;
+    h_link_tx_local[instance] = link_tx;
+  } else {
+    h_link_rx_down.push_back(link_rx);
+    h_link_tx_down.push_back(link_tx);
+  }
+
+  all_link_rx.push_back(link_rx);
+  all_link_tx.push_back(link_tx);
+
+  PortInfo info = {type, instance};
+  port_info_map.push_back(info);
+
+  buffers.push_back(&buffer_storage[k]);
+  start_from_vc.push_back(0);
 }
 
 // Build the unified interface adapter
 void Router::buildUnifiedInterface() {
-  // Clear all vectors
-  all_flit_rx.clear();
-  all_req_rx.clear();
-  all_ack_rx.clear();
-  all_buffer_full_status_rx.clear();
+  cleanupPorts();
 
-  all_flit_tx.clear();
-  all_req_tx.clear();
-  all_ack_tx.clear();
-  all_buffer_full_status_tx.clear();
+  // Clear all vectors
+  all_link_rx.clear();
+  all_link_tx.clear();
 
   buffers.clear();
   port_info_map.clear();
-  current_level_rx.clear();
-  current_level_tx.clear();
   start_from_vc.clear();
+  h_link_rx_down.clear();
+  h_link_tx_down.clear();
+
+  // LOCAL 端口数 (PRIMARY 始终存在，本层把某种数据类型映射到 SECONDARY
+  // 时再加一个) 和 DOWN 端口数 (本节点的子节点数)
+  num_local_ports = 1;
+  std::fill(local_port_of_type, local_port_of_type + NUM_DATA_TYPES, 0);
+  if (local_level < (int)GlobalParams::hierarchical_config.levels.size()) {
+    const LevelConfig &level_config =
+        GlobalParams::hierarchical_config.get_level_config(local_level);
+    num_local_ports = level_config.num_local_ports;
+    std::copy(level_config.local_port, level_config.local_port + NUM_DATA_TYPES,
+              local_port_of_type);
+  }
+  num_down_ports = 0;
+  if (local_level < GlobalParams::num_levels - 1) {
+    num_down_ports = GlobalParams::numChildren(local_id, local_level);
+  }
+
+  int num_ports = (local_level > 0 ? 1 : 0) + num_local_ports + num_down_ports;
+  link_rx_storage = new LinkRxPort[num_ports];
+  link_tx_storage = new LinkTxPort[num_ports];
+  buffer_storage = new BufferBank[num_ports];
+  all_link_rx.reserve(num_ports);
+  all_link_tx.reserve(num_ports);
+  buffers.reserve(num_ports);
+  port_info_map.reserve(num_ports);
+  start_from_vc.reserve(num_ports);
+  h_link_rx_down.reserve(num_down_ports);
+  h_link_tx_down.reserve(num_down_ports);
 
   // Define port order: UP -> LOCAL -> DOWN_0 -> DOWN_1 -> ...
 
   // 1. Add UP port (if this node is not root)
-  if (local_level > 0) {
-    cout << "function in " << local_id << endl;
-    std::string up_name = "ROUTER::UP_" + std::to_string(local_id);
-
-    // Create UP ports
-    h_flit_rx_up = new sc_in<Flit>((up_name + "_flit_rx").c_str());
-    h_req_rx_up = new sc_in<bool>((up_name + "_req_rx").c_str());
-    h_ack_rx_up = new sc_out<bool>((up_name + "_ack_rx").c_str());
-    h_buffer_full_status_rx_up =
-        new sc_out<TBufferFullStatus>((up_name + "_buffer_status_rx").c_str());
-
-    h_flit_tx_up = new sc_out<Flit>((up_name + "_flit_tx").c_str());
-    h_req_tx_up = new sc_out<bool>((up_name + "_req_tx").c_str());
-    h_ack_tx_up = new sc_in<bool>((up_name + "_ack_tx").c_str());
-    h_buffer_full_status_tx_up =
-        new sc_in<TBufferFullStatus>((up_name + "_buffer_status_tx").c_str());
-
-    // Add to unified interface
-    all_flit_rx.push_back(h_flit_rx_up);
-    all_req_rx.push_back(h_req_rx_up);
-    all_ack_rx.push_back(h_ack_rx_up);
-    all_buffer_full_status_rx.push_back(h_buffer_full_status_rx_up);
-
-    all_flit_tx.push_back(h_flit_tx_up);
-    all_req_tx.push_back(h_req_tx_up);
-    all_ack_tx.push_back(h_ack_tx_up);
-    all_buffer_full_status_tx.push_back(h_buffer_full_status_tx_up);
-
-    // Add port info
-    PortInfo up_info = {PORT_UP, -1, up_name};
-    port_info_map.push_back(up_info);
-
-    // Add buffer and state
-    buffers.push_back(new BufferBank());
-    current_level_rx.push_back(false);
-    current_level_tx.push_back(false);
-    start_from_vc.push_back(0);
-  }
+  if (local_level > 0)
+    addLinkPorts(PORT_UP, -1);
 
-  // 2. Add LOCAL ports (always present)
-  for (int i = 0; i < NUM_LOCAL_PORTS; i++) {
-    std::string local_name =
-        "ROUTER::LOCAL_" + std::to_string(local_id) + "_" + std::to_string(i);
-
-    // Create LOCAL ports
-    h_flit_rx_local[i] = new sc_in<Flit>((local_name + "_flit_rx").c_str());
-    h_req_rx_local[i] = new sc_in<bool>((local_name + "_req_rx").c_str());
-    h_ack_rx_local[i] = new sc_out<bool>((local_name + "_ack_rx").c_str());
-    h_buffer_full_status_rx_local[i] = new sc_out<TBufferFullStatus>(
-        (local_name + "_buffer_status_rx").c_str());
-
-    h_flit_tx_local[i] = new sc_out<Flit>((local_name + "_flit_tx").c_str());
-    h_req_tx_local[i] = new sc_out<bool>((local_name + "_req_tx").c_str());
-    h_ack_tx_local[i] = new sc_in<bool>((local_name + "_ack_tx").c_str());
-    h_buffer_full_status_tx_local[i] = new sc_in<TBufferFullStatus>(
-        (local_name + "_buffer_status_tx").c_str());
-
-    // Add to unified interface
-    all_flit_rx.push_back(h_flit_rx_local[i]);
-    all_req_rx.push_back(h_req_rx_local[i]);
-    all_ack_rx.push_back(h_ack_rx_local[i]);
-    all_buffer_full_status_rx.push_back(h_buffer_full_status_rx_local[i]);
-
-    all_flit_tx.push_back(h_flit_tx_local[i]);
-    all_req_tx.push_back(h_req_tx_local[i]);
-    all_ack_tx.push_back(h_ack_tx_local[i]);
-    all_buffer_full_status_tx.push_back(h_buffer_full_status_tx_local[i]);
-
-    // Add port info
-    PortInfo local_info = {PORT_LOCAL, i, local_name};
-    port_info_map.push_back(local_info);
-
-    // Add buffer and state
-    buffers.push_back(new BufferBank());
-    current_level_rx.push_back(false);
-    current_level_tx.push_back(false);
-    start_from_vc.push_back(0);
-  }
+  // 2. Add LOCAL ports
+  for (int i = 0; i < num_local_ports; i++)
+    addLinkPorts(PORT_LOCAL, i);
 
-  // 3. Add DOWN ports (based on fanout)
-  int fanout = 0;
-  if (local_level < GlobalParams::num_levels - 1) {
-    fanout = GlobalParams::fanouts_per_level[local_level];
-  }
-
-  for (int i = 0; i < fanout; i++) {
-    std::string down_name =
-        "DOWN_" + std::to_string(local_id) + "_" + std::to_string(i);
-
-    // Create DOWN ports
-    sc_out<Flit> *flit_tx = new sc_out<Flit>((down_name + "_flit_tx").c_str());
-    sc_out<bool> *req_tx = new sc_out<bool>((down_name + "_req_tx").c_str());
-    sc_in<bool> *ack_tx = new sc_in<bool>((down_name + "_ack_tx").c_str());
-    sc_in<TBufferFullStatus> *buffer_status_tx =
-        new sc_in<TBufferFullStatus>((down_name + "_buffer_status_tx").c_str());
-
-    h_flit_tx_down.push_back(flit_tx);
-    h_req_tx_down.push_back(req_tx);
-    h_ack_tx_down.push_back(ack_tx);
-    h_buffer_full_status_tx_down.push_back(buffer_status_tx);
-
-    sc_in<Flit> *flit_rx = new sc_in<Flit>((down_name + "_flit_rx").c_str());
-    sc_in<bool> *req_rx = new sc_in<bool>((down_name + "_req_rx").c_str());
-    sc_out<bool> *ack_rx = new sc_out<bool>((down_name + "_ack_rx").c_str());
-    sc_out<TBufferFullStatus> *buffer_status_rx = new sc_out<TBufferFullStatus>(
-        (down_name + "_buffer_status_rx").c_str());
-
-    h_flit_rx_down.push_back(flit_rx);
-    h_req_rx_down.push_back(req_rx);
-    h_ack_rx_down.push_back(ack_rx);
-    h_buffer_full_status_rx_down.push_back(buffer_status_rx);
-
-    // Add to unified interface
-    all_flit_rx.push_back(flit_rx);
-    all_req_rx.push_back(req_rx);
-    all_ack_rx.push_back(ack_rx);
-    all_buffer_full_status_rx.push_back(buffer_status_rx);
-
-    all_flit_tx.push_back(flit_tx);
-    all_req_tx.push_back(req_tx);
-    all_ack_tx.push_back(ack_tx);
-    all_buffer_full_status_tx.push_back(buffer_status_tx);
-
-    // Add port info
-    PortInfo down_info = {PORT_DOWN, i, down_name};
-    port_info_map.push_back(down_info);
-
-    buffers.push_back(new BufferBank());
-    current_level_rx.push_back(false);
-    current_level_tx.push_back(false);
-    start_from_vc.push_back(0);
-  }
+  // 3. Add DOWN ports (one per child of this node)
+  for (int i = 0; i < num_down_ports; i++)
+    addLinkPorts(PORT_DOWN, i);
 }
 
 // Cleanup all dynamically allocated ports
 void Router::cleanupPorts() {
-  // Clean up UP ports
-  if (h_flit_rx_up)
-    delete h_flit_rx_up;
-  if (h_req_rx_up)
-    delete h_req_rx_up;
-  if (h_ack_rx_up)
-    delete h_ack_rx_up;
-  if (h_buffer_full_status_rx_up)
-    delete h_buffer_full_status_rx_up;
-  if (h_flit_tx_up)
-    delete h_flit_tx_up;
-  if (h_req_tx_up)
-    delete h_req_tx_up;
-  if (h_ack_tx_up)
-    delete h_ack_tx_up;
-  if (h_buffer_full_status_tx_up)
-    delete h_buffer_full_status_tx_up;
-
-  for (int i = 0; i < NUM_LOCAL_PORTS; i++) {
-    delete h_flit_rx_local[i];
-    delete h_req_rx_local[i];
-    delete h_ack_rx_local[i];
-    delete h_buffer_full_status_rx_local[i];
-    delete h_flit_tx_local[i];
-    delete h_req_tx_local[i];
-    delete h_ack_tx_local[i];
-    delete h_buffer_full_status_tx_local[i];
-  }
-
-  // Clean up DOWN ports
-  for (auto port : h_flit_tx_down)
-    delete port;
-  for (auto port : h_req_tx_down)
-    delete port;
-  for (auto port : h_ack_tx_down)
-    delete port;
-  for (auto port : h_buffer_full_status_tx_down)
-    delete port;
-
-  for (auto port : h_flit_rx_down)
-    delete port;
-  for (auto port : h_req_rx_down)
-    delete port;
-  for (auto port : h_ack_rx_down)
-    delete port;
-  for (auto port : h_buffer_full_status_rx_down)
-    delete port;
-
-  // Clean up buffers
-  for (auto buffer : buffers)
-    delete buffer;
+  delete[] link_rx_storage;
+  delete[] link_tx_storage;
+  delete[] buffer_storage;
+  link_rx_storage = nullptr;
+  link_tx_storage = nullptr;
+  buffer_storage = nullptr;
 }
 
 int Router::getLogicalPortIndex(LogicalPortType type,
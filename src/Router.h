@@ -10,17 +10,21 @@
 
 #ifndef __NOXIMROUTER_H__
 #define __NOXIMROUTER_H__
-#define NUM_LOCAL_PORTS 1
 
+#include "Allocator.h"
 #include "Buffer.h"
 #include "DataStructs.h"
 #include "GlobalRoutingTable.h"
+#include "LinkChannel.h"
 #include "LocalRoutingTable.h"
 #include "ReservationTable.h"
 #include "Stats.h"
 #include "Utils.h"
+#include "VcArbiter.h"
 #include "routingAlgorithms/RoutingAlgorithm.h"
 #include "routingAlgorithms/RoutingAlgorithms.h"
+#include <deque>
+#include <set>
 #include <systemc.h>
 
 using namespace std;
@@ -34,38 +38,27 @@ SC_MODULE(Router) {
   sc_in<bool> reset; // The reset signal for the router
 
   // Hierarchical Dynamic Ports
-  // UP ports (parent connection)
-  sc_in<Flit> *h_flit_rx_up;
-  sc_in<bool> *h_req_rx_up;
-  sc_out<bool> *h_ack_rx_up;
-  sc_out<TBufferFullStatus> *h_buffer_full_status_rx_up;
+  // 所有端口都连接到 LinkChannel (一个方向一个 channel)
+  typedef sc_port<LinkRxIf> LinkRxPort;
+  typedef sc_port<LinkTxIf> LinkTxPort;
 
-  sc_out<Flit> *h_flit_tx_up;
-  sc_out<bool> *h_req_tx_up;
-  sc_in<bool> *h_ack_tx_up;
-  sc_in<TBufferFullStatus> *h_buffer_full_status_tx_up;
+  // UP ports (parent connection)
+  LinkRxPort *h_link_rx_up;
+  LinkTxPort *h_link_tx_up;
 
   // DOWN ports (child connections)
-  vector<sc_out<Flit> *> h_flit_tx_down;
-  vector<sc_out<bool> *> h_req_tx_down;
-  vector<sc_in<bool> *> h_ack_tx_down;
-  vector<sc_in<TBufferFullStatus> *> h_buffer_full_status_tx_down;
-
-  vector<sc_in<Flit> *> h_flit_rx_down;
-  vector<sc_in<bool> *> h_req_rx_down;
-  vector<sc_out<bool> *> h_ack_rx_down;
-  vector<sc_out<TBufferFullStatus> *> h_buffer_full_status_rx_down;
+  vector<LinkTxPort *> h_link_tx_down;
+  vector<LinkRxPort *> h_link_rx_down;
 
   // LOCAL ports (PE connection)
-  sc_in<Flit> *h_flit_rx_local[NUM_LOCAL_PORTS];
-  sc_in<bool> *h_req_rx_local[NUM_LOCAL_PORTS];
-  sc_out<bool> *h_ack_rx_local[NUM_LOCAL_PORTS];
-  sc_out<TBufferFullStatus> *h_buffer_full_status_rx_local[NUM_LOCAL_PORTS];
-
-  sc_out<Flit> *h_flit_tx_local[NUM_LOCAL_PORTS];
-  sc_out<bool> *h_req_tx_local[NUM_LOCAL_PORTS];
-  sc_in<bool> *h_ack_tx_local[NUM_LOCAL_PORTS];
-  sc_in<TBufferFullStatus> *h_buffer_full_status_tx_local[NUM_LOCAL_PORTS];
+  LinkRxPort *h_link_rx_local[NUM_LOCAL_PORTS];
+  LinkTxPort *h_link_tx_local[NUM_LOCAL_PORTS];
+  // 本层创建的 LOCAL 端口数 (LevelConfig::num_local_ports) 和每种数据类型
+  // 本地投递使用的端口，由 buildUnifiedInterface() 设置
+  int num_local_ports;
+  int local_port_of_type[NUM_DATA_TYPES];
+  // DOWN 端口数，等于本节点的子节点数 (各节点的 fanout 可以不同)
+  int num_down_ports;
 
   // Logical port type enumeration
   enum LogicalPortType { PORT_UP, PORT_LOCAL, PORT_DOWN };
@@ -73,24 +66,19 @@ SC_MODULE(Router) {
   struct PortInfo {
     LogicalPortType type;
     int instance_index;
-    std::string name;
   };
 
   // Unified Interface Adapter
-  vector<sc_in<Flit> *> all_flit_rx;
-  vector<sc_in<bool> *> all_req_rx;
-  vector<sc_out<bool> *> all_ack_rx;
-  vector<sc_out<TBufferFullStatus> *> all_buffer_full_status_rx;
-
-  vector<sc_out<Flit> *> all_flit_tx;
-  vector<sc_out<bool> *> all_req_tx;
-  vector<sc_in<bool> *> all_ack_tx;
-  vector<sc_in<TBufferFullStatus> *> all_buffer_full_status_tx;
+  // 所有向量按逻辑端口编号
+  vector<LinkRxPort *> all_link_rx;
+  vector<LinkTxPort *> all_link_tx;
 
   vector<BufferBank *> buffers;
+  // 上面的端口和 buffer 指向这三个按端口数整块分配的数组
+  LinkRxPort *link_rx_storage;
+  LinkTxPort *link_tx_storage;
+  BufferBank *buffer_storage;
   vector<PortInfo> port_info_map;
-  vector<bool> current_level_rx;
-  vector<bool> current_level_tx;
   vector<int> start_from_vc;
 
   // Registers
@@ -107,25 +95,64 @@ SC_MODULE(Router) {
   unsigned long routed_flits;
   RoutingAlgorithm *routingAlgorithm;
 
+  // 阶段B 的交换分配器 (GlobalParams::allocator)，状态按 router 独立保存
+  Allocator *allocator;
+  vector<AllocRequest> alloc_requests;
+  vector<int> alloc_grants;
+  WaitAges wait_ages; // 每个 (input, vc) 连续落选的周期数
+  int tx_rounds; // 每周期阶段B 的最大轮数 (最宽链路的 flit/周期)
+
+  // 同一输入端口各 VC 之间的仲裁 (本层 vc_arbitration)。ROUND_ROBIN 沿用
+  // start_from_vc 和分配器的轮询；其他策略下每个输入端口只把最优先的就绪
+  // VC (PRIORITY 下包括同优先级的 VC) 提交给分配器
+  vector<VcArbiter> vc_arbiters; // [input]
+  bool vc_arbitrated;
+
+  // 回送包聚合：同一位置 (logical_timestamp, sequence_no) 的 flit 在各下游
+  // 端口都到达后合成一个 flit。多个位置可以同时收集 (有界表，上限
+  // GlobalParams::aggregation_entries)，时间步 t+1 的收集与 t 的转发重叠
+  typedef pair<int, int> AggregationKey; // (logical_timestamp, sequence_no)
   struct AggregationEntry {
-    map<int, Flit> port_flits; // port_id -> flit
-    int payload_data_size;     // 所有flit必须相同
-    int flit_type;             // 所有flit必须相同(HEAD/BODY/TAIL)
-    int expected_port_count;   // 期望的下游端口数量
+    set<int> ports;        // 已到达的下游端口
+    int payload_data_size; // 所有flit必须相同
+    int flit_type;         // 所有flit必须相同(HEAD/BODY/TAIL)
+    bool complete;         // 所有端口已到达，aggregated 有效
+    Flit aggregated;       // 聚合后的 flit (第一个到达的 flit 为模板)
   };
-  AggregationEntry aggregation_entry; // 单个实例,不需要map
-  int return_vc_id;                   // 回送包使用的固定VC ID
-  queue<Flit> aggregated_flit_queue;
+  map<AggregationKey, AggregationEntry> aggregation_table;
+  deque<AggregationKey> aggregation_ready; // 已完成的条目，按完成顺序转发
+  int aggregation_expected_ports;          // 期望的下游端口数量
+  int return_vc_id;                        // 回送包使用的固定VC ID
   bool is_aggregation;
 
   std::map<DataType, RoutingPattern> routing_patterns;
   bool use_predefined_routing = false;
 
+  // 预编译的路由决策，configure() 末尾由 routing_patterns 生成。
+  // 下标 [data_type][is_return (command == -1)][target_role == role]
+  struct RouteDecision {
+    vector<int> output_ports;      // 展平后的输出端口，空表示无法路由
+    int forward_count;             // rxProcess 写入 flit 的值，-1 表示保持不变
+    const RoutingPattern *pattern; // port_groups 布局，无预定义路由时为 nullptr
+  };
+  RouteDecision route_decisions[NUM_DATA_TYPES][2][2];
+  const RoutingPattern *pattern_by_type[NUM_DATA_TYPES];
+
+  const RouteDecision &routeDecision(DataType data_type, int command,
+                                     PE_Role target_role) const {
+    return route_decisions[static_cast<int>(data_type)][command == -1]
+                          [target_role == role];
+  }
+
   // Functions
 
   void process();
   void rxProcess(); // The receiving process
   void txProcess(); // The transmitting process
+  // 按层级特化的 txProcess 主体，configure() 根据本层配置选择实例
+  template <bool AGGREGATE, bool MULTICAST> void txProcessPolicy();
+  typedef void (Router::*TxProcessFn)();
+  TxProcessFn tx_process_fn;
   void perCycleUpdate();
   void configure(const int _id, const int _level, const double _warm_up_time,
                  const unsigned int _max_buffer_size, GlobalRoutingTable &grt);
@@ -136,7 +163,9 @@ SC_MODULE(Router) {
   void initPorts();
   void buildUnifiedInterface();
   bool tryAggregation(int input_port, const Flit &flit);
-  bool performAggregation();
+  void performAggregation(AggregationEntry &entry);
+  bool aggregatedFlitReady();
+  Flit popAggregatedFlit();
   vector<vector<int>> getCurrentPortGroups(
       int forward_count, int current_forward,
       const vector<vector<int>> &all_groups);
@@ -150,6 +179,12 @@ private:
   // Dynamic port management
 
   void cleanupPorts();
+  void buildRouteDecisions();
+  void addLinkPorts(LogicalPortType type, int instance);
+  void acceptFlit(int input_port, Flit &flit);
+  bool outputReady(int output_port, int vc);
+  void sendFlit(int output_port, const Flit &flit);
+  void popFlit(int input_port, int vc);
 
   // Idle detection members
   bool has_tx_activity; // Current cycle TX activity flag
@@ -163,7 +198,7 @@ public:
 
 public:
   // performs actual routing + selection
-  vector<int> route(const RouteData &route_data);
+  const vector<int> &route(const RouteData &route_data);
 
 private:
   // wrappers
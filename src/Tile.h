@@ -15,8 +15,9 @@
 #include "Router.h"
 #include "ProcessingElement.h"
 #include "MockPE.h"
-#include "ProcessingElement.h"
+#include "ReplayPE.h"
 #include <dbg.h>
+#include <type_traits>
 using namespace std;
 
 SC_MODULE(Tile)
@@ -34,41 +35,23 @@ SC_MODULE(Tile)
 
 
     // Hierarchical ports for tree topology (dynamic vector-based)
+    // 每个方向一个 LinkChannel 端口，转接到 Router 的 h_link_* 端口
     // UP ports (connection to parent)
-    sc_in <Flit>* hierarchical_flit_up_rx;	        // UP方向输入 (from parent)
-    sc_in <bool>* hierarchical_req_up_rx;	        // UP方向请求输入
-    sc_out <bool>* hierarchical_ack_up_rx;	        // UP方向应答输出
-    sc_out <TBufferFullStatus>* hierarchical_buffer_full_status_up_rx;
-
-	sc_out <Flit>* hierarchical_flit_up_tx;	        // UP方向输出 (to parent)
-	sc_out <bool>* hierarchical_req_up_tx;	        // UP方向请求输出
-	sc_in <bool>* hierarchical_ack_up_tx;	        // UP方向应答输入
-	sc_in <TBufferFullStatus>* hierarchical_buffer_full_status_up_tx;
+    Router::LinkRxPort* hierarchical_link_up_rx;	// UP方向输入 (from parent)
+    Router::LinkTxPort* hierarchical_link_up_tx;	// UP方向输出 (to parent)
 
     // DOWN ports (connection to children) - dynamic vectors
-    std::vector<sc_out<Flit>*> hierarchical_flit_down_tx;     // DOWN方向输出 (to children)
-    std::vector<sc_out<bool>*> hierarchical_req_down_tx;      // DOWN方向请求输出
-    std::vector<sc_in<bool>*> hierarchical_ack_down_tx;       // DOWN方向应答输入
-    std::vector<sc_in<TBufferFullStatus>*> hierarchical_buffer_full_status_down_tx;
-
-	std::vector<sc_in<Flit>*> hierarchical_flit_down_rx;      // DOWN方向输入 (from children)
-	std::vector<sc_in<bool>*> hierarchical_req_down_rx;       // DOWN方向请求输入
-	std::vector<sc_out<bool>*> hierarchical_ack_down_rx;      // DOWN方向应答输出
-	std::vector<sc_out<TBufferFullStatus>*> hierarchical_buffer_full_status_down_rx;
-
-    // --- 链路 1: 数据从 PE 发往 Router (P2R) ---
-    sc_signal<Flit>**  sig_flit_p2r;
-    sc_signal<bool>**  sig_req_p2r;
-    // 反向信号: Router -> PE
-    sc_signal<bool>**  sig_ack_r2p;
-    sc_signal<TBufferFullStatus>** sig_stat_r2p;
-
-    // --- 链路 2: 数据从 Router 发往 PE (R2P) ---
-    sc_signal<Flit>**  sig_flit_r2p;
-    sc_signal<bool>**  sig_req_r2p;  
-    // 反向信号: PE -> Router
-    sc_signal<bool>**  sig_ack_p2r;  
-    sc_signal<TBufferFullStatus>** sig_stat_p2r;
+    std::vector<Router::LinkTxPort*> hierarchical_link_down_tx;	// DOWN方向输出 (to children)
+    std::vector<Router::LinkRxPort*> hierarchical_link_down_rx;	// DOWN方向输入 (from children)
+    Router::LinkTxPort* down_tx_storage;	// 上面两个 vector 指向的端口数组
+    Router::LinkRxPort* down_rx_storage;
+
+    // PE 与 Router 之间的 LOCAL 链路，宽度为本层带宽。只为本层用到的端口
+    // 在 local_link_storage 中就地构造，其余为 nullptr
+    LinkChannel* local_link_p2r[NUM_LOCAL_PORTS]; // 数据从 PE 发往 Router
+    LinkChannel* local_link_r2p[NUM_LOCAL_PORTS]; // 数据从 Router 发往 PE
+    std::aligned_storage<sizeof(LinkChannel), alignof(LinkChannel)>::type
+        local_link_storage[2 * NUM_LOCAL_PORTS];
 
     // Hierarchical port management
     void initHierarchicalPorts();  // 初始化层次化端口
@@ -80,31 +63,17 @@ SC_MODULE(Tile)
     ~Tile() {
         cleanupHierarchicalPorts();
         
-        // 清理二维指针数组
-        const int NUM_INTERNAL_CONNECTIONS = 1;
-        if (sig_flit_p2r) {
-            for (int i = 0; i < NUM_INTERNAL_CONNECTIONS; i++) {
-                delete sig_flit_p2r[i];
-                delete sig_req_p2r[i];
-                delete sig_ack_r2p[i];
-                delete sig_stat_r2p[i];
-                delete sig_flit_r2p[i];
-                delete sig_req_r2p[i];
-                delete sig_ack_p2r[i];
-                delete sig_stat_p2r[i];
+        for (int i = 0; i < NUM_LOCAL_PORTS; i++) {
+            if (local_link_p2r[i] != nullptr) {
+                local_link_p2r[i]->~LinkChannel();
+                local_link_r2p[i]->~LinkChannel();
             }
-            delete[] sig_flit_p2r;
-            delete[] sig_req_p2r;
-            delete[] sig_ack_r2p;
-            delete[] sig_stat_r2p;
-            delete[] sig_flit_r2p;
-            delete[] sig_req_r2p;
-            delete[] sig_ack_p2r;
-            delete[] sig_stat_p2r;
         }
-        
-        delete r;
-        delete pe;
+
+        if (pe != nullptr)
+            pe->~ProcessingElement();
+        if (replay_pe != nullptr)
+            replay_pe->~ReplayPE();
     }
 
     // Signals required for Router-PE connection (Primary - LOCAL)
@@ -133,14 +102,32 @@ SC_MODULE(Tile)
 
 
 
-    Router *r;		                // Router instance
+    // Router 是 Tile 的成员，PE 与 ReplayPE 只构造一个，就地放在 pe_storage
+    // 中：每个节点不再为子模块单独分配堆内存
+    Router router;
+    union PeStorage {
+        std::aligned_storage<sizeof(ProcessingElement), alignof(ProcessingElement)>::type pe;
+        std::aligned_storage<sizeof(ReplayPE), alignof(ReplayPE)>::type replay_pe;
+    } pe_storage;
+
+    Router *r;		                // Router instance (指向 router)
     ProcessingElement *pe;	                // Processing Element instance
+    ReplayPE *replay_pe;	                // 回放模式下替代 pe (此时 pe 为 nullptr)
 	    GlobalRoutingTable grtable;
 
 
 // 在 Tile.cpp 中
 Tile(sc_module_name nm, int id, int level);
 
+    // PE 与 ReplayPE 端口名一致，共用同一套本地端口绑定
+    template <typename PE_T>
+    void bindLocalPorts(PE_T *p, int i) {
+        // PE --> Router
+        p->link_tx[i].bind(*local_link_p2r[i]);
+        // Router --> PE
+        p->link_rx[i].bind(*local_link_r2p[i]);
+    }
+
 
 
 
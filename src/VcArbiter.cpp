@@ -0,0 +1,58 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the implementation of the virtual channel arbiter
+ */
+
+#include "VcArbiter.h"
+
+#include <algorithm>
+
+VcArbiter::VcArbiter()
+    : arb_policy(VC_ARB_ROUND_ROBIN), n_vcs(0), current(0), turn_flits(0) {}
+
+void VcArbiter::configure(VcArbitration policy, const vector<int> &weights,
+                          int _n_vcs) {
+  arb_policy = policy;
+  n_vcs = _n_vcs;
+  weight.assign(n_vcs, 1);
+  for (int vc = 0; vc < n_vcs && vc < (int)weights.size(); vc++)
+    weight[vc] = weights[vc];
+  reset();
+}
+
+void VcArbiter::reset() {
+  current = 0;
+  turn_flits = 0;
+  rebuild();
+}
+
+void VcArbiter::served(int vc) {
+  if (arb_policy == VC_ARB_WEIGHTED) {
+    // 持有轮次的 VC 无法发送时轮次转给实际发送的 VC
+    if (vc != current) {
+      current = vc;
+      turn_flits = 0;
+    }
+    if (++turn_flits < weight[vc])
+      return; // 顺序不变
+    turn_flits = 0;
+  }
+  current = (vc + 1) % n_vcs;
+  rebuild();
+}
+
+// 从 current 开始轮询；PRIORITY 再按优先级稳定排序，同优先级保持轮询顺序
+void VcArbiter::rebuild() {
+  vc_order.resize(n_vcs);
+  for (int k = 0; k < n_vcs; k++)
+    vc_order[k] = (current + k) % n_vcs;
+
+  if (arb_policy == VC_ARB_PRIORITY)
+    std::stable_sort(vc_order.begin(), vc_order.end(),
+                     [this](int a, int b) { return weight[a] > weight[b]; });
+}
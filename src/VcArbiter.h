@@ -0,0 +1,59 @@
+/*
+ * Noxim - the NoC Simulator
+ *
+ * (C) 2005-2018 by the University of Catania
+ * For the complete list of authors refer to file ../doc/AUTHORS.txt
+ * For the license applied to these sources refer to file ../doc/LICENSE.txt
+ *
+ * This file contains the declaration of the virtual channel arbiter that
+ * decides in which order the VCs of a PE or of a router input are served
+ * (LevelConfig::vc_arbitration):
+ *  - ROUND_ROBIN: the turn moves past a VC after every served flit
+ *  - WEIGHTED:    a VC keeps the turn for up to weight[vc] flits
+ *  - PRIORITY:    the VC with the highest weight[vc] is always tried first,
+ *                 VCs of equal priority are served round robin
+ * A VC that cannot send is skipped, so every policy is work conserving.
+ */
+
+#ifndef __NOXIMVCARBITER_H__
+#define __NOXIMVCARBITER_H__
+
+#include <vector>
+
+#include "DataTypes.h"
+
+using namespace std;
+
+class VcArbiter {
+public:
+  VcArbiter();
+
+  // weights[vc] 缺省为 1
+  void configure(VcArbitration policy, const vector<int> &weights, int n_vcs);
+  void reset();
+
+  VcArbitration policy() const { return arb_policy; }
+
+  // 本次仲裁依次尝试的 n_vcs 个 VC，在下一次 served() 之前有效
+  const int *order() const { return vc_order.data(); }
+
+  // vc 发送了一个 flit
+  void served(int vc);
+
+  // 两个 VC 是否同等优先 (只有 PRIORITY 下相同优先级的 VC 才同等)
+  bool sameClass(int a, int b) const {
+    return arb_policy == VC_ARB_PRIORITY && weight[a] == weight[b];
+  }
+
+private:
+  VcArbitration arb_policy;
+  int n_vcs;
+  vector<int> weight;
+  vector<int> vc_order;
+  int current;     // 持有轮次的 VC (ROUND_ROBIN/PRIORITY 为轮询起点)
+  int turn_flits;  // WEIGHTED: current 在本轮已发送的 flit 数
+
+  void rebuild();
+};
+
+#endif
@@ -1,166 +1,356 @@
 #include "BufferManager.h"
-#include <stdexcept>
 #include <algorithm>
+#include <limits>
 
-// 共享模式构造函数
-BufferManager::BufferManager(size_t capacity)
-    : mode_(BufferMode::SHARED),
-      capacity_(capacity),
-      current_size_(0)
+// --- tile 替换策略 ---
+
+bool ParseTileReplacementPolicy(const std::string &name, TileReplacementPolicy &policy)
 {
-    // 初始化所有数据类型的大小为0
-    internal_buffer_sizes_[DataType::INPUT] = 0;
-    internal_buffer_sizes_[DataType::WEIGHT] = 0;
-    internal_buffer_sizes_[DataType::OUTPUT] = 0;
+    if (name == "LRU")
+        policy = TileReplacementPolicy::LRU;
+    else if (name == "BELADY")
+        policy = TileReplacementPolicy::BELADY;
+    else if (name == "LIVENESS")
+        policy = TileReplacementPolicy::LIVENESS;
+    else
+        return false;
+    return true;
 }
 
-// 独立模式构造函数
-BufferManager::BufferManager(const std::map<DataType, size_t> &type_capacities)
-    : mode_(BufferMode::INDEPENDENT),
-      capacity_(0), // 独立模式下不使用总容量
-      current_size_(0),
-      type_capacities_(type_capacities)
+const char *TileReplacementPolicy_to_str(TileReplacementPolicy policy)
 {
-    // 初始化所有数据类型的大小为0
-    internal_buffer_sizes_[DataType::INPUT] = 0;
-    internal_buffer_sizes_[DataType::WEIGHT] = 0;
-    internal_buffer_sizes_[DataType::OUTPUT] = 0;
+    switch (policy)
+    {
+    case TileReplacementPolicy::BELADY:
+        return "BELADY";
+    case TileReplacementPolicy::LIVENESS:
+        return "LIVENESS";
+    default:
+        return "LRU";
+    }
 }
 
-// --- 查询接口实现 ---
+void TileTimeline::AddUse(const TileKey &tile, int timestep)
+{
+    std::vector<int> &uses = uses_[tile];
+    if (uses.empty() || uses.back() < timestep)
+        uses.push_back(timestep);
+}
 
-size_t BufferManager::GetCapacity(DataType type) const
+int TileTimeline::NextUse(const TileKey &tile, int timestep) const
 {
-    if (mode_ == BufferMode::SHARED || type == DataType::UNKNOWN)
-    {
-        return capacity_;
-    }
-    else
-    {
-        auto it = type_capacities_.find(type);
-        return (it != type_capacities_.end()) ? it->second : 0;
-    }
+    auto it = uses_.find(tile);
+    if (it == uses_.end())
+        return NEVER;
+    auto next = std::upper_bound(it->second.begin(), it->second.end(), timestep);
+    return next == it->second.end() ? NEVER : *next;
 }
 
-size_t BufferManager::GetCurrentSize(DataType type) const
+TileStats &TileStats::operator+=(const TileStats &other)
 {
-    if (type == DataType::UNKNOWN)
+    hits += other.hits;
+    misses += other.misses;
+    hit_bytes += other.hit_bytes;
+    miss_bytes += other.miss_bytes;
+    evictions += other.evictions;
+    evicted_bytes += other.evicted_bytes;
+    bypasses += other.bypasses;
+    return *this;
+}
+
+BankStats &BankStats::operator+=(const BankStats &other)
+{
+    swaps += other.swaps;
+    received_bytes += other.received_bytes;
+    overlapped_bytes += other.overlapped_bytes;
+    return *this;
+}
+
+bool PrefetchFits(BufferMode mode, const size_t capacity[NUM_DATA_TYPES],
+                  const size_t resident[NUM_DATA_TYPES],
+                  const size_t ahead[NUM_DATA_TYPES])
+{
+    if (mode == BufferMode::INDEPENDENT)
     {
-        return current_size_;
+        for (int i = 0; i < NUM_DATA_TYPES; i++)
+        {
+            if (ahead[i] > capacity[i] - std::min(capacity[i], resident[i]))
+                return false;
+        }
+        return true;
     }
-    else
+
+    size_t total_resident = 0;
+    size_t total_ahead = 0;
+    for (int i = 0; i < NUM_DATA_TYPES; i++)
     {
-        auto it = internal_buffer_sizes_.find(type);
-        return (it != internal_buffer_sizes_.end()) ? it->second : 0;
+        total_resident += resident[i];
+        total_ahead += ahead[i];
     }
+    return total_ahead <= capacity[0] - std::min(capacity[0], total_resident);
 }
 
-bool BufferManager::IsFull(DataType type) const
+// 共享模式构造函数
+BufferManager::BufferManager(size_t capacity)
+    : mode_(BufferMode::SHARED),
+      capacity_(capacity),
+      tile_tracking_(false),
+      tile_policy_(TileReplacementPolicy::LRU),
+      tile_timeline_(nullptr),
+      tile_tick_(0),
+      double_buffered_(false),
+      bank_busy_(false)
 {
-    if (mode_ == BufferMode::SHARED || type == DataType::UNKNOWN)
-    {
-        return current_size_ >= capacity_;
-    }
-    else
+    BuildChecks(std::map<DataType, size_t>());
+}
+
+// 独立模式构造函数
+BufferManager::BufferManager(const std::map<DataType, size_t> &type_capacities)
+    : mode_(BufferMode::INDEPENDENT),
+      capacity_(0), // 独立模式下不使用总容量
+      tile_tracking_(false),
+      tile_policy_(TileReplacementPolicy::LRU),
+      tile_timeline_(nullptr),
+      tile_tick_(0),
+      double_buffered_(false),
+      bank_busy_(false)
+{
+    BuildChecks(type_capacities);
+}
+
+void BufferManager::BuildChecks(const std::map<DataType, size_t> &type_capacities)
+{
+    // 初始化所有数据类型的大小为0
+    std::fill(std::begin(used_), std::end(used_), 0);
+    std::fill(std::begin(tile_used_), std::end(tile_used_), 0);
+    std::fill(std::begin(fill_used_), std::end(fill_used_), 0);
+
+    for (int i = 0; i < NUM_DATA_TYPES; i++)
     {
-        auto capacity_it = type_capacities_.find(type);
-        auto size_it = internal_buffer_sizes_.find(type);
-        if (capacity_it != type_capacities_.end() && size_it != internal_buffer_sizes_.end())
+        DataType type = static_cast<DataType>(i);
+        if (mode_ == BufferMode::SHARED)
         {
-            return size_it->second >= capacity_it->second;
+            // 共享模式：所有类型都检查总容量
+            capacities_[i] = capacity_;
+            accept_check_[i] = {TOTAL, capacity_};
+            full_check_[i] = {TOTAL, capacity_};
+            continue;
         }
-        return false;
+
+        // 独立模式：检查该类型的独立容量，未配置的类型容量为0 (永不满载)
+        auto it = type_capacities.find(type);
+        size_t limit = (it != type_capacities.end()) ? it->second : 0;
+        capacities_[i] = limit;
+        accept_check_[i] = {i, limit};
+        full_check_[i] = {i, it != type_capacities.end()
+                                 ? limit
+                                 : std::numeric_limits<size_t>::max()};
     }
+
+    // UNKNOWN 表示整个缓冲区
+    capacities_[Index(DataType::UNKNOWN)] = capacity_;
+    full_check_[Index(DataType::UNKNOWN)] = {TOTAL, capacity_};
 }
 
-size_t BufferManager::GetDataSize(DataType type) const
+// --- 核心功能实现 ---
+
+bool BufferManager::OnDataReceived(DataType type, size_t size_added)
 {
-    try
+    int i = Index(type);
+    const Check &c = accept_check_[i];
+    if (used_[c.slot] + size_added > c.limit)
     {
-        return internal_buffer_sizes_.at(type);
+        return false;
     }
-    catch (const std::out_of_range &oor)
+
+    // 更新状态
+    used_[i] += size_added;
+    used_[TOTAL] += size_added;
+
+    if (double_buffered_)
     {
-        return 0;
+        bank_stats_.received_bytes += size_added;
+        if (bank_busy_)
+        {
+            fill_used_[i] += size_added;
+            fill_used_[TOTAL] += size_added;
+            bank_stats_.overlapped_bytes += size_added;
+        }
     }
+    return true;
 }
 
-// --- 核心功能实现 ---
+size_t BufferManager::evict_data(DataType type, size_t size_to_evict)
+{
+    int i = Index(type);
+    const size_t actual_evicted_size = std::min(size_to_evict, used_[i]);
 
-bool BufferManager::OnDataReceived(DataType type, size_t size_added)
+    used_[i] -= actual_evicted_size;
+    used_[TOTAL] -= actual_evicted_size;
+    clamp_fill_bank(i);
+
+    return actual_evicted_size;
+}
+
+bool BufferManager::AreDataTypesReady(const std::vector<DataType> &required_types, size_t size) const
 {
-    if (mode_ == BufferMode::SHARED)
+    for (const DataType &type : required_types)
     {
-        // 共享模式：检查总容量
-        if (current_size_ + size_added > capacity_)
+        if (used_[Index(type)] < size)
         {
             return false;
         }
     }
-    else
-    {
-        // 独立模式：检查该类型的独立容量
-        size_t limit = 0;
-        auto it = type_capacities_.find(type);
-        if (it != type_capacities_.end())
-        {
-            limit = it->second;
-        }
+    return true;
+}
 
-        if (internal_buffer_sizes_[type] + size_added > limit)
-        {
-            return false;
-        }
+bool BufferManager::RemoveData(DataType type, size_t size)
+{
+    int i = Index(type);
+    if (used_[TOTAL] < size || used_[i] < size)
+    {
+        return false;
     }
 
-    // 更新状态
-    internal_buffer_sizes_[type] += size_added;
-    current_size_ += size_added;
+    used_[TOTAL] -= size;
+    used_[i] -= size;
+    clamp_fill_bank(i);
+
     return true;
 }
 
-size_t BufferManager::evict_data(DataType type, size_t size_to_evict)
+// --- 双缓冲 ---
+
+void BufferManager::EnableDoubleBuffering()
 {
-    if (size_to_evict == 0)
+    if (double_buffered_)
+        return;
+    double_buffered_ = true;
+    bank_busy_ = false;
+    bank_stats_ = BankStats();
+
+    // 物理容量为两个 bank；写入哪个 bank 由 CanAccept 按 bank 容量判断
+    for (int i = 0; i < NUM_DATA_TYPES; i++)
     {
-        return 0;
+        size_t limit = accept_check_[i].limit;
+        accept_check_[i].limit =
+            limit > std::numeric_limits<size_t>::max() / 2
+                ? std::numeric_limits<size_t>::max()
+                : limit * 2;
     }
+}
+
+void BufferManager::ReleaseBank()
+{
+    if (!bank_busy_)
+        return;
+    // 另一个 bank 中的数据成为下一次消费的数据
+    bank_busy_ = false;
+    std::fill(std::begin(fill_used_), std::end(fill_used_), 0);
+    bank_stats_.swaps++;
+}
 
-    const size_t current_data_size = internal_buffer_sizes_.at(type);
-    const size_t actual_evicted_size = std::min(size_to_evict, current_data_size);
+void BufferManager::clamp_fill_bank(int i)
+{
+    // 驱逐的数据先从当前 bank 扣除，超出部分才属于另一个 bank
+    fill_used_[i] = std::min(fill_used_[i], used_[i]);
+    fill_used_[TOTAL] = std::min(fill_used_[TOTAL], used_[TOTAL]);
+}
 
-    internal_buffer_sizes_[type] -= actual_evicted_size;
-    current_size_ -= actual_evicted_size;
+// --- 驻留 tile 跟踪 ---
 
-    return actual_evicted_size;
+void BufferManager::EnableTileTracking(TileReplacementPolicy policy, const TileTimeline *timeline)
+{
+    tile_tracking_ = true;
+    tile_policy_ = policy;
+    tile_timeline_ = timeline;
+    tiles_.clear();
+    std::fill(std::begin(tile_used_), std::end(tile_used_), 0);
+    tile_tick_ = 0;
+    tile_stats_ = TileStats();
 }
 
-bool BufferManager::AreDataTypesReady(const std::vector<DataType> &required_types, size_t size) const
+std::map<TileKey, BufferManager::ResidentTile>::iterator
+BufferManager::select_victim(const TileKey &tile, int timestep)
 {
-    for (const DataType &type : required_types)
+    auto victim = tiles_.end();
+    int victim_next = 0;
+    bool use_timeline = tile_timeline_ != nullptr && tile_policy_ != TileReplacementPolicy::LRU;
+
+    for (auto it = tiles_.begin(); it != tiles_.end(); ++it)
     {
-        if (GetDataSize(type) < size)
+        // 独立模式下只能驱逐同类型的 tile；本时间步访问过的 tile 属于当前工作集
+        if (mode_ == BufferMode::INDEPENDENT && it->first.type != tile.type)
+            continue;
+        if (it->second.last_timestep == timestep)
+            continue;
+
+        int next = use_timeline ? tile_timeline_->NextUse(it->first, timestep) : 0;
+        if (tile_policy_ == TileReplacementPolicy::LIVENESS)
+            next = (next == TileTimeline::NEVER) ? 1 : 0; // 死 tile 优先
+
+        bool better;
+        if (victim == tiles_.end())
+            better = true;
+        else if (next != victim_next)
+            better = next > victim_next;
+        else
+            better = it->second.last_tick < victim->second.last_tick;
+
+        if (better)
         {
-            return false;
+            victim = it;
+            victim_next = next;
         }
     }
-    return true;
+    return victim;
 }
 
-bool BufferManager::AreDataTypeReady(const DataType &required_types, size_t size) const
+bool BufferManager::ReferenceTile(const TileKey &tile, size_t size, int timestep)
 {
-    return GetDataSize(required_types) >= size;
-}
+    auto it = tiles_.find(tile);
+    if (it != tiles_.end())
+    {
+        it->second.last_timestep = timestep;
+        it->second.last_tick = ++tile_tick_;
+        tile_stats_.hits++;
+        tile_stats_.hit_bytes += size;
+        return true;
+    }
 
-bool BufferManager::RemoveData(DataType type, size_t size)
-{
-    if (current_size_ < size || internal_buffer_sizes_[type] < size)
+    tile_stats_.misses++;
+    tile_stats_.miss_bytes += size;
+
+    // 腾出空间，容量检查与 OnDataReceived 相同
+    int i = Index(tile.type);
+    const Check &c = accept_check_[i];
+    if (size > c.limit)
     {
+        tile_stats_.bypasses++;
         return false;
     }
+    while (tile_used_[c.slot] + size > c.limit)
+    {
+        auto victim = select_victim(tile, timestep);
+        if (victim == tiles_.end())
+        {
+            tile_stats_.bypasses++;
+            return false;
+        }
+        size_t victim_size = victim->second.size;
+        tile_used_[Index(victim->first.type)] -= victim_size;
+        tile_used_[TOTAL] -= victim_size;
+        tile_stats_.evictions++;
+        tile_stats_.evicted_bytes += victim_size;
+        tiles_.erase(victim);
+    }
 
-    current_size_ -= size;
-    internal_buffer_sizes_[type] -= size;
-
-    return true;
-}
\ No newline at end of file
+    ResidentTile resident;
+    resident.size = size;
+    resident.last_timestep = timestep;
+    resident.last_tick = ++tile_tick_;
+    tiles_[tile] = resident;
+    tile_used_[i] += size;
+    tile_used_[TOTAL] += size;
+    return false;
+}
@@ -3,8 +3,11 @@
 
 #include <vector>
 #include <map>
+#include <string>
+#include <climits>   // for INT_MAX
 #include <cstddef>   // for size_t
 #include <algorithm> // for std::min
+#include <iterator>  // for std::begin
 #include "../DataStructs.h"
 
 /**
@@ -14,6 +17,18 @@
  * 支持模式：
  * 1. SHARED: 所有数据类型共享总容量（DRAM/GLB）
  * 2. INDEPENDENT: 每种数据类型有独立容量（PE）
+ *
+ * 所有计数保存在以 DataType 为下标的定长数组中。模式在构造时展开成每种
+ * 类型的检查表 (比较哪个计数、上限是多少)，查询和收发路径上没有 map
+ * 查找、分配或按模式的分支。
+ *
+ * 另外可以跟踪驻留的数据 tile (数据空间 + tile 编号，由调度推导)：每次访问
+ * 记为命中或缺失，缺失的 tile 按替换策略腾出空间后装入。该模型只用于统计
+ * (缺失字节即需要从上一层重新取回的数据量)，不改变上面的字节记账。
+ *
+ * 双缓冲 (ping-pong) 模式下配置的容量是一个 bank 的容量，另外再提供一个同样
+ * 大小的 bank：消费者 (计算或分发) 占用当前 bank 期间，下一时间步的数据写入
+ * 另一个 bank，只受该 bank 容量的限制；消费者释放后两个 bank 交换角色。
  */
 
 // --- 核心类型定义 ---
@@ -27,6 +42,104 @@ enum class BufferMode
     INDEPENDENT // PE: 每种数据类型有独立容量
 };
 
+/**
+ * @brief tile 替换策略
+ */
+enum class TileReplacementPolicy
+{
+    LRU,     // 最久未访问的 tile
+    BELADY,  // 下一次访问最远的 tile (按调度时间线，最优替换)
+    LIVENESS // 先驱逐不会再被访问的 (死) tile，其余按 LRU
+};
+
+bool ParseTileReplacementPolicy(const std::string &name, TileReplacementPolicy &policy);
+const char *TileReplacementPolicy_to_str(TileReplacementPolicy policy);
+
+/**
+ * @brief 数据 tile 的标识：数据空间 + 该空间内的 tile 编号
+ */
+struct TileKey
+{
+    DataType type;
+    int index;
+
+    TileKey() : type(DataType::UNKNOWN), index(-1) {}
+    TileKey(DataType t, int i) : type(t), index(i) {}
+
+    bool operator<(const TileKey &other) const
+    {
+        return type != other.type ? type < other.type : index < other.index;
+    }
+};
+
+/**
+ * @brief tile 的访问时间线 (每个 tile 被访问的时间步)，供 BELADY/LIVENESS 查询
+ */
+class TileTimeline
+{
+public:
+    static const int NEVER = INT_MAX;
+
+    // 时间步必须按升序添加
+    void AddUse(const TileKey &tile, int timestep);
+
+    // timestep 之后 (不含) 的下一次访问，没有则返回 NEVER
+    int NextUse(const TileKey &tile, int timestep) const;
+
+    void Clear() { uses_.clear(); }
+
+private:
+    std::map<TileKey, std::vector<int>> uses_;
+};
+
+/**
+ * @brief tile 访问统计
+ */
+struct TileStats
+{
+    size_t hits;
+    size_t misses;
+    size_t hit_bytes;
+    size_t miss_bytes;    // 需要从上一层重新取回的字节数
+    size_t evictions;
+    size_t evicted_bytes;
+    size_t bypasses;      // 放不下而未装入的 tile
+
+    TileStats()
+        : hits(0), misses(0), hit_bytes(0), miss_bytes(0), evictions(0),
+          evicted_bytes(0), bypasses(0) {}
+
+    TileStats &operator+=(const TileStats &other);
+};
+
+/**
+ * @brief 双缓冲统计
+ */
+struct BankStats
+{
+    size_t swaps;            // 消费者释放 bank 的次数
+    size_t received_bytes;   // 收到的总字节数
+    size_t overlapped_bytes; // 消费者占用 bank 期间写入另一个 bank 的字节数
+
+    BankStats() : swaps(0), received_bytes(0), overlapped_bytes(0) {}
+
+    BankStats &operator+=(const BankStats &other);
+};
+
+/**
+ * @brief 目标缓冲区除去常驻数据后能否再容纳向前预取的数据
+ * @param mode 目标缓冲区的模式
+ * @param capacity 各类型的容量 (共享模式下每项都是总容量)
+ * @param resident 各类型常驻的字节数
+ * @param ahead 各类型向前预取的字节数
+ *
+ * 独立模式逐类型比较；共享模式下所有类型共用一个容量，预取的合计与总容量
+ * 减去全部常驻数据比较。
+ */
+bool PrefetchFits(BufferMode mode, const size_t capacity[NUM_DATA_TYPES],
+                  const size_t resident[NUM_DATA_TYPES],
+                  const size_t ahead[NUM_DATA_TYPES]);
+
 // --- 智能Buffer模块 ---
 
 class BufferManager
@@ -44,7 +157,10 @@ public:
      * @brief 检查一组必需的数据类型当前是否都存在于缓冲区中。
      */
     bool AreDataTypesReady(const std::vector<DataType> &required_types, size_t size) const;
-    bool AreDataTypeReady(const DataType &required_types, size_t size) const;
+    bool AreDataTypeReady(const DataType &required_types, size_t size) const
+    {
+        return used_[Index(required_types)] >= size;
+    }
     bool RemoveData(DataType type, size_t size);
 
     /**
@@ -52,33 +168,162 @@ public:
      * @param type 数据类型，仅在INDEPENDENT模式下有效
      * @return 共享模式返回总容量，独立模式返回特定类型容量
      */
-    size_t GetCapacity(DataType type = DataType::UNKNOWN) const;
+    size_t GetCapacity(DataType type = DataType::UNKNOWN) const
+    {
+        return capacities_[Index(type)];
+    }
 
     /**
      * @brief 获取当前使用量
      * @param type 数据类型，UNKNOWN表示总使用量
      */
-    size_t GetCurrentSize(DataType type = DataType::UNKNOWN) const;
+    size_t GetCurrentSize(DataType type = DataType::UNKNOWN) const
+    {
+        return used_[type == DataType::UNKNOWN ? TOTAL : Index(type)];
+    }
 
-    size_t GetDataSize(DataType type) const;
+    size_t GetDataSize(DataType type) const { return used_[Index(type)]; }
 
     /**
      * @brief 检查缓冲区是否满载
      * @param type 数据类型，仅在INDEPENDENT模式下有效
      */
-    bool IsFull(DataType type = DataType::UNKNOWN) const;
+    bool IsFull(DataType type = DataType::UNKNOWN) const
+    {
+        const Check &c = full_check_[Index(type)];
+        return used_[c.slot] >= c.limit;
+    }
+
+    // --- 驻留 tile 跟踪 ---
+
+    /**
+     * @brief 启用 tile 跟踪
+     * @param timeline 访问时间线，为 nullptr 时 BELADY/LIVENESS 退化为 LRU
+     */
+    void EnableTileTracking(TileReplacementPolicy policy, const TileTimeline *timeline);
+    bool IsTileTrackingEnabled() const { return tile_tracking_; }
+
+    /**
+     * @brief 在 timestep 访问一个 tile
+     * @return 命中返回 true；缺失时装入 (必要时驱逐)，返回 false
+     */
+    bool ReferenceTile(const TileKey &tile, size_t size, int timestep);
+
+    bool IsTileResident(const TileKey &tile) const { return tiles_.count(tile) > 0; }
+    size_t GetResidentTileBytes(DataType type = DataType::UNKNOWN) const
+    {
+        return tile_used_[type == DataType::UNKNOWN ? TOTAL : Index(type)];
+    }
+    const TileStats &GetTileStats() const { return tile_stats_; }
+
+    // --- 双缓冲 (ping-pong) ---
+
+    /**
+     * @brief 启用双缓冲，在已配置的容量之外再提供一个同样大小的 bank
+     */
+    void EnableDoubleBuffering();
+    bool IsDoubleBuffered() const { return double_buffered_; }
+
+    /**
+     * @brief size 字节能否写入当前接收数据的 bank
+     * @param size 调用方应包含已经预留的在途字节
+     *
+     * 单缓冲或消费者空闲时与整个缓冲区比较；消费者占用 bank 时只与另一个
+     * bank 中已写入的数据比较。
+     */
+    bool CanAccept(DataType type, size_t size) const
+    {
+        int i = Index(type);
+        const size_t *used = bank_busy_ ? fill_used_ : used_;
+        return used[accept_check_[i].slot] + size <= capacities_[i];
+    }
+
+    /**
+     * @brief 按类型给出在途字节时，type 的数据能否写入
+     * @param pending 各类型已经预留的在途字节 (包括这次写入)
+     *
+     * 独立模式下只计 type 自己的在途字节；共享模式下所有类型共用一个容量，
+     * 计全部在途字节。
+     */
+    bool CanAcceptPending(DataType type,
+                          const size_t pending[NUM_DATA_TYPES]) const
+    {
+        int i = Index(type);
+        if (accept_check_[i].slot != TOTAL)
+            return CanAccept(type, pending[i]);
+        size_t size = 0;
+        for (int k = 0; k < NUM_DATA_TYPES; k++)
+            size += pending[k];
+        return CanAccept(type, size);
+    }
+
+    // 消费者开始使用当前数据 / 使用完毕 (在驱逐本时间步的数据之后调用)。
+    // 单缓冲模式下为空操作。
+    void AcquireBank()
+    {
+        if (double_buffered_)
+        {
+            bank_busy_ = true;
+            std::fill(std::begin(fill_used_), std::end(fill_used_), 0);
+        }
+    }
+    void ReleaseBank();
+    bool IsBankBusy() const { return bank_busy_; }
+    const BankStats &GetBankStats() const { return bank_stats_; }
 
 private:
+    // used_[TOTAL] 为所有类型的总使用量
+    static const int TOTAL = NUM_DATA_TYPES;
+
+    // 一次容量比较：used_[slot] 与 limit
+    struct Check
+    {
+        int slot;
+        size_t limit;
+    };
+
+    static int Index(DataType type) { return static_cast<int>(type); }
+
+    // 按模式填充检查表，type_capacities 仅在INDEPENDENT模式下使用
+    void BuildChecks(const std::map<DataType, size_t> &type_capacities);
+
     /**
      * @brief 从缓冲区中驱逐指定类型和大小的数据。
      */
     size_t evict_data(DataType type, size_t size_to_evict);
 
+    // 驱逐后另一个 bank 的计数不能超过总使用量
+    void clamp_fill_bank(int i);
+
+    struct ResidentTile
+    {
+        size_t size;
+        int last_timestep;       // 最近一次访问的时间步
+        unsigned long last_tick; // 最近一次访问的序号 (LRU 次序)
+    };
+
+    // 在 tile 所在的容量域中按策略选择一个可驱逐的 tile，没有则返回 end()
+    std::map<TileKey, ResidentTile>::iterator select_victim(const TileKey &tile, int timestep);
+
     BufferMode mode_;
     size_t capacity_; // 共享模式下的总容量
-    size_t current_size_;
-    std::map<DataType, size_t> internal_buffer_sizes_;
-    std::map<DataType, size_t> type_capacities_; // 独立模式下每种类型的容量
+    size_t used_[NUM_DATA_TYPES + 1];
+    size_t capacities_[NUM_DATA_TYPES]; // GetCapacity() 的返回值
+    Check accept_check_[NUM_DATA_TYPES]; // OnDataReceived 的容量检查
+    Check full_check_[NUM_DATA_TYPES];   // IsFull 的判断
+
+    bool tile_tracking_;
+    TileReplacementPolicy tile_policy_;
+    const TileTimeline *tile_timeline_;
+    std::map<TileKey, ResidentTile> tiles_;
+    size_t tile_used_[NUM_DATA_TYPES + 1]; // 驻留 tile 的字节数，布局同 used_
+    unsigned long tile_tick_;
+    TileStats tile_stats_;
+
+    bool double_buffered_;
+    bool bank_busy_;                       // 消费者正在占用当前 bank
+    size_t fill_used_[NUM_DATA_TYPES + 1]; // 占用期间写入另一个 bank 的字节数
+    BankStats bank_stats_;
 };
 
-#endif // LIVENESS_AWARE_BUFFER_
\ No newline at end of file
+#endif // LIVENESS_AWARE_BUFFER_
@@ -2,6 +2,8 @@
 #include <cassert>
 #include <map>
 #include <vector>
+#include <cstdint>
+#include <stdexcept>
 #include "BufferManager.h"
 
 // Helper function to print test status
@@ -74,6 +76,24 @@ void TestDataReception() {
         assert(bm.OnDataReceived(DataType::WEIGHT, 1) == false); // Weight full
     }
 
+    // 按类型的在途预留：独立模式各类型分开计，共享模式合计
+    {
+        std::map<DataType, size_t> caps = {{DataType::INPUT, 50}, {DataType::WEIGHT, 50}};
+        BufferManager bm(caps);
+        size_t pending[NUM_DATA_TYPES] = {40, 40, 0, 0};
+        assert(bm.CanAcceptPending(DataType::INPUT, pending));
+        assert(bm.CanAcceptPending(DataType::WEIGHT, pending));
+        pending[1] = 51;
+        assert(!bm.CanAcceptPending(DataType::WEIGHT, pending));
+
+        BufferManager shared(100);
+        size_t shared_pending[NUM_DATA_TYPES] = {40, 40, 0, 0};
+        assert(shared.OnDataReceived(DataType::OUTPUT, 20));
+        assert(shared.CanAcceptPending(DataType::INPUT, shared_pending));
+        shared_pending[1] = 41;
+        assert(!shared.CanAcceptPending(DataType::WEIGHT, shared_pending));
+    }
+
     PrintTestSuccess("Data Reception Tests");
 }
 
@@ -217,6 +237,314 @@ void TestStress() {
     PrintTestSuccess("Stress Tests");
 }
 
+// 8. 与原 map 实现的对拍测试
+// 参考实现保留了定长数组版本之前基于 std::map 的逻辑
+class ReferenceBufferManager {
+public:
+    explicit ReferenceBufferManager(size_t capacity)
+        : mode_(BufferMode::SHARED), capacity_(capacity), current_size_(0) {
+        Init();
+    }
+    explicit ReferenceBufferManager(const std::map<DataType, size_t>& caps)
+        : mode_(BufferMode::INDEPENDENT), capacity_(0), current_size_(0),
+          type_capacities_(caps) {
+        Init();
+    }
+
+    size_t GetCapacity(DataType type) const {
+        if (mode_ == BufferMode::SHARED || type == DataType::UNKNOWN)
+            return capacity_;
+        auto it = type_capacities_.find(type);
+        return (it != type_capacities_.end()) ? it->second : 0;
+    }
+
+    size_t GetCurrentSize(DataType type) const {
+        if (type == DataType::UNKNOWN)
+            return current_size_;
+        auto it = internal_buffer_sizes_.find(type);
+        return (it != internal_buffer_sizes_.end()) ? it->second : 0;
+    }
+
+    bool IsFull(DataType type) const {
+        if (mode_ == BufferMode::SHARED || type == DataType::UNKNOWN)
+            return current_size_ >= capacity_;
+        auto capacity_it = type_capacities_.find(type);
+        auto size_it = internal_buffer_sizes_.find(type);
+        if (capacity_it != type_capacities_.end() &&
+            size_it != internal_buffer_sizes_.end())
+            return size_it->second >= capacity_it->second;
+        return false;
+    }
+
+    size_t GetDataSize(DataType type) const {
+        try {
+            return internal_buffer_sizes_.at(type);
+        } catch (const std::out_of_range&) {
+            return 0;
+        }
+    }
+
+    bool OnDataReceived(DataType type, size_t size_added) {
+        if (mode_ == BufferMode::SHARED) {
+            if (current_size_ + size_added > capacity_)
+                return false;
+        } else {
+            size_t limit = 0;
+            auto it = type_capacities_.find(type);
+            if (it != type_capacities_.end())
+                limit = it->second;
+            if (internal_buffer_sizes_[type] + size_added > limit)
+                return false;
+        }
+        internal_buffer_sizes_[type] += size_added;
+        current_size_ += size_added;
+        return true;
+    }
+
+    bool RemoveData(DataType type, size_t size) {
+        if (current_size_ < size || internal_buffer_sizes_[type] < size)
+            return false;
+        current_size_ -= size;
+        internal_buffer_sizes_[type] -= size;
+        return true;
+    }
+
+private:
+    void Init() {
+        internal_buffer_sizes_[DataType::INPUT] = 0;
+        internal_buffer_sizes_[DataType::WEIGHT] = 0;
+        internal_buffer_sizes_[DataType::OUTPUT] = 0;
+    }
+
+    BufferMode mode_;
+    size_t capacity_;
+    size_t current_size_;
+    std::map<DataType, size_t> internal_buffer_sizes_;
+    std::map<DataType, size_t> type_capacities_;
+};
+
+template <typename Ref>
+void RunDifferential(BufferManager& bm, Ref& ref, uint32_t seed) {
+    const DataType types[] = {DataType::INPUT, DataType::WEIGHT,
+                              DataType::OUTPUT, DataType::UNKNOWN};
+    uint32_t state = seed;
+    auto next = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    };
+
+    for (int step = 0; step < 20000; step++) {
+        DataType type = types[next() % 4];
+        size_t size = next() % 40;
+        switch (next() % 3) {
+        case 0:
+            assert(bm.OnDataReceived(type, size) == ref.OnDataReceived(type, size));
+            break;
+        case 1:
+            assert(bm.RemoveData(type, size) == ref.RemoveData(type, size));
+            break;
+        default:
+            assert(bm.AreDataTypeReady(type, size) == (ref.GetDataSize(type) >= size));
+            break;
+        }
+
+        for (DataType t : types) {
+            assert(bm.GetCapacity(t) == ref.GetCapacity(t));
+            assert(bm.GetCurrentSize(t) == ref.GetCurrentSize(t));
+            assert(bm.GetDataSize(t) == ref.GetDataSize(t));
+            assert(bm.IsFull(t) == ref.IsFull(t));
+        }
+    }
+}
+
+void TestAgainstReference() {
+    PrintTestStatus("Reference Differential Tests");
+
+    for (uint32_t seed = 1; seed <= 4; seed++) {
+        BufferManager bm(100);
+        ReferenceBufferManager ref(100);
+        RunDifferential(bm, ref, seed);
+    }
+
+    // 独立模式：全部配置、部分配置 (含未配置类型)、配置 UNKNOWN
+    std::vector<std::map<DataType, size_t>> configs = {
+        {{DataType::INPUT, 50}, {DataType::WEIGHT, 30}, {DataType::OUTPUT, 20}},
+        {{DataType::INPUT, 50}},
+        {{DataType::WEIGHT, 0}, {DataType::UNKNOWN, 25}},
+    };
+    for (size_t k = 0; k < configs.size(); k++) {
+        BufferManager bm(configs[k]);
+        ReferenceBufferManager ref(configs[k]);
+        RunDifferential(bm, ref, 100 + k);
+    }
+
+    PrintTestSuccess("Reference Differential Tests");
+}
+
+// 9. 驻留 tile 替换策略测试
+// 容量 100 只能放两个 40 字节的 tile，访问序列 A B C A B
+size_t RunTileSequence(TileReplacementPolicy policy, TileStats& stats) {
+    const TileKey seq[] = {TileKey(DataType::INPUT, 0), TileKey(DataType::WEIGHT, 0),
+                           TileKey(DataType::OUTPUT, 0), TileKey(DataType::INPUT, 0),
+                           TileKey(DataType::WEIGHT, 0)};
+    TileTimeline timeline;
+    for (int t = 0; t < 5; t++)
+        timeline.AddUse(seq[t], t);
+
+    BufferManager bm(100);
+    bm.EnableTileTracking(policy, &timeline);
+    size_t hits = 0;
+    for (int t = 0; t < 5; t++) {
+        hits += bm.ReferenceTile(seq[t], 40, t);
+        assert(bm.GetResidentTileBytes() <= bm.GetCapacity());
+    }
+    // 字节记账不受 tile 跟踪影响
+    assert(bm.GetCurrentSize() == 0);
+    stats = bm.GetTileStats();
+    return hits;
+}
+
+void TestTileReplacement() {
+    PrintTestStatus("Tile Replacement Tests");
+
+    TileReplacementPolicy policy;
+    assert(ParseTileReplacementPolicy("BELADY", policy) &&
+           policy == TileReplacementPolicy::BELADY);
+    assert(!ParseTileReplacementPolicy("FIFO", policy));
+
+    TileStats stats;
+    // LRU: 每次都驱逐下一个要用的 tile
+    assert(RunTileSequence(TileReplacementPolicy::LRU, stats) == 0);
+    assert(stats.misses == 5 && stats.evictions == 3);
+    assert(stats.miss_bytes == 200);
+
+    // BELADY: t=2 驱逐下次访问最远的 WEIGHT，t=3 命中
+    assert(RunTileSequence(TileReplacementPolicy::BELADY, stats) == 1);
+    assert(stats.misses == 4 && stats.hit_bytes == 40);
+
+    // LIVENESS: t=3 驱逐已死的 OUTPUT，t=4 命中
+    assert(RunTileSequence(TileReplacementPolicy::LIVENESS, stats) == 1);
+    assert(stats.misses == 4 && stats.evictions == 2);
+
+    // 独立模式：只在同类型中驱逐，超过类型容量的 tile 不装入
+    {
+        std::map<DataType, size_t> caps = {{DataType::INPUT, 50}, {DataType::WEIGHT, 50}};
+        BufferManager bm(caps);
+        bm.EnableTileTracking(TileReplacementPolicy::LRU, nullptr);
+        assert(!bm.ReferenceTile(TileKey(DataType::INPUT, 0), 30, 0));
+        assert(!bm.ReferenceTile(TileKey(DataType::WEIGHT, 0), 30, 0));
+        assert(!bm.ReferenceTile(TileKey(DataType::INPUT, 1), 30, 1));
+        assert(!bm.IsTileResident(TileKey(DataType::INPUT, 0)));
+        assert(bm.IsTileResident(TileKey(DataType::WEIGHT, 0)));
+        assert(!bm.ReferenceTile(TileKey(DataType::WEIGHT, 1), 60, 2));
+        assert(bm.GetTileStats().bypasses == 1);
+        assert(bm.IsTileResident(TileKey(DataType::WEIGHT, 0)));
+
+        // 同一时间步访问的 tile 不能互相驱逐
+        assert(!bm.ReferenceTile(TileKey(DataType::INPUT, 2), 30, 3));
+        assert(!bm.ReferenceTile(TileKey(DataType::INPUT, 3), 30, 3));
+        assert(bm.IsTileResident(TileKey(DataType::INPUT, 2)));
+        assert(bm.GetTileStats().bypasses == 2);
+    }
+
+    PrintTestSuccess("Tile Replacement Tests");
+}
+
+void TestDoubleBuffering() {
+    PrintTestStatus("Double Buffering Tests");
+
+    std::map<DataType, size_t> caps = {{DataType::INPUT, 4}, {DataType::OUTPUT, 2}};
+
+    // 单缓冲：占用/释放为空操作，写入始终与整个缓冲区比较
+    {
+        BufferManager bm(caps);
+        bm.AcquireBank();
+        assert(!bm.IsBankBusy());
+        assert(bm.OnDataReceived(DataType::INPUT, 4));
+        assert(!bm.CanAccept(DataType::INPUT, 1));
+        bm.ReleaseBank();
+        assert(bm.GetBankStats().swaps == 0);
+    }
+
+    BufferManager bm(caps);
+    bm.EnableDoubleBuffering();
+    assert(bm.IsDoubleBuffered());
+    assert(bm.GetCapacity(DataType::INPUT) == 4);
+
+    // 消费者空闲：当前 bank 装满后不再接收
+    assert(bm.CanAccept(DataType::INPUT, 4));
+    assert(bm.OnDataReceived(DataType::INPUT, 4));
+    assert(!bm.CanAccept(DataType::INPUT, 1));
+
+    // 消费者占用当前 bank：下一时间步的数据写入另一个 bank
+    bm.AcquireBank();
+    assert(bm.CanAccept(DataType::INPUT, 4));
+    assert(bm.OnDataReceived(DataType::INPUT, 3));
+    assert(!bm.CanAccept(DataType::INPUT, 2));
+    assert(bm.CanAccept(DataType::OUTPUT, 2));
+    assert(bm.AreDataTypeReady(DataType::INPUT, 7));
+    assert(bm.GetBankStats().overlapped_bytes == 3);
+
+    // 物理容量为两个 bank
+    assert(bm.OnDataReceived(DataType::INPUT, 1));
+    assert(!bm.OnDataReceived(DataType::INPUT, 1));
+
+    // 驱逐当前 bank 后释放：另一个 bank 的数据成为当前数据
+    assert(bm.RemoveData(DataType::INPUT, 4));
+    assert(bm.CanAccept(DataType::INPUT, 0));
+    bm.ReleaseBank();
+    assert(!bm.IsBankBusy());
+    assert(bm.GetCurrentSize(DataType::INPUT) == 4);
+    assert(!bm.CanAccept(DataType::INPUT, 1));
+
+    // 驱逐超过当前 bank 的数据时从另一个 bank 扣除
+    bm.AcquireBank();
+    assert(bm.OnDataReceived(DataType::OUTPUT, 2));
+    assert(bm.RemoveData(DataType::OUTPUT, 2));
+    assert(bm.CanAccept(DataType::OUTPUT, 2));
+    bm.ReleaseBank();
+
+    const BankStats &stats = bm.GetBankStats();
+    assert(stats.swaps == 2);
+    assert(stats.received_bytes == 10);
+    assert(stats.overlapped_bytes == 6);
+
+    PrintTestSuccess("Double Buffering Tests");
+}
+
+// 预取容量检查：独立模式逐类型，共享模式 (GLB) 按所有类型合计
+void TestPrefetchFits() {
+    PrintTestStatus("Prefetch Fit Tests");
+
+    // GLB 容量 32，常驻 INPUT 8 / WEIGHT 8：单独看每种类型都放得下，
+    // 两种类型合计超出剩余的 16
+    {
+        size_t capacity[NUM_DATA_TYPES] = {32, 32, 32, 32};
+        size_t resident[NUM_DATA_TYPES] = {8, 8, 0, 0};
+        size_t ahead[NUM_DATA_TYPES] = {10, 10, 0, 0};
+        assert(!PrefetchFits(BufferMode::SHARED, capacity, resident, ahead));
+        ahead[1] = 6;
+        assert(PrefetchFits(BufferMode::SHARED, capacity, resident, ahead));
+
+        // 常驻数据超过容量时不能再预取
+        size_t full[NUM_DATA_TYPES] = {20, 20, 0, 0};
+        size_t one[NUM_DATA_TYPES] = {1, 0, 0, 0};
+        assert(!PrefetchFits(BufferMode::SHARED, capacity, full, one));
+    }
+
+    // 同样的数据量在独立模式下各类型分开计
+    {
+        size_t capacity[NUM_DATA_TYPES] = {20, 20, 8, 0};
+        size_t resident[NUM_DATA_TYPES] = {8, 8, 0, 0};
+        size_t ahead[NUM_DATA_TYPES] = {10, 10, 0, 0};
+        assert(PrefetchFits(BufferMode::INDEPENDENT, capacity, resident, ahead));
+        ahead[0] = 13;
+        assert(!PrefetchFits(BufferMode::INDEPENDENT, capacity, resident, ahead));
+    }
+
+    PrintTestSuccess("Prefetch Fit Tests");
+}
+
 int main() {
     std::cout << "Starting BufferManager Tests..." << std::endl;
     
@@ -227,6 +555,10 @@ int main() {
     TestDataRemoval();
     TestEdgeCases();
     TestStress();
+    TestAgainstReference();
+    TestTileReplacement();
+    TestDoubleBuffering();
+    TestPrefetchFits();
 
     std::cout << "All tests passed successfully!" << std::endl;
     return 0;
@@ -174,6 +174,7 @@ template <> struct convert<AtomicDispatchAction> {
     rhs.data_space = node["data_space"].as<std::string>();
     rhs.size = node["size"].as<size_t>();
     rhs.target_role = stringToRole(node["target_role"].as<std::string>());
+    rhs.tile = node["tile"] ? node["tile"].as<int>() : -1;
 
     return true;
   }
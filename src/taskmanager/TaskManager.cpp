@@ -1,5 +1,6 @@
 #include "TaskManager.h"
 #include "../GlobalParams.h"
+#include "../Log.h"
 #include "ConfigParser.h"
 #include <algorithm>
 #include <iterator>
@@ -12,8 +13,8 @@
 
 void TaskManager::ConfigureFromYAML(const std::string &yaml_file_path,
                                     const std::string &role) {
-  std::cout << "TaskManager: Loading configuration from YAML file: "
-            << yaml_file_path << std::endl;
+  LOG_MEDIUM << "TaskManager: Loading configuration from YAML file: "
+             << yaml_file_path << std::endl;
 
   try {
     // 使用 ConfigParser 加载配置
@@ -24,7 +25,7 @@ void TaskManager::ConfigureFromYAML(const std::string &yaml_file_path,
       throw std::runtime_error("Loaded configuration failed validation");
     }
 
-    std::cout
+    LOG_MEDIUM
         << "TaskManager: YAML configuration loaded and validated successfully"
         << std::endl;
 
@@ -39,70 +40,73 @@ void TaskManager::ConfigureFromYAML(const std::string &yaml_file_path,
 
 void TaskManager::Configure(const WorkloadConfig &config,
                             const std::string &role) {
-  std::cout << "TaskManager: Starting configuration for role '" << role << "'"
-            << std::endl;
+  LOG_MEDIUM << "TaskManager: Starting configuration for role '" << role << "'"
+             << std::endl;
 
   // 存储配置
   config_ = config;
 
   // 打印配置摘要
-  std::cout << "TaskManager: Configuration summary:" << std::endl;
-  std::cout << "  - Working sets: " << config.working_set.size() << std::endl;
-  std::cout << "  - Data flow specs: " << config.data_flow_specs.size()
-            << std::endl;
+  LOG_MEDIUM << "TaskManager: Configuration summary:" << std::endl
+             << "  - Working sets: " << config.working_set.size() << std::endl
+             << "  - Data flow specs: " << config.data_flow_specs.size()
+             << std::endl;
 
   // 打印所有已配置的角色
   auto roles = config.get_all_roles();
-  std::cout << "  - Configured roles: ";
+  std::ostringstream roles_str;
   for (size_t i = 0; i < roles.size(); ++i) {
     if (i > 0)
-      std::cout << ", ";
-    std::cout << roles[i];
+      roles_str << ", ";
+    roles_str << roles[i];
   }
-  std::cout << std::endl;
+  LOG_MEDIUM << "  - Configured roles: " << roles_str.str() << std::endl;
 
   // 清空现有任务
-  all_tasks_.clear();
+  clear();
 
   // 查找指定角色的数据流规格（使用 TaskManager 的私有辅助函数）
   const DataFlowSpec *spec = find_data_flow_spec(role);
   if (!spec) {
-    std::cout << "TaskManager: Warning - No data flow spec found for role '"
-              << role << "'" << std::endl;
+    LOG_LOW << "TaskManager: Warning - No data flow spec found for role '"
+            << role << "'" << std::endl;
     return;
   }
 
   // 查找角色的工作集（使用 TaskManager 的私有辅助函数）
   role_working_set_ = find_working_set_for_role(role);
   if (!role_working_set_) {
-    std::cout << "TaskManager: Warning - No working set found for role '"
-              << role << "'" << std::endl;
+    LOG_LOW << "TaskManager: Warning - No working set found for role '"
+            << role << "'" << std::endl;
   }
 
   // 打印角色的详细信息
-  std::cout << "TaskManager: Role '" << role << "' details:" << std::endl;
-  std::cout << "  - Has schedule template: "
-            << (spec->has_schedule() ? "Yes" : "No") << std::endl;
-  std::cout << "  - Has command definitions: "
-            << (spec->has_commands() ? "Yes" : "No") << std::endl;
-  std::cout << "  - Compute latency: " << spec->properties.compute_latency
-            << std::endl;
+  LOG_MEDIUM << "TaskManager: Role '" << role << "' details:" << std::endl
+             << "  - Has schedule template: "
+             << (spec->has_schedule() ? "Yes" : "No") << std::endl
+             << "  - Has command definitions: "
+             << (spec->has_commands() ? "Yes" : "No") << std::endl
+             << "  - Compute latency: " << spec->properties.compute_latency
+             << std::endl;
   if (role_working_set_) {
-    std::cout << "  - Working set found for role '" << role << "'" << std::endl;
+    LOG_MEDIUM << "  - Working set found for role '" << role << "'"
+               << std::endl;
   }
 
   // 如果有命令定义，打印它们
   if (spec->has_commands()) {
-    std::cout << "  - Command definitions (" << spec->command_definitions.size()
-              << "):" << std::endl;
+    LOG_MEDIUM << "  - Command definitions ("
+               << spec->command_definitions.size() << "):" << std::endl;
     for (const auto &cmd : spec->command_definitions) {
-      std::cout << "    * ID " << cmd.command_id << ": " << cmd.name;
       if (!cmd.evict_payload.is_empty()) {
-        std::cout << " (evict: W=" << cmd.evict_payload.weights
-                  << ", I=" << cmd.evict_payload.inputs
-                  << ", O=" << cmd.evict_payload.outputs << ")";
+        LOG_MEDIUM << "    * ID " << cmd.command_id << ": " << cmd.name
+                   << " (evict: W=" << cmd.evict_payload.weights
+                   << ", I=" << cmd.evict_payload.inputs
+                   << ", O=" << cmd.evict_payload.outputs << ")" << std::endl;
+      } else {
+        LOG_MEDIUM << "    * ID " << cmd.command_id << ": " << cmd.name
+                   << std::endl;
       }
-      std::cout << std::endl;
     }
   }
 
@@ -112,20 +116,29 @@ void TaskManager::Configure(const WorkloadConfig &config,
 
   // 只有当角色有调度模板时才继续处理
   if (!spec->has_schedule()) {
-    std::cout << "TaskManager: Role '" << role
-              << "' has no schedule template, skipping task generation"
-              << std::endl;
+    LOG_MEDIUM << "TaskManager: Role '" << role
+               << "' has no schedule template, skipping task generation"
+               << std::endl;
     return;
   }
 
   const ScheduleTemplate &schedule = *spec->schedule_template;
-  std::cout << "TaskManager: Found " << role << " schedule with "
-            << schedule.total_timesteps << " timesteps and "
-            << schedule.delta_events.size() << " delta events" << std::endl;
+  LOG_MEDIUM << "TaskManager: Found " << role << " schedule with "
+             << schedule.total_timesteps << " timesteps and "
+             << schedule.delta_events.size() << " delta events" << std::endl;
 
   // 调整任务向量大小以匹配总时间步数
   all_tasks_.resize(schedule.total_timesteps);
 
+  // 未显式指定 tile 的动作每次触发使用新的 tile 编号，从显式编号之后开始
+  int next_tile[NUM_DATA_TYPES] = {0};
+  for (const auto &event : schedule.delta_events) {
+    for (const auto &action : event.actions) {
+      int type = static_cast<int>(stringToDataType(action.data_space));
+      next_tile[type] = std::max(next_tile[type], action.tile + 1);
+    }
+  }
+
   // 遍历所有时间步，创建对应的DispatchTask
   for (int t = 0; t < schedule.total_timesteps; ++t) {
     DispatchTask task;
@@ -140,28 +153,28 @@ void TaskManager::Configure(const WorkloadConfig &config,
       }
 
       if (matches_trigger_condition(event.trigger, t)) {
-        std::cout << "TaskManager: Timestep " << t << " matches event '"
-                  << event.name << "'" << std::endl;
+        LOG_HIGH << "TaskManager: Timestep " << t << " matches event '"
+                 << event.name << "'" << std::endl;
 
         // 根据事件创建分发任务
-        create_dispatch_task_from_event(task, event, t);
+        create_dispatch_task_from_event(task, event, t, next_tile);
         matched_events++;
       }
     }
 
     if (matched_events == 0 && fallback_event != nullptr) {
-      std::cout << "TaskManager: Timestep " << t << " using fallback event '"
-                << fallback_event->name << "'" << std::endl;
-      create_dispatch_task_from_event(task, *fallback_event, t);
+      LOG_HIGH << "TaskManager: Timestep " << t << " using fallback event '"
+               << fallback_event->name << "'" << std::endl;
+      create_dispatch_task_from_event(task, *fallback_event, t, next_tile);
     }
 
     // 将创建的任务存储到时间线中
     all_tasks_[t] = task;
 
-    // 调试输出
+    // 调试输出 (to_string 只在 LOG_HIGH 使能时才会被调用)
     if (!task.is_complete()) {
-      std::cout << "TaskManager: Timestep " << t
-                << " configured: " << task.to_string() << std::endl;
+      LOG_HIGH << "TaskManager: Timestep " << t
+               << " configured: " << task.to_string() << std::endl;
     }
   }
 
@@ -175,8 +188,8 @@ void TaskManager::Configure(const WorkloadConfig &config,
     }
 
     if (role_working_set_ == nullptr) {
-      std::cout << "TaskManager: Warning - Role '" << role
-                << "' has no working set defined." << std::endl;
+      LOG_LOW << "TaskManager: Warning - Role '" << role
+              << "' has no working set defined." << std::endl;
       return;
     }
 
@@ -195,15 +208,15 @@ void TaskManager::Configure(const WorkloadConfig &config,
     }
   }
 
-  std::cout << "TaskManager: Configuration completed with " << all_tasks_.size()
-            << " tasks total" << std::endl;
+  LOG_MEDIUM << "TaskManager: Configuration completed with "
+             << all_tasks_.size() << " tasks total" << std::endl;
 }
 
 DispatchTask TaskManager::get_task_for_timestep(int timestep) const {
   // 边界检查
   if (timestep < 0 || static_cast<size_t>(timestep) >= all_tasks_.size()) {
-    std::cout << "TaskManager: Warning - Invalid timestep " << timestep
-              << " requested, returning empty task" << std::endl;
+    LOG_LOW << "TaskManager: Warning - Invalid timestep " << timestep
+            << " requested, returning empty task" << std::endl;
     return DispatchTask(); // 返回空任务
   }
 
@@ -211,6 +224,45 @@ DispatchTask TaskManager::get_task_for_timestep(int timestep) const {
   return all_tasks_[timestep];
 }
 
+const std::vector<TileRef> &TaskManager::get_tile_refs(int timestep) const {
+  static const std::vector<TileRef> empty;
+  if (timestep < 0 || static_cast<size_t>(timestep) >= tile_refs_.size())
+    return empty;
+  return tile_refs_[timestep];
+}
+
+void TaskManager::build_tile_timeline() {
+  // Configure 会清空 tile_refs_，大小一致说明已经构建过
+  if (tile_refs_.size() == all_tasks_.size())
+    return;
+  tile_refs_.assign(all_tasks_.size(), std::vector<TileRef>());
+  tile_timeline_.Clear();
+
+  std::map<TileKey, size_t> live; // 当前活跃的 tile -> 大小
+  for (size_t t = 0; t < all_tasks_.size(); ++t) {
+    std::map<TileKey, size_t> fired;
+    bool refreshed[NUM_DATA_TYPES] = {false};
+    for (const auto &sub_task : all_tasks_[t].sub_tasks) {
+      fired[TileKey(sub_task.type, sub_task.tile)] += sub_task.size;
+      refreshed[static_cast<int>(sub_task.type)] = true;
+    }
+
+    // 本时间步重新分发的数据空间，旧的 tile 不再活跃
+    for (auto it = live.begin(); it != live.end();) {
+      if (refreshed[static_cast<int>(it->first.type)])
+        it = live.erase(it);
+      else
+        ++it;
+    }
+    live.insert(fired.begin(), fired.end());
+
+    for (const auto &entry : live) {
+      tile_refs_[t].push_back({entry.first, entry.second});
+      tile_timeline_.AddUse(entry.first, static_cast<int>(t));
+    }
+  }
+}
+
 DataDelta TaskManager::get_command_definition(int command_id) const {
   // 假设 task_manager_ 已经初始化并包含所有命令定义
   for (const auto &cmd_def : *role_commands_) {
@@ -272,7 +324,10 @@ DataDelta TaskManager::get_current_working_set() const {
  */
 void TaskManager::create_dispatch_task_from_event(DispatchTask &task,
                                                   const DeltaEvent &event,
-                                                  int timestep) const {
+                                                  int timestep,
+                                                  int *next_tile) const {
+  // 同一次触发中同一数据空间的动作属于同一个新 tile
+  std::map<DataType, int> fresh_tiles;
 
   // dbg(sc_time_stamp(), "TaskManager", "[CONFIG] Processing event '" +
   // event.name +
@@ -310,6 +365,17 @@ void TaskManager::create_dispatch_task_from_event(DispatchTask &task,
     sub_task_info.size = action.size;
     // sub_task_info.target_ids = target_ids;
     sub_task_info.target_role = action.target_role;
+    if (action.tile >= 0) {
+      sub_task_info.tile = action.tile;
+    } else {
+      auto fresh = fresh_tiles.find(type);
+      if (fresh == fresh_tiles.end())
+        fresh = fresh_tiles
+                    .insert(std::make_pair(
+                        type, next_tile[static_cast<int>(type)]++))
+                    .first;
+      sub_task_info.tile = fresh->second;
+    }
     task.sub_tasks.push_back(sub_task_info);
   }
 }
@@ -2,6 +2,7 @@
 #define __TASKMANAGER_H__
 
 #include "../DataStructs.h"
+#include "../smartbuffer/BufferManager.h"
 #include "ConfigParser.h" // 用于从 YAML 加载配置
 #include "WorkloadStructs.h"
 #include <dbg.h>
@@ -23,9 +24,18 @@ struct DataDispatchInfo {
   DataType type;
   size_t size;         // 数据大小（字节）
   PE_Role target_role; // 目标角色
+  int tile;            // 所属 tile 编号 (同一数据空间内)
 
-  DataDispatchInfo() : size(0) {}
-  DataDispatchInfo(size_t s) : size(s) {}
+  DataDispatchInfo() : size(0), tile(-1) {}
+  DataDispatchInfo(size_t s) : size(s), tile(-1) {}
+};
+
+/**
+ * @brief 某个时间步访问的一个 tile
+ */
+struct TileRef {
+  TileKey tile;
+  size_t size;
 };
 
 struct DispatchTask {
@@ -80,14 +90,20 @@ private:
   const std::vector<CommandDefinition> *role_commands_; // GLB 角色的命令定义
   std::map<int, bool> sync_points_;                     // 同步点列表
 
+  // tile 时间线：每个时间步访问各数据空间当前驻留的 tile。
+  // 数据空间的 tile 在它下一次被分发之前一直是活跃的。只有跟踪驻留 tile
+  // 的角色 (DRAM/GLB) 才调用 build_tile_timeline 构建
+  std::vector<std::vector<TileRef>> tile_refs_; // [timestep]
+  TileTimeline tile_timeline_;
+
   // 私有辅助函数
   const DataFlowSpec *find_data_flow_spec(const std::string &role) const;
   const RoleWorkingSet *
   find_working_set_for_role(const std::string &role) const;
 
   void create_dispatch_task_from_event(DispatchTask &task,
-                                       const DeltaEvent &event,
-                                       int timestep) const;
+                                       const DeltaEvent &event, int timestep,
+                                       int *next_tile) const;
   bool matches_trigger_condition(const Trigger &trigger, int timestep) const;
 
 public:
@@ -133,6 +149,19 @@ public:
     return role_commands_ ? static_cast<int>(role_commands_->size()) : 0;
   }
 
+  /**
+   * @brief 按任务时间线构建 tile 时间线 (已构建时为空操作)
+   *
+   * 占用 O(时间步数 x 活跃 tile 数) 的内存，只在启用 tile 跟踪时调用
+   */
+  void build_tile_timeline();
+
+  /**
+   * @brief 获取指定时间步访问的 tile (越界或未构建时返回空列表)
+   */
+  const std::vector<TileRef> &get_tile_refs(int timestep) const;
+  const TileTimeline &get_tile_timeline() const { return tile_timeline_; }
+
   bool is_in_sync_points(int timestep) const {
     return sync_points_.count(timestep) > 0;
   }
@@ -151,7 +180,11 @@ public:
   /**
    * @brief 清空所有任务
    */
-  void clear() { all_tasks_.clear(); }
+  void clear() {
+    all_tasks_.clear();
+    tile_refs_.clear();
+    tile_timeline_.Clear();
+  }
 
   /**
    * @brief 检查任务管理器是否已配置
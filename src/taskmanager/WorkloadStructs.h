@@ -98,6 +98,7 @@ struct AtomicDispatchAction {
   std::string data_space; // "Weights", "Inputs", "Outputs"
   size_t size;
   PE_Role target_role;
+  int tile; // 可选：显式 tile 编号 (重复使用同一 tile)，-1 表示每次触发新 tile
 };
 
 /**
@@ -262,34 +262,36 @@ int sc_main(int arg_num, char *arg_vet[]) {
     // --- 2. 分配内存 ---
     int* node_level_map = new int[total_nodes];
     int* parent_map = new int[total_nodes];
-    int** child_map = new int*[total_nodes];
-    for (int i = 0; i < total_nodes; ++i) {
-        // 即使一个节点没有孩子，也为它分配一个小的数组，以避免空指针
-        child_map[i] = new int[1]; 
-    }
+    // 子节点为 CSR：节点 i 的子节点是 child_list[child_offsets[i] .. child_offsets[i+1])
+    int* child_offsets = new int[total_nodes + 1];
+    int* child_list = new int[total_nodes - 1];
 
     // --- 3. 填充映射表 ---
 
     // --- Node 0 (DRAM @ Level 0) ---
     node_level_map[0] = 0;
     parent_map[0] = -1;       // 根节点，没有父节点
-    child_map[0][0] = 1;      // 唯一的子节点是 Node 1 (GLB)
+    child_offsets[0] = 0;
+    child_list[0] = 1;        // 唯一的子节点是 Node 1 (GLB)
 
     // --- Node 1 (GLB @ Level 1) ---
     node_level_map[1] = 1;
     parent_map[1] = 0;        // 父节点是 Node 0 (DRAM)
-    child_map[1][0] = 2;      // 唯一的子节点是 Node 2 (BUFFER)
+    child_offsets[1] = 1;
+    child_list[1] = 2;        // 唯一的子节点是 Node 2 (BUFFER)
 
     // --- Node 2 (BUFFER @ Level 2) ---
     node_level_map[2] = 2;
     parent_map[2] = 1;        // 父节点是 Node 1 (GLB)
-    // Node 2 是叶子节点，没有子节点。child_map[2] 指向一个空列表，这没问题。
-    // (fanout 为 0)
+    // Node 2 是叶子节点，没有子节点 (fanout 为 0)
+    child_offsets[2] = 2;
+    child_offsets[3] = 2;
 
     // --- 4. 将手动创建的数组赋值给 GlobalParams ---
     GlobalParams::node_level_map = node_level_map;
     GlobalParams::parent_map = parent_map;
-    GlobalParams::child_map = child_map;
+    GlobalParams::child_offsets = child_offsets;
+    GlobalParams::child_list = child_list;
     GlobalParams::num_nodes = total_nodes;
     GlobalParams::num_levels = num_levels;
 
@@ -0,0 +1,212 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "Allocator.h"
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// ====================================================================================
+//                        Allocator 单元测试
+// ====================================================================================
+
+// 构造一个请求 (outputs 由调用方持有)
+static AllocRequest makeRequest(int input, int vc, const vector<int> &outputs,
+                                unsigned long age = 0) {
+    AllocRequest r;
+    r.input = input;
+    r.vc = vc;
+    r.outputs = &outputs;
+    r.age = age;
+    return r;
+}
+
+// 连续 rounds 次分配，记录每次第一个被授予请求的 input
+static vector<int> winners(Allocator &allocator,
+                           const vector<AllocRequest> &requests, int rounds) {
+    vector<int> result;
+    vector<int> grants;
+    for (int i = 0; i < rounds; i++) {
+        allocator.allocate(requests, grants);
+        REQUIRE(grants.size() == 1);
+        result.push_back(requests[grants[0]].input);
+    }
+    return result;
+}
+
+SCENARIO("Switch allocators grant contended outputs in policy order", "[allocator]") {
+
+    const vector<int> out0 = {0};
+    const vector<int> out1 = {1};
+
+    GIVEN("two inputs requesting the same output") {
+        vector<AllocRequest> requests = {makeRequest(0, 0, out0),
+                                         makeRequest(1, 0, out0)};
+
+        WHEN("the allocator is round robin") {
+            RoundRobinAllocator rr;
+            rr.configure(2, 2, 1);
+            THEN("the winner alternates, starting from input 0") {
+                REQUIRE(winners(rr, requests, 4) == vector<int>({0, 1, 0, 1}));
+            }
+        }
+
+        WHEN("the allocator is iSLIP") {
+            ISlipAllocator islip;
+            islip.configure(2, 2, 1);
+            THEN("the grant pointer moves past each winner") {
+                REQUIRE(winners(islip, requests, 4) == vector<int>({0, 1, 0, 1}));
+            }
+        }
+
+        WHEN("the allocator is age based") {
+            AgeAllocator age;
+            age.configure(2, 2, 1);
+            THEN("the older request wins regardless of the round robin pointer") {
+                requests[1].age = 3;
+                REQUIRE(winners(age, requests, 1) == vector<int>({1}));
+            }
+            THEN("equal ages fall back to round robin order") {
+                REQUIRE(winners(age, requests, 3) == vector<int>({0, 1, 0}));
+            }
+        }
+    }
+
+    GIVEN("two VCs of one input requesting the same output") {
+        vector<AllocRequest> requests = {makeRequest(0, 0, out0),
+                                         makeRequest(0, 1, out0)};
+        ISlipAllocator islip;
+        islip.configure(1, 1, 2);
+
+        THEN("iSLIP rotates the accept pointer between the VCs") {
+            vector<int> grants;
+            vector<int> vcs;
+            for (int i = 0; i < 4; i++) {
+                islip.allocate(requests, grants);
+                REQUIRE(grants.size() == 1);
+                vcs.push_back(requests[grants[0]].vc);
+            }
+            REQUIRE(vcs == vector<int>({0, 1, 0, 1}));
+        }
+    }
+
+    GIVEN("requests without conflicts") {
+        vector<AllocRequest> requests = {makeRequest(0, 0, out0),
+                                         makeRequest(1, 0, out1)};
+
+        THEN("every policy grants all of them") {
+            for (const char *name : {ALLOCATOR_ROUND_ROBIN, ALLOCATOR_ISLIP, ALLOCATOR_AGE}) {
+                unique_ptr<Allocator> allocator(Allocator::create(name));
+                allocator->configure(2, 2, 1);
+                vector<int> grants;
+                allocator->allocate(requests, grants);
+                REQUIRE(grants.size() == 2);
+            }
+        }
+    }
+}
+
+SCENARIO("Wait ages count consecutive losing cycles", "[allocator]") {
+
+    const vector<int> out0 = {0};
+
+    GIVEN("two inputs, two VCs and the aggregation queue") {
+        WaitAges ages;
+        ages.configure(2, 2);
+        AllocRequest a = makeRequest(0, 1, out0);
+        AllocRequest b = makeRequest(1, 0, out0);
+        AllocRequest agg = makeRequest(2, 0, out0); // 聚合队列为最后一个 input
+
+        WHEN("requests keep losing") {
+            ages.update({a, b, agg});
+            ages.update({a, b, agg});
+            THEN("their ages grow by one per cycle") {
+                REQUIRE(ages.ageOf(0, 1) == 2);
+                REQUIRE(ages.ageOf(1, 0) == 2);
+                REQUIRE(ages.ageOf(2, 0) == 2);
+                REQUIRE(ages.ageOf(0, 0) == 0);
+            }
+        }
+
+        WHEN("a request is granted") {
+            ages.update({a, b});
+            ages.granted(a);
+            ages.update({a, b});
+            THEN("its age restarts while the loser keeps counting") {
+                REQUIRE(ages.ageOf(0, 1) == 1);
+                REQUIRE(ages.ageOf(1, 0) == 2);
+            }
+        }
+
+        WHEN("a VC stops requesting without being granted") {
+            ages.update({a, b});
+            ages.update({a, b});
+            ages.update({a});
+            THEN("its age is reset") {
+                REQUIRE(ages.ageOf(1, 0) == 0);
+                REQUIRE(ages.ageOf(0, 1) == 3);
+            }
+            THEN("a new request starts again from one") {
+                ages.update({a, b});
+                REQUIRE(ages.ageOf(1, 0) == 1);
+            }
+        }
+
+        WHEN("a cycle has no requests at all") {
+            ages.update({a, b});
+            ages.update({});
+            THEN("every age is reset") {
+                REQUIRE(ages.ageOf(0, 1) == 0);
+                REQUIRE(ages.ageOf(1, 0) == 0);
+            }
+        }
+    }
+}
+
+// 按固定的伪随机序列生成请求，驱动一个新建的分配器，返回所有授予
+static vector<vector<int>> runSequence(const char *name) {
+    const int n_inputs = 4, n_outputs = 4, n_vcs = 2, cycles = 200;
+    vector<vector<int>> outputs;
+    for (int o = 0; o < n_outputs; o++)
+        outputs.push_back({o});
+    outputs.push_back({0, 2}); // 多播
+    outputs.push_back({1, 3});
+
+    unique_ptr<Allocator> allocator(Allocator::create(name));
+    allocator->configure(n_inputs, n_outputs, n_vcs);
+    WaitAges ages;
+    ages.configure(n_inputs, n_vcs);
+
+    unsigned int state = 12345;
+    vector<vector<int>> history;
+    vector<AllocRequest> requests;
+    vector<int> grants;
+    for (int cycle = 0; cycle < cycles; cycle++) {
+        requests.clear();
+        for (int in = 0; in <= n_inputs; in++) {
+            for (int vc = 0; vc < n_vcs; vc++) {
+                state = state * 1103515245u + 12345u;
+                if ((state >> 16) % 3 == 0)
+                    requests.push_back(makeRequest(in, vc, outputs[(state >> 8) % outputs.size()]));
+            }
+        }
+        ages.update(requests);
+        for (AllocRequest &r : requests)
+            r.age = ages.ageOf(r.input, r.vc);
+        allocator->allocate(requests, grants);
+        for (int g : grants)
+            ages.granted(requests[g]);
+        history.push_back(grants);
+    }
+    return history;
+}
+
+SCENARIO("Allocators are deterministic", "[allocator]") {
+    GIVEN("the same request sequence") {
+        THEN("repeated runs of each policy give identical grants") {
+            for (const char *name : {ALLOCATOR_ROUND_ROBIN, ALLOCATOR_ISLIP, ALLOCATOR_AGE})
+                REQUIRE(runSequence(name) == runSequence(name));
+        }
+    }
+}
@@ -15,22 +15,12 @@ SC_MODULE(MockNode)
     sc_in_clk clock;
     sc_in<bool> reset;
 
-    // 使用与Tile兼容的信号类型
-    sc_in<Flit> flit_rx;
-    sc_in<bool> req_rx;
-    sc_out<bool> ack_rx;
-    sc_out<TBufferFullStatus> buffer_full_status_rx;
-
-    sc_out<Flit> flit_tx;
-    sc_out<bool> req_tx;
-    sc_in<bool> ack_tx;
-    sc_in<TBufferFullStatus> buffer_full_status_tx;
+    // 与Tile的层次化链路端口相同的接口
+    sc_port<LinkRxIf> link_rx;
+    sc_port<LinkTxIf> link_tx;
 
     string node_name;
 
-    bool current_level_tx;
-    bool current_level_rx;
-
     queue<Packet> packet_queue;
 
     int total_packets_sent;
@@ -39,15 +29,12 @@ SC_MODULE(MockNode)
     void rxProcess()
     {
         if (reset.read())
+            return;
+
         {
-            ack_rx.write(0);
-            current_level_rx = 0;
-        }
-        else
-        {
-            if (req_rx.read() == 1 - current_level_rx)
+            while (link_rx->available())
             {
-                Flit received_flit = flit_rx.read();
+                Flit received_flit = link_rx->receive();
 
                 // 验证多次转发
                 cout << "[" << sc_time_stamp() << "] " << node_name
@@ -74,18 +61,15 @@ SC_MODULE(MockNode)
                 // 统计接收到的flit数量
                 // total_flits_received++;
 
-                current_level_rx = 1 - current_level_rx;
-                ack_rx.write(current_level_rx);
+                // 立即消费：信用流控下直接归还信用
+                if (link_rx->usesCredits())
+                    link_rx->returnCredit(received_flit.vc_id);
             }
         }
 
         // 报告缓冲区未满
-        TBufferFullStatus bfs;
-        for (int i = 0; i < GlobalParams::n_virtual_channels; i++)
-        {
-            bfs.mask[i] = false;
-        }
-        buffer_full_status_rx.write(bfs);
+        if (!link_rx->usesCredits())
+            link_rx->setFullMask(0);
     }
 
     Flit generate_next_flit_from_queue(queue<Packet> & queue)
@@ -137,8 +121,7 @@ SC_MODULE(MockNode)
     {
         if (reset.read())
         {
-            req_tx.write(0);
-            current_level_tx = 0;
+            link_tx->reset();
             while (!packet_queue.empty())
                 packet_queue.pop();
             total_packets_sent = 0;
@@ -146,14 +129,12 @@ SC_MODULE(MockNode)
             return;
         }
 
-        // ABP流控: 检查ack信号是否匹配
-        if (ack_tx.read() == current_level_tx)
         {
             if (!packet_queue.empty())
             {
-                // 检查目标VC是否满
+                // 检查链路能否发送 (ABP: 无在途flit且VC未满; credit: 有信用)
                 Packet &pkt = packet_queue.front();
-                if (buffer_full_status_tx.read().mask[pkt.vc_id])
+                if (!link_tx->canSend(pkt.vc_id))
                 {
                     return; // VC满,等待下次
                 }
@@ -162,9 +143,7 @@ SC_MODULE(MockNode)
                 Flit flit = generate_next_flit_from_queue(packet_queue);
 
                 // 发送flit
-                flit_tx.write(flit);
-                current_level_tx = 1 - current_level_tx;
-                req_tx.write(current_level_tx);
+                link_tx->send(flit);
 
                 // 统计
                 total_flits_sent++;
@@ -286,13 +265,12 @@ int sc_main(int argc, char *argv[])
     // 5. 连接Mock节点（修正端口访问方式）
 
     // 连接Distribution节点（DOWN方向）
+    // 链路流控按GLB所在层的配置
+    const LevelConfig &glb_level = GlobalParams::hierarchical_config.get_level_config(GlobalParams::node_level_map[node_id]);
     MockNode *mock_dist[4];
-    sc_signal<Flit> flit_to_dist[4], flit_from_dist[4];
-    sc_signal<bool> req_to_dist[4], req_from_dist[4];
-    sc_signal<bool> ack_to_dist[4], ack_from_dist[4];
-    sc_signal<TBufferFullStatus> bfs_to_dist[4], bfs_from_dist[4];
+    LinkChannel *link_to_dist[4], *link_from_dist[4];
 
-    for (int i = 0; i < 4 && i < glb_tile->hierarchical_flit_down_tx.size(); i++)
+    for (int i = 0; i < 4 && i < glb_tile->hierarchical_link_down_tx.size(); i++)
     {
         char name[32];
         sprintf(name, "MockDist_%d", i);
@@ -301,56 +279,49 @@ int sc_main(int argc, char *argv[])
         mock_dist[i]->clock(clock);
         mock_dist[i]->reset(reset);
 
-        // GLB -> Distribution (使用解引用的指针)
-        glb_tile->hierarchical_flit_down_tx[i]->bind(flit_to_dist[i]);
-        glb_tile->hierarchical_req_down_tx[i]->bind(req_to_dist[i]);
-        glb_tile->hierarchical_ack_down_tx[i]->bind(ack_from_dist[i]);
-        glb_tile->hierarchical_buffer_full_status_down_tx[i]->bind(bfs_from_dist[i]);
+        sprintf(name, "LinkToDist_%d", i);
+        link_to_dist[i] = new LinkChannel(name);
+        sprintf(name, "LinkFromDist_%d", i);
+        link_from_dist[i] = new LinkChannel(name);
+        link_to_dist[i]->configure(glb_level.credit_flow_control, glb_level.link_latency,
+                                   GlobalParams::buffer_depth, GlobalParams::n_virtual_channels);
+        link_from_dist[i]->configure(glb_level.credit_flow_control, glb_level.link_latency,
+                                     GlobalParams::buffer_depth, GlobalParams::n_virtual_channels);
 
-        mock_dist[i]->flit_rx(flit_to_dist[i]);
-        mock_dist[i]->req_rx(req_to_dist[i]);
-        mock_dist[i]->ack_rx(ack_from_dist[i]);
-        mock_dist[i]->buffer_full_status_rx(bfs_from_dist[i]);
+        // GLB -> Distribution
+        glb_tile->hierarchical_link_down_tx[i]->bind(*link_to_dist[i]);
+        mock_dist[i]->link_rx(*link_to_dist[i]);
 
         // Distribution -> GLB
-        glb_tile->hierarchical_flit_down_rx[i]->bind(flit_from_dist[i]);
-        glb_tile->hierarchical_req_down_rx[i]->bind(req_from_dist[i]);
-        glb_tile->hierarchical_ack_down_rx[i]->bind(ack_to_dist[i]);
-        glb_tile->hierarchical_buffer_full_status_down_rx[i]->bind(bfs_to_dist[i]);
-
-        mock_dist[i]->flit_tx(flit_from_dist[i]);
-        sc_signal<Flit> flit_from_dram, flit_to_dram;
-        sc_signal<bool> req_from_dram, req_to_dram;
-        sc_signal<bool> ack_from_dram, ack_to_dram;
-        sc_signal<TBufferFullStatus> bfs_from_dram, bfs_to_dram;
+        glb_tile->hierarchical_link_down_rx[i]->bind(*link_from_dist[i]);
+        mock_dist[i]->link_tx(*link_from_dist[i]);
+
         // 连接DRAM节点（UP方向）
-        if (glb_tile->hierarchical_flit_up_tx != nullptr)
+        if (glb_tile->hierarchical_link_up_tx != nullptr)
         {
             MockNode *mock_dram = new MockNode("MockDRAM");
+            mock_dram->node_name = "MockDRAM";
             mock_dram->clock(clock);
             mock_dram->reset(reset);
 
-            // DRAM -> GLB
-            glb_tile->hierarchical_flit_up_rx->bind(flit_from_dram);
-            glb_tile->hierarchical_req_up_rx->bind(req_from_dram);
-            glb_tile->hierarchical_ack_up_rx->bind(ack_from_dram);
-            glb_tile->hierarchical_buffer_full_status_up_rx->bind(bfs_from_dram);
+            // UP链路按父层(DRAM)的配置
+            const LevelConfig &dram_level = GlobalParams::hierarchical_config.get_level_config(GlobalParams::node_level_map[node_id] - 1);
+            LinkChannel *link_from_dram = new LinkChannel("LinkFromDRAM");
+            LinkChannel *link_to_dram = new LinkChannel("LinkToDRAM");
+            link_from_dram->configure(dram_level.credit_flow_control, dram_level.link_latency,
+                                      GlobalParams::buffer_depth, GlobalParams::n_virtual_channels,
+                                      dram_level.bandwidth);
+            link_to_dram->configure(dram_level.credit_flow_control, dram_level.link_latency,
+                                    GlobalParams::buffer_depth, GlobalParams::n_virtual_channels,
+                                    dram_level.bandwidth);
 
-            mock_dram->flit_tx(flit_from_dram);
-            mock_dram->req_tx(req_from_dram);
-            mock_dram->ack_tx(ack_from_dram);
-            mock_dram->buffer_full_status_tx(bfs_from_dram);
+            // DRAM -> GLB
+            glb_tile->hierarchical_link_up_rx->bind(*link_from_dram);
+            mock_dram->link_tx(*link_from_dram);
 
             // GLB -> DRAM
-            glb_tile->hierarchical_flit_up_tx->bind(flit_to_dram);
-            glb_tile->hierarchical_req_up_tx->bind(req_to_dram);
-            glb_tile->hierarchical_ack_up_tx->bind(ack_from_dram);
-            glb_tile->hierarchical_buffer_full_status_up_tx->bind(bfs_to_dram);
-
-            mock_dram->flit_rx(flit_to_dram);
-            mock_dram->req_rx(req_to_dram);
-            mock_dram->ack_rx(ack_from_dram);
-            mock_dram->buffer_full_status_rx(bfs_to_dram);
+            glb_tile->hierarchical_link_up_tx->bind(*link_to_dram);
+            mock_dram->link_rx(*link_to_dram);
         }
 
         // 6. 运行仿真